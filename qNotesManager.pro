@@ -105,6 +105,7 @@ HEADERS += src/tag.h \
 	src/global.h \
 	src/boibuffer.h \
 	src/crc32.h \
+	src/hash64.h \
 	src/applicationsettings.h \
 	src/cachedfile.h \
 	src/cachedimagefile.h \
@@ -121,7 +122,19 @@ HEADERS += src/tag.h \
 	src/attachedfileswidget.h \
 	src/custommessagebox.h \
 	src/searchpanelwidget.h \
-	src/sizeeditwidget.h
+	src/sizeeditwidget.h \
+	src/searchquery.h \
+	src/quickopenindex.h \
+	src/quickopenwidget.h \
+	src/itemchangebus.h \
+	src/indexedlist.h \
+	src/tagslistmodel.h \
+	src/tagcompletermodel.h \
+	src/tagssuffixindex.h \
+	src/imagestore.h \
+	src/imagedecoder.h \
+	src/imagecache.h \
+	src/downloadscheduler.h
 
 SOURCES += src/tagownerscollection.cpp \
 	src/tag.cpp \
@@ -175,6 +188,7 @@ SOURCES += src/tagownerscollection.cpp \
 	src/documentsearchengine.cpp \
 	src/boibuffer.cpp \
 	src/crc32.cpp \
+	src/hash64.cpp \
 	src/applicationsettings.cpp \
 	src/cachedfile.cpp \
 	src/cachedimagefile.cpp \
@@ -189,6 +203,17 @@ SOURCES += src/tagownerscollection.cpp \
 	src/attachedfileswidget.cpp \
 	src/custommessagebox.cpp \
 	src/searchpanelwidget.cpp \
-	src/sizeeditwidget.cpp
+	src/sizeeditwidget.cpp \
+	src/searchquery.cpp \
+	src/quickopenindex.cpp \
+	src/quickopenwidget.cpp \
+	src/itemchangebus.cpp \
+	src/tagslistmodel.cpp \
+	src/tagcompletermodel.cpp \
+	src/tagssuffixindex.cpp \
+	src/imagestore.cpp \
+	src/imagedecoder.cpp \
+	src/imagecache.cpp \
+	src/downloadscheduler.cpp
 
 RESOURCES += icons.qrc
@@ -17,15 +17,33 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 
 #include "abstractfolderitem.h"
 #include "folder.h"
+#include "itemchangebus.h"
 #include "global.h"
 
 using namespace qNotesManager;
 
 AbstractFolderItem::AbstractFolderItem(ItemType type) : QObject(0), itemType(type) {
 	parent = 0;
+	changeBus = 0;
 }
 
 AbstractFolderItem::~AbstractFolderItem() {
+	SetChangeBus(0);
+}
+
+void AbstractFolderItem::SetChangeBus(ItemChangeBus* bus) {
+	if (changeBus == bus) {return;}
+
+	if (changeBus != 0) {
+		changeBus->Forget(this);
+	}
+	changeBus = bus;
+}
+
+// Posts item change to document's change bus
+void AbstractFolderItem::notifyChanged(int changes) {
+	if (changeBus == 0) {return;}
+	changeBus->Post(this, changes);
 }
 
 void AbstractFolderItem::SetParent(Folder* newParent) {
@@ -39,6 +57,7 @@ void AbstractFolderItem::SetParent(Folder* newParent) {
 	parent = newParent;
 	setParent(newParent);  // QObject's parentship
 	emit sg_ParentChanged(newParent);
+	notifyChanged(ItemChangeBus::ParentChanged);
 }
 
 AbstractFolderItem::ItemType AbstractFolderItem::GetItemType() const {
@@ -26,11 +26,13 @@ AbstractFolderItem is an interface for items, that Folder may contain
 
 namespace qNotesManager {
 	class Folder;
+	class ItemChangeBus;
 
 	class AbstractFolderItem : public QObject {
 	Q_OBJECT
 
 	friend class FolderItemCollection;
+	friend class Document;
 
 	public:
 		virtual ~AbstractFolderItem();
@@ -47,12 +49,16 @@ namespace qNotesManager {
 	private:
 		Folder* parent;
 		const ItemType itemType;
+		ItemChangeBus* changeBus; // set while item is registered in a document
 
 		void SetParent(Folder*);
+		void SetChangeBus(ItemChangeBus*);
 
 	protected:
 		explicit AbstractFolderItem(ItemType type); // Make it unable to create an instance of this class
 
+		void notifyChanged(int changes);
+
 	signals:
 		void sg_ParentChanged(const Folder* newParent);
 	};
@@ -17,6 +17,9 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 
 #include "application.h"
 
+#include "global.h"
+#include "imagecache.h"
+
 #include <QDir>
 #include <QPainter>
 
@@ -33,11 +36,14 @@ Application::Application() :
 		DefaultNoteIcon(":/icons/standard/Document/document.png"),
 		DefaultFolderIcon(":/icons/standard/Folder/folder.png") {
 	_currentDocument = 0;
+	GetIconIndex(QString());
 	standardIconsModel = new QStandardItemModel(this);
 
 	LoadIconsFromDir(":/icons/standard/Document");
 	LoadIconsFromDir(":/icons/standard/Folder");
 	LoadIconsFromDir(":/icons/standard/Misc");
+
+	ImageCache::I()->SetBudget(qint64(Settings.GetImageCacheSize()) * 1024 * 1024);
 }
 
 void Application::LoadIconsFromDir(const QString& dirName) {
@@ -84,6 +90,34 @@ QPixmap Application::GetStandardIcon(const QString& name)  {
 	return standardIcons.value(name);
 }
 
+// Returns small number, that identifies icon id for the whole application lifetime
+int Application::GetIconIndex(const QString& id) {
+	{
+		QReadLocker locker(&iconIDsLock);
+		QHash<QString, int>::const_iterator it = iconIndexes.constFind(id);
+		if (it != iconIndexes.constEnd()) {return it.value();}
+	}
+
+	QWriteLocker locker(&iconIDsLock);
+	QHash<QString, int>::const_iterator it = iconIndexes.constFind(id);
+	if (it != iconIndexes.constEnd()) {return it.value();} // added by another thread
+
+	const int index = iconIDs.size();
+	iconIDs.append(id);
+	iconIndexes.insert(id, index);
+	return index;
+}
+
+QString Application::GetIconID(int index) const {
+	QReadLocker locker(&iconIDsLock);
+	if (index < 0 || index >= iconIDs.size()) {
+		WARNING("Index is out of bounds");
+		return QString();
+	}
+
+	return iconIDs.at(index);
+}
+
 QPixmap Application::createImage(const QSize& size, const QString& text, bool loading) const {
 	QPainter painter;
 	const QBrush backgroundBrush {Qt::lightGray};
@@ -23,6 +23,8 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include <QPixmap>
 
 #include <QList>
+#include <QVector>
+#include <QReadWriteLock>
 #include <QStandardItemModel>
 
 #include "applicationsettings.h"
@@ -50,6 +52,11 @@ namespace qNotesManager {
 		mutable QHash<QSize, QPixmap> loadingThumbnails;
 		mutable QHash<QSize, QPixmap> errorThumbnails;
 
+		// Interned icon ids. Index 0 is empty id. Items are loaded in a worker thread, so access is locked
+		mutable QReadWriteLock iconIDsLock;
+		QHash<QString, int> iconIndexes;
+		QVector<QString> iconIDs;
+
 	public:
 		static Application* I();
 
@@ -63,6 +70,9 @@ namespace qNotesManager {
 		QPixmap GetStandardIcon(const QString& name) ;
 		QStandardItemModel* GetIconsModel();
 
+		int GetIconIndex(const QString& id);
+		QString GetIconID(int index) const;
+
 		QPixmap GetErrorImage(const QSize&) const;
 		QPixmap GetLoadingImage(const QSize&) const;
 
@@ -17,6 +17,8 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 
 #include "applicationsettings.h"
 
+#include "imagecache.h"
+
 using namespace qNotesManager;
 
 ApplicationSettings::ApplicationSettings() {
@@ -180,4 +182,13 @@ void ApplicationSettings::SetConfirmItemDeletion(bool v) {
 	settings->setValue("app/confirm/itemdeletion", v);
 }
 
+// Memory for decoded images, in megabytes
+int ApplicationSettings::GetImageCacheSize() const {
+	return settings->value("app/imagecachesize", ImageCache::DefaultBudgetMegabytes).toInt();
+}
+
+void ApplicationSettings::SetImageCacheSize(int megabytes) {
+	settings->setValue("app/imagecachesize", megabytes);
+}
+
 
@@ -90,6 +90,9 @@ namespace qNotesManager {
 		bool GetConfirmItemDeletion() const;
 		void SetConfirmItemDeletion(bool v);
 
+		int GetImageCacheSize() const;
+		void SetImageCacheSize(int megabytes);
+
 	private:
 		QSettings* settings;
 	};
@@ -18,6 +18,7 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include "applicationsettingswidget.h"
 
 #include "application.h"
+#include "imagecache.h"
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -42,6 +43,16 @@ ApplicationSettingsWidget::ApplicationSettingsWidget(QWidget *parent) : QDialog(
 	showWindowOnStartCheckbox = new QCheckBox("Show main window on start", this);
 	openLastDocumentOnStartCheckbox = new QCheckBox("Open last document on start", this);
 
+	imageCacheSizeSpinBox = new QSpinBox(this);
+	imageCacheSizeSpinBox->setRange(16, 4096);
+	imageCacheSizeSpinBox->setSuffix(" MB");
+	const ImageCache::Statistics statistics = ImageCache::I()->GetStatistics();
+	imageCacheStatisticsLabel = new QLabel(QString("Used: %1 MB, hits: %2, misses: %3, dropped: %4")
+										   .arg(statistics.UsedBytes / (1024 * 1024))
+										   .arg(statistics.Hits)
+										   .arg(statistics.Misses)
+										   .arg(statistics.Evictions), this);
+
 	okButton = new QPushButton("OK", this);
 	okButton->setDefault(true);
 	QObject::connect(okButton, SIGNAL(clicked()), this, SLOT(accept()));
@@ -53,6 +64,11 @@ ApplicationSettingsWidget::ApplicationSettingsWidget(QWidget *parent) : QDialog(
 	buttonsLayout->addWidget(cancelButton);
 	buttonsLayout->setAlignment(Qt::AlignRight);
 
+	QHBoxLayout* imageCacheLayout = new QHBoxLayout();
+	imageCacheLayout->addWidget(new QLabel("Memory for decoded images:", this));
+	imageCacheLayout->addWidget(imageCacheSizeSpinBox);
+	imageCacheLayout->addStretch();
+
 	QVBoxLayout* mainLayout = new QVBoxLayout();
 	mainLayout->addWidget(showNumberOfItemsCheckbox);
 	mainLayout->addWidget(showTagsTreeViewCheckbox);
@@ -65,6 +81,8 @@ ApplicationSettingsWidget::ApplicationSettingsWidget(QWidget *parent) : QDialog(
 	mainLayout->addWidget(createBackupsCheckbox);
 	mainLayout->addWidget(showWindowOnStartCheckbox);
 	mainLayout->addWidget(openLastDocumentOnStartCheckbox);
+	mainLayout->addLayout(imageCacheLayout);
+	mainLayout->addWidget(imageCacheStatisticsLabel);
 	mainLayout->addLayout(buttonsLayout);
 
 	showAsterixInTitleCheckbox->setVisible(false);
@@ -85,6 +103,7 @@ ApplicationSettingsWidget::ApplicationSettingsWidget(QWidget *parent) : QDialog(
 	createBackupsCheckbox->setChecked(Application::I()->Settings.GetCreateBackups());
 	showWindowOnStartCheckbox->setChecked(Application::I()->Settings.GetShowWindowOnStart());
 	openLastDocumentOnStartCheckbox->setChecked(Application::I()->Settings.GetOpenLastDocumentOnStart());
+	imageCacheSizeSpinBox->setValue(Application::I()->Settings.GetImageCacheSize());
 }
 
 void ApplicationSettingsWidget::accept() {
@@ -99,6 +118,8 @@ void ApplicationSettingsWidget::accept() {
 	Application::I()->Settings.SetCreateBackups(createBackupsCheckbox->isChecked());
 	Application::I()->Settings.SetShowWindowOnStart(showWindowOnStartCheckbox->isChecked());
 	Application::I()->Settings.SetOpenLastDocumentOnStart(openLastDocumentOnStartCheckbox->isChecked());
+	Application::I()->Settings.SetImageCacheSize(imageCacheSizeSpinBox->value());
+	ImageCache::I()->SetBudget(qint64(imageCacheSizeSpinBox->value()) * 1024 * 1024);
 
 	QDialog::accept();
 }
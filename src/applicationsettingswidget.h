@@ -21,6 +21,8 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include <QDialog>
 #include <QCheckBox>
 #include <QPushButton>
+#include <QSpinBox>
+#include <QLabel>
 
 namespace qNotesManager {
 	class ApplicationSettingsWidget : public QDialog {
@@ -38,6 +40,9 @@ namespace qNotesManager {
 		QCheckBox* showWindowOnStartCheckbox;
 		QCheckBox* openLastDocumentOnStartCheckbox;
 
+		QSpinBox* imageCacheSizeSpinBox;
+		QLabel* imageCacheStatisticsLabel;
+
 		QPushButton* okButton;
 		QPushButton* cancelButton;
 
@@ -6,6 +6,8 @@
 #include <QDebug>
 
 #include "note.h"
+#include "document.h"
+#include "application.h"
 #include "cachedfile.h"
 #include "custommessagebox.h"
 
@@ -89,7 +91,10 @@ void AttachedFilesWidget::sl_AddButton_Clicked() {
 		}
 	}
 
-	CachedFile* newFile = CachedFile::FromFile(fileName);
+	// Data of encrypted document must not be left on disk
+	const Document* document = Application::I()->CurrentDocument();
+	const bool encrypted = document && document->GetCipherID() != 0;
+	CachedFile* newFile = CachedFile::FromFile(fileName, !encrypted);
 	if (newFile == 0 || newFile->Size() == 0) {
 		CustomMessageBox msg(this, "Failed to open file", "Warning", QMessageBox::Warning);
 		msg.show();
@@ -98,11 +103,11 @@ void AttachedFilesWidget::sl_AddButton_Clicked() {
 	}
 
 	// Check if this file was already attached
-	quint32 newFileCRC = newFile->GetCRC32();
+	const quint64 newFileHash = newFile->GetHash();
 	for (int i = 0; i < currentNote->GetAttachedFilesCount(); i++) {
 		const CachedFile* file = currentNote->GetAttachedFile(i);
-		quint32 fileCRC = file->GetCRC32();
-		if (newFileCRC == fileCRC && newFile->HasSameDataAs(file)) {
+		if (newFile->Size() == file->Size() && newFileHash == file->GetHash() &&
+			newFile->HasSameDataAs(file)) {
 			CustomMessageBox msg(this, "Selected file is already attached. Proceed anyway?", "Warning",
 						   QMessageBox::Question, QMessageBox::Yes | QMessageBox::No);
 			QMessageBox::StandardButton answer = msg.show();
@@ -19,6 +19,11 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include "basemodelitem.h"
 #include "global.h"
 
+#include <QHash>
+#include <QVector>
+
+#include <algorithm>
+
 using namespace qNotesManager;
 
 BaseModel::BaseModel(QObject *parent) : QAbstractItemModel(parent) {
@@ -28,6 +33,7 @@ BaseModel::BaseModel(QObject *parent) : QAbstractItemModel(parent) {
 
 /*virtual*/
 BaseModel::~BaseModel() {
+	delete rootItem;
 }
 
 void BaseModel::SetDisplayRootItem(BaseModelItem* item) {
@@ -69,20 +75,63 @@ BaseModelItem* BaseModel::GetDisplayRootItem() const {
 void BaseModel::SetRootItem(BaseModelItem* item) {
 	if (rootItem == item) {return;}
 
-	if (rootItem) {
-		rootItem->setParent(0);
-	}
-
 	rootItem = item;
 	SetDisplayRootItem(rootItem);
+}
+
+// Replaces whole hierarchy with a single model reset. Old hierarchy is deleted
+void BaseModel::ResetRootItem(BaseModelItem* item) {
+	if (rootItem == item) {return;}
+
+	BaseModelItem* oldRootItem = rootItem;
+
+	beginResetModel();
+		rootItem = item;
+		displayRootItem = item;
+	endResetModel();
 
-	item->setParent(this); // QObject parentship
+	delete oldRootItem;
+
+	emit sg_DisplayRootItemChanged();
 }
 
 BaseModelItem* BaseModel::GetRootItem() const {
 	return rootItem;
 }
 
+// Emits dataChanged for visible items. Items with adjacent rows of the same parent are reported
+// as a single range, so views update once per range instead of once per item
+void BaseModel::EmitItemsDataChanged(const QList<BaseModelItem*>& items) {
+	if (displayRootItem == 0) {return;}
+
+	QHash<BaseModelItem*, QVector<int> > rowsByParent;
+	foreach (BaseModelItem* item, items) {
+		BaseModelItem* parentItem = item->parent();
+		if (parentItem == 0) {continue;}
+		if (parentItem != displayRootItem && !parentItem->IsOffspringOf(displayRootItem)) {continue;}
+
+		rowsByParent[parentItem].append(parentItem->IndexOfChild(item));
+	}
+
+	QHash<BaseModelItem*, QVector<int> >::iterator it = rowsByParent.begin();
+	for (; it != rowsByParent.end(); ++it) {
+		BaseModelItem* parentItem = it.key();
+		QVector<int>& rows = it.value();
+		std::sort(rows.begin(), rows.end());
+
+		int rangeStart = 0;
+		for (int i = 1; i <= rows.size(); ++i) {
+			if (i < rows.size() && rows.at(i) <= rows.at(i - 1) + 1) {continue;}
+
+			const int firstRow = rows.at(rangeStart);
+			const int lastRow = rows.at(i - 1);
+			emit dataChanged(createIndex(firstRow, 0, parentItem->ChildAt(firstRow)),
+							 createIndex(lastRow, 0, parentItem->ChildAt(lastRow)));
+			rangeStart = i;
+		}
+	}
+}
+
 /*virtual*/
 QModelIndex BaseModel::index(int row, int column, const QModelIndex& parent) const {
 	if (!hasIndex(row, column, parent)) {
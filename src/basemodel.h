@@ -34,7 +34,9 @@ namespace qNotesManager {
 		void SetDisplayRootItem(BaseModelItem*);
 		BaseModelItem* GetDisplayRootItem() const;
 		void SetRootItem(BaseModelItem*);
+		void ResetRootItem(BaseModelItem*);
 		BaseModelItem* GetRootItem() const;
+		void EmitItemsDataChanged(const QList<BaseModelItem*>&);
 
 	public:
 		explicit BaseModel(QObject *parent = 0);
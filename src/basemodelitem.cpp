@@ -25,7 +25,9 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 using namespace qNotesManager;
 
 BaseModelItem::BaseModelItem(ItemType type)
-	: itemType(type)
+	: itemType(type),
+	  row(-1),
+	  firstStaleRow(0)
 {
 	parentItem = 0;
 	sorted = false;
@@ -33,6 +35,7 @@ BaseModelItem::BaseModelItem(ItemType type)
 }
 
 BaseModelItem::~BaseModelItem() {
+	qDeleteAll(childrenList);
 }
 
 // Return item parent or 0 if there is none.
@@ -62,10 +65,6 @@ void BaseModelItem::AddChildTo(BaseModelItem* item, int position) {
 		WARNING("Item already has a parent");
 		return;
 	}
-	if (childrenList.contains(item)) {
-		WARNING("Item is already in the list");
-		return;
-	}
 	if (position < 0 || position > childrenList.size()) {
 		WARNING("Wrong position");
 		return;
@@ -73,7 +72,10 @@ void BaseModelItem::AddChildTo(BaseModelItem* item, int position) {
 
 	childrenList.insert(position, item);
 	item->parentItem = this;
-	item->setParent(this); // QObject parentship
+	item->row = position;
+	if (position < childrenList.size() - 1) {
+		firstStaleRow = qMin(firstStaleRow, position);
+	}
 	insertIndexCache.Clear();
 }
 
@@ -83,14 +85,16 @@ void BaseModelItem::RemoveChild(BaseModelItem* item) {
 		WARNING("Null pointer recieved");
 		return;
 	}
-	if (!childrenList.contains(item)) {
+	if (item->parentItem != this) {
 		WARNING("Item is not in the list");
 		return;
 	}
 
-	childrenList.removeAll(item);
+	const int index = IndexOfChild(item);
+	childrenList.removeAt(index);
+	firstStaleRow = qMin(firstStaleRow, index);
 	item->parentItem = 0;
-	item->setParent(0); // QObject parentship
+	item->row = -1;
 	insertIndexCache.Clear();
 }
 
@@ -100,12 +104,24 @@ int BaseModelItem::IndexOfChild(BaseModelItem* item) const {
 		WARNING("Null pointer recieved");
 		return -1;
 	}
-	if (!childrenList.contains(item)) {
+	if (item->parentItem != this) {
 		WARNING("Item is not in the list");
 		return -1;
 	}
 
-	return childrenList.indexOf(item);
+	if (item->row >= firstStaleRow) {
+		updateRows();
+	}
+
+	return item->row;
+}
+
+// Renumbers children, whose rows were shifted by insertion or removal
+void BaseModelItem::updateRows() const {
+	for (int i = firstStaleRow; i < childrenList.size(); ++i) {
+		childrenList.at(i)->row = i;
+	}
+	firstStaleRow = childrenList.size();
 }
 
 // Returns children count
@@ -125,6 +141,7 @@ BaseModelItem* BaseModelItem::ChildAt(int index) const {
 
 void BaseModelItem::ClearChildrenList() {
 	childrenList.clear();
+	firstStaleRow = 0;
 	insertIndexCache.Clear();
 }
 
@@ -22,14 +22,14 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include <QVariant>
 
 /*
-  Base class for all model items
+  Base class for all model items. Items are plain objects owned by their parent item, changes of
+  underlying data are delivered to models by document's ItemChangeBus
 */
 
 namespace qNotesManager {
 	class BaseModel;
 
-	class BaseModelItem : public QObject {
-	Q_OBJECT
+	class BaseModelItem {
 	public:
 		enum ItemType {
 			note,
@@ -54,6 +54,13 @@ namespace qNotesManager {
 		QList<BaseModelItem*>	childrenList;
 		const ItemType	itemType;
 
+		// Row of this item in parent's children list. Rows of parent's children starting from
+		// parent's firstStaleRow are outdated and renumbered on next IndexOfChild() call
+		int row;
+		mutable int firstStaleRow;
+
+		void updateRows() const;
+
 		bool sorted;
 		Qt::SortOrder sortOrder;
 
@@ -77,6 +84,9 @@ namespace qNotesManager {
 		explicit BaseModelItem(ItemType type = Null);
 		virtual ~BaseModelItem();
 
+		BaseModelItem(const BaseModelItem&) = delete;
+		BaseModelItem& operator=(const BaseModelItem&) = delete;
+
 		ItemType DataType() const;
 
 		virtual QVariant data(int role) const;
@@ -104,9 +114,6 @@ namespace qNotesManager {
 		void SetSortOrder(const Qt::SortOrder);
 
 		//void* StoredData;
-
-	signals:
-		void sg_DataChanged(BaseModelItem*);
 	};
 }
 
@@ -18,41 +18,277 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include "cachedfile.h"
 
 #include "crc32.h"
+#include "hash64.h"
+#include "boibuffer.h"
 
 #include <QFile>
 #include <QFileInfo>
+#include <QDir>
+#include <QBuffer>
 #include <QTemporaryFile>
 #include <QCryptographicHash>
+#include <QCoreApplication>
+#include <QDateTime>
+#if QT_VERSION >= 0x050100
+#include <QLockFile>
+#endif
 
 using namespace qNotesManager;
 
+namespace {
+	QString storageRoot() {
+		return QDir::tempPath() + "/qNotesManager_storage";
+	}
+
+	QString sessionName() {
+		return QString::number(QCoreApplication::applicationPid());
+	}
+
+	void removeDirectory(const QString& path) {
+		QDir dir(path);
+		foreach (const QFileInfo& info, dir.entryInfoList(QDir::Files | QDir::Hidden | QDir::System)) {
+			QFile::remove(info.absoluteFilePath());
+		}
+		dir.rmdir(path);
+	}
+
+#if QT_VERSION >= 0x050100
+	// Held while the session runs, a session whose lock can be taken has finished or crashed
+	QLockFile* sessionLock() {
+		static QLockFile lock(storageRoot() + "/" + sessionName() + ".lock");
+		return &lock;
+	}
+#endif
+}
+
 CachedFile::CachedFile(const QByteArray& array, const QString& name) :
 	cachedCrc32(0),
+	cachedHash(0),
+	hashComputed(false),
 	cachedMD5(QString()),
+	storageFileSize(0),
 	Data(array),
 	FileName(name) {
 }
 
+// Every copy owns its own storage file
+CachedFile::CachedFile(const CachedFile& other) :
+	cachedCrc32(other.cachedCrc32),
+	cachedHash(other.cachedHash),
+	hashComputed(other.hashComputed),
+	cachedMD5(other.cachedMD5),
+	storageFileSize(0),
+	Data(other.Data),
+	FileName(other.FileName) {
+
+	if (other.storageFileName.isEmpty()) {return;}
+
+	QIODevice* source = other.openData();
+	if (source && createStorageFile(source, other.storageFileSize, storageFileName)) {
+		storageFileSize = other.storageFileSize;
+	} else if (source) {
+		source->seek(0);
+		Data = source->readAll();
+	}
+	delete source;
+}
+
+CachedFile::~CachedFile() {
+	if (!storageFileName.isEmpty()) {
+		QFile::remove(storageFileName);
+	}
+}
+
+// Returns opened device with file data, caller deletes it
+QIODevice* CachedFile::openData() const {
+	if (storageFileName.isEmpty()) {
+		QBuffer* buffer = new QBuffer();
+		buffer->setData(Data);
+		buffer->open(QIODevice::ReadOnly);
+		return buffer;
+	}
+
+	QFile* file = new QFile(storageFileName);
+	if (!file->open(QIODevice::ReadOnly)) {
+		delete file;
+		return 0;
+	}
+	return file;
+}
+
+bool CachedFile::writeToDevice(QIODevice* device) const {
+	if (storageFileName.isEmpty()) {
+		return device->write(Data) == Data.size();
+	}
+
+	QFile file(storageFileName);
+	if (!file.open(QIODevice::ReadOnly)) {return false;}
+
+	QByteArray chunk(int(ChunkSize), 0x0);
+	qint64 bytesLeft = storageFileSize;
+	while (bytesLeft > 0) {
+		const qint64 read = file.read(chunk.data(), qMin(bytesLeft, ChunkSize));
+		if (read <= 0 || device->write(chunk.constData(), read) != read) {return false;}
+		bytesLeft -= read;
+	}
+	return true;
+}
+
+// Copies 'size' bytes from 'source' to a new temporary file
+/*static*/
+bool CachedFile::createStorageFile(QIODevice* source, qint64 size, QString& storageName) {
+	QTemporaryFile storage(storageFileTemplate());
+	storage.setAutoRemove(false);
+	if (!storage.open()) {return false;}
+
+	QByteArray chunk(int(ChunkSize), 0x0);
+	qint64 bytesLeft = size;
+	while (bytesLeft > 0) {
+		const qint64 read = source->read(chunk.data(), qMin(bytesLeft, ChunkSize));
+		if (read <= 0 || storage.write(chunk.constData(), read) != read) {
+			storage.remove();
+			return false;
+		}
+		bytesLeft -= read;
+	}
+	if (!storage.flush()) {
+		storage.remove();
+		return false;
+	}
+
+	storageName = storage.fileName();
+	return true;
+}
+
+/*static*/
+QString CachedFile::storageFileTemplate() {
+	return storageRoot() + "/" + sessionName() + "/XXXXXX.attachment";
+}
+
+// Removes storage directories left by sessions that were not finished properly and creates one
+// for this session. Must be called on start, before any file is created
+/*static*/
+void CachedFile::InitStorage() {
+	QDir root(storageRoot());
+	if (!root.exists() && !root.mkpath(".")) {return;}
+
+	foreach (const QString& name, root.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+		if (name == sessionName()) { // left by a finished session with the same id
+			removeDirectory(root.filePath(name));
+			continue;
+		}
+#if QT_VERSION >= 0x050100
+		QLockFile lock(root.filePath(name + ".lock"));
+		lock.setStaleLockTime(0);
+		if (lock.tryLock(0)) {
+			removeDirectory(root.filePath(name));
+			lock.unlock();
+		}
+#else
+		// Running session changes its directory when files are attached, old ones are left over
+		const QFileInfo info(root.filePath(name));
+		if (info.lastModified().daysTo(QDateTime::currentDateTime()) > 7) {
+			removeDirectory(info.absoluteFilePath());
+		}
+#endif
+	}
+
+#if QT_VERSION >= 0x050100
+	sessionLock()->setStaleLockTime(0);
+	sessionLock()->tryLock(0);
+#endif
+	root.mkdir(sessionName());
+}
+
+/*static*/
+void CachedFile::ClearStorage() {
+	removeDirectory(storageRoot() + "/" + sessionName());
+#if QT_VERSION >= 0x050100
+	sessionLock()->unlock();
+#endif
+}
+
+// CRC32 is needed only to resolve image names of version 1 files, use GetHash to compare data
 quint32 CachedFile::GetCRC32() const {
 	if (cachedCrc32 == 0) {
-		cachedCrc32 = crc32buf(Data.constData(), Data.length());
+		if (storageFileName.isEmpty()) {
+			cachedCrc32 = crc32buf(Data.constData(), Data.length());
+			return cachedCrc32;
+		}
+
+		QIODevice* device = openData();
+		if (!device) {return 0;}
+		quint32 crc = 0xFFFFFFFF;
+		QByteArray chunk(int(ChunkSize), 0x0);
+		qint64 read = 0;
+		while ((read = device->read(chunk.data(), ChunkSize)) > 0) {
+			crc = crc32update(crc, chunk.constData(), read);
+		}
+		delete device;
+		cachedCrc32 = ~crc;
 	}
 	return cachedCrc32;
 }
 
+// Fast hash of the data, identifies file contents in memory. Equal hashes do not guarantee equal
+// data, check it with HasSameDataAs
+quint64 CachedFile::GetHash() const {
+	if (!hashComputed) {
+		if (storageFileName.isEmpty()) {
+			cachedHash = Hash64::Of(Data.constData(), Data.size());
+		} else {
+			QIODevice* device = openData();
+			if (!device) {return 0;}
+			Hash64 hash;
+			QByteArray chunk(int(ChunkSize), 0x0);
+			qint64 read = 0;
+			while ((read = device->read(chunk.data(), ChunkSize)) > 0) {
+				hash.Add(chunk.constData(), read);
+			}
+			delete device;
+			cachedHash = hash.Result();
+		}
+		hashComputed = true;
+	}
+	return cachedHash;
+}
+
+// MD5 is a stable name of the data: notes refer to images and icons by it
 QString CachedFile::GetMD5() const {
 	if (cachedMD5.isEmpty()) {
 		QCryptographicHash hash(QCryptographicHash::Md5);
-		hash.addData(Data);
+		if (storageFileName.isEmpty()) {
+			hash.addData(Data);
+		} else {
+			QIODevice* device = openData();
+			if (!device) {return QString();}
+			QByteArray chunk(int(ChunkSize), 0x0);
+			qint64 read = 0;
+			while ((read = device->read(chunk.data(), ChunkSize)) > 0) {
+				hash.addData(chunk.constData(), int(read));
+			}
+			delete device;
+		}
 		cachedMD5 = QString(hash.result().toHex());
 	}
 	return cachedMD5;
 }
 
+// Checksums read from document file are set here, so they are not computed on loading
+void CachedFile::SetHash(quint64 hash) {
+	cachedHash = hash;
+	hashComputed = true;
+}
+
+void CachedFile::SetMD5(const QString& md5) {
+	cachedMD5 = md5;
+}
+
 int CachedFile::Size() const {
-	return Data.size();
+	return storageFileName.isEmpty() ? Data.size() : int(storageFileSize);
 }
 
+// Only data kept in memory is available here, stored files are read with WriteTo or Save
 const char* CachedFile::GetData() const {
 	return Data.constData();
 }
@@ -61,8 +297,58 @@ QString CachedFile::GetFileName() const {
 	return FileName;
 }
 
+bool CachedFile::IsStoredInFile() const {
+	return !storageFileName.isEmpty();
+}
+
+bool CachedFile::WriteTo(BOIBuffer& buffer) const {
+	if (storageFileName.isEmpty()) {
+		return buffer.write(Data.constData(), Data.size()) == Data.size();
+	}
+
+	QFile file(storageFileName);
+	if (!file.open(QIODevice::ReadOnly)) {return false;}
+
+	QByteArray chunk(int(ChunkSize), 0x0);
+	qint64 bytesLeft = storageFileSize;
+	while (bytesLeft > 0) {
+		const qint64 read = file.read(chunk.data(), qMin(bytesLeft, ChunkSize));
+		if (read <= 0 || buffer.write(chunk.constData(), read) != read) {return false;}
+		bytesLeft -= read;
+	}
+	return true;
+}
+
+// Moves data from storage file to memory. Is used when the document gets encrypted
+bool CachedFile::KeepInMemory() {
+	if (storageFileName.isEmpty()) {return true;}
+
+	QByteArray array;
+	if (!ReadFile(storageFileName, array) || array.size() != storageFileSize) {return false;}
+
+	QFile::remove(storageFileName);
+	storageFileName.clear();
+	storageFileSize = 0;
+	Data = array;
+	return true;
+}
+
 bool CachedFile::HasSameDataAs(const CachedFile* other) const {
-	return Data == other->Data;
+	if (storageFileName.isEmpty() && other->storageFileName.isEmpty()) {
+		return Data == other->Data;
+	}
+	if (Size() != other->Size()) {return false;}
+
+	QIODevice* device = openData();
+	QIODevice* otherDevice = other->openData();
+	bool same = device && otherDevice;
+	while (same && !device->atEnd()) {
+		const QByteArray chunk = device->read(ChunkSize);
+		same = !chunk.isEmpty() && chunk == otherDevice->read(chunk.size());
+	}
+	delete device;
+	delete otherDevice;
+	return same;
 }
 
 bool CachedFile::Save(const QString& fileName) const {
@@ -70,48 +356,128 @@ bool CachedFile::Save(const QString& fileName) const {
 		return false;
 	}
 
-	if (Data.size() == 0) {return false;}
+	if (Size() == 0) {return false;}
 
 	QFile file(fileName);
 
 	if (!file.open(QIODevice::WriteOnly)) {return false;}
-	qint64 result = file.write(Data);
+	const bool result = writeToDevice(&file);
 	file.close();
 
-	if (result != Data.size()) {return false;}
-
-	return true;
+	return result;
 }
 
 QString CachedFile::SaveToTempFolder() const {
-	if (Data.size() == 0) {return QString();}
+	if (Size() == 0) {return QString();}
 
 	QTemporaryFile file;
 	file.setAutoRemove(false);
 
 	if (!file.open()) {return QString();}
-	qint64 result = file.write(Data);
+	const bool result = writeToDevice(&file);
 	file.close();
 
-	if (result != Data.size()) {return QString();}
+	if (!result) {return QString();}
 
 	return file.fileName();
 }
 
+// Attached file is copied to a storage file chunk by chunk and is not loaded into memory, unless
+// 'useStorage' is false
+// static
+CachedFile* CachedFile::FromFile(const QString& fileName, bool useStorage) {
+	QFile source(fileName);
+	if (!source.exists() || !source.open(QIODevice::ReadOnly)) {return 0;}
+
+	if (useStorage) {
+		CachedFile* file = new CachedFile(QByteArray(), QFileInfo(fileName).fileName());
+		if (createStorageFile(&source, source.size(), file->storageFileName)) {
+			file->storageFileSize = source.size();
+			return file;
+		}
+		// No place for storage file, keep data in memory
+		delete file;
+	}
+	source.close();
+
+	QByteArray array;
+	if (!ReadFile(fileName, array)) {return 0;}
+
+	return new CachedFile(array, QFileInfo(fileName).fileName());
+}
+
+// Reads 'size' bytes of attached file from document buffer into a storage file. If 'useStorage' is
+// false or the storage file cannot be written, data is kept in memory
 // static
-CachedFile* CachedFile::FromFile(const QString& fileName) {
+CachedFile* CachedFile::FromBuffer(BOIBuffer& buffer, qint64 size, const QString& name,
+								   bool useStorage) {
+	CachedFile* file = new CachedFile(QByteArray(), name);
+	const qint64 dataStart = buffer.pos();
+
+	QTemporaryFile storage(storageFileTemplate());
+	storage.setAutoRemove(false);
+	if (useStorage && storage.open()) {
+		QByteArray chunk(int(ChunkSize), 0x0);
+		qint64 bytesLeft = size;
+		bool written = true;
+		while (bytesLeft > 0) {
+			const qint64 read = buffer.read(chunk.data(), qMin(bytesLeft, ChunkSize));
+			if (read <= 0) {break;}
+			if (storage.write(chunk.constData(), read) != read) {
+				written = false;
+				break;
+			}
+			bytesLeft -= read;
+		}
+
+		if (written && storage.flush()) {
+			file->storageFileName = storage.fileName();
+			file->storageFileSize = size - bytesLeft;
+			return file;
+		}
+
+		storage.remove();
+		buffer.seek(dataStart);
+	}
+
+	file->Data.resize(int(size));
+	const qint64 read = buffer.read(file->Data.data(), size);
+	if (read < size) {file->Data.resize(int(qMax(read, qint64(0))));}
+	return file;
+}
+
+// Reads whole file into 'data' with a single allocation. Big files are memory-mapped and copied,
+// so they don't have to go through QIODevice buffers. Is safe to call from any thread
+// static
+bool CachedFile::ReadFile(const QString& fileName, QByteArray& data) {
 	QFile file(fileName);
 
 	if (!file.exists()) {
-		return 0;
+		return false;
 	}
 
-	if (!file.open(QIODevice::ReadOnly)) {return 0;}
+	if (!file.open(QIODevice::ReadOnly)) {return false;}
 
-	QByteArray array = file.readAll();
-	file.close();
+	const qint64 size = file.size();
+	if (size >= MapFileThreshold) {
+		uchar* mapped = file.map(0, size);
+		if (mapped) {
+			data = QByteArray(reinterpret_cast<const char*>(mapped), int(size));
+			file.unmap(mapped);
+			return true;
+		}
+	}
 
-	QFileInfo fileInfo(file);
+	if (size > 0) {
+		data.resize(int(size));
+		const qint64 read = file.read(data.data(), size);
+		if (read != size) {
+			data.clear();
+			return false;
+		}
+	} else {
+		data = file.readAll(); // sequential files have no size
+	}
 
-	return new CachedFile(array, fileInfo.fileName());
+	return true;
 }
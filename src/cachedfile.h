@@ -21,33 +21,73 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include <QString>
 #include <QByteArray>
 
+class QIODevice;
+
+/*
+  CachedFile is a file kept by the document: note attachment or image. Its data is either held in
+  memory or, for attachments, in a temporary storage file, so big attachments cost no memory until
+  they are used. Stored data is always read and written in chunks.
+  Storage files are kept in a directory of the running session. Attachments of encrypted documents
+  are never stored in files, so their data is not left on disk unencrypted.
+*/
+
 namespace qNotesManager {
+	class BOIBuffer;
+
 	class CachedFile {
 	private:
+		static const qint64 MapFileThreshold = 1024 * 1024; // bigger files are read with mapping
+		static const qint64 ChunkSize = 64 * 1024;
 		mutable quint32 cachedCrc32;
+		mutable quint64 cachedHash;
+		mutable bool hashComputed;
 		mutable QString cachedMD5;
 
+		QString storageFileName; // temporary file with data, empty if data is in memory
+		qint64 storageFileSize;
+
+		QIODevice* openData() const;
+		bool writeToDevice(QIODevice* device) const;
+		static bool createStorageFile(QIODevice* source, qint64 size, QString& storageName);
+		static QString storageFileTemplate();
+
 	protected:
 		QByteArray Data;
 		QString FileName;
 
+		CachedFile(const CachedFile& other);
+
 	public:
 		explicit CachedFile(const QByteArray& array, const QString& name);
-		virtual ~CachedFile() {}
+		CachedFile& operator=(const CachedFile&) = delete;
+		virtual ~CachedFile();
 
 		quint32 GetCRC32() const;
+		quint64 GetHash() const;
 		QString GetMD5() const;
+		void SetHash(quint64 hash);
+		void SetMD5(const QString& md5);
 		int Size() const;
 
 		const char* GetData() const;
 		QString GetFileName() const;
 
+		bool IsStoredInFile() const;
+		bool WriteTo(BOIBuffer& buffer) const;
+		bool KeepInMemory();
+
 		bool HasSameDataAs(const CachedFile* other) const;
 
 		bool Save(const QString& fileName) const;
 		QString SaveToTempFolder() const;
 
-		static CachedFile* FromFile(const QString& fileName);
+		static CachedFile* FromFile(const QString& fileName, bool useStorage = true);
+		static CachedFile* FromBuffer(BOIBuffer& buffer, qint64 size, const QString& name,
+									  bool useStorage = true);
+		static bool ReadFile(const QString& fileName, QByteArray& data);
+
+		static void InitStorage();
+		static void ClearStorage();
 	};
 }
 
@@ -17,22 +17,36 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 
 #include "cachedimagefile.h"
 
+#include "imagecache.h"
+
 #include <QFile>
 #include <QFileInfo>
+#include <QBuffer>
+#include <QImageReader>
 
 using namespace qNotesManager;
 
 CachedImageFile::CachedImageFile(const QByteArray& array, const QString& name, const QString& format) :
 		CachedFile(array, name),
-		cachedPixmapSize(QSize()),
 		cachedPixmap(0),
 		cachePixmapInitialized(false),
 		Format(format) {
 
 }
 
+// Copies encoded data and checksums, decoded pixmaps are not shared
+CachedImageFile::CachedImageFile(const CachedImageFile& other) :
+		CachedFile(other),
+		cachedPixmap(0),
+		cachePixmapInitialized(false),
+		imageSize(other.imageSize),
+		Format(other.Format) {
+
+}
+
 CachedImageFile::~CachedImageFile() {
 	if (cachedPixmap) {
+		ImageCache::I()->Remove(this);
 		delete cachedPixmap;
 	}
 }
@@ -42,48 +56,131 @@ void CachedImageFile::initCachePixmap() const {
 
 	cachedPixmap = new QPixmap();
 	cachedPixmap->loadFromData(Data, Format.toStdString().c_str());
-	cachedPixmapSize = cachedPixmap->size();
 
 	cachePixmapInitialized = true;
+	ImageCache::I()->Insert(const_cast<CachedImageFile*>(this), decodedBytes());
+}
+
+qint64 CachedImageFile::decodedBytes() const {
+	qint64 bytes = 0;
+	if (cachedPixmap) {
+		bytes += qint64(cachedPixmap->width()) * cachedPixmap->height() * 4;
+	}
+	foreach (const ScaledPixmap& scaled, scaledPixmaps) {
+		bytes += qint64(scaled.first.width()) * scaled.first.height() * 4;
+	}
+	return bytes;
+}
+
+// Called by ImageCache when memory is needed. Encoded data is kept, image will be decoded again
+void CachedImageFile::releasePixmaps() {
+	if (!cachePixmapInitialized) {return;}
+
+	if (!cachedPixmap->isNull()) {imageSize = cachedPixmap->size();}
+	delete cachedPixmap;
+	cachedPixmap = 0;
+	scaledPixmaps.clear();
+	cachePixmapInitialized = false;
 }
 
 QString CachedImageFile::GetFormat() const {
 	return Format;
 }
 
+QByteArray CachedImageFile::GetEncodedData() const {
+	return Data;
+}
+
+// Checks image header only, image is not decoded here
 bool CachedImageFile::IsValidImage() const {
-	if (!cachePixmapInitialized) {initCachePixmap();}
+	if (cachePixmapInitialized) {return !cachedPixmap->isNull();}
 
-	return !cachedPixmap->isNull();
+	return ImageSize().isValid();
 }
 
 QSize CachedImageFile::ImageSize() const {
-	if (!cachePixmapInitialized) {initCachePixmap();}
-	return cachedPixmap->isNull() ? QSize() : cachedPixmap->size();
+	if (cachePixmapInitialized) {
+		return cachedPixmap->isNull() ? QSize() : cachedPixmap->size();
+	}
+	if (!imageSize.isValid()) {imageSize = readImageSize();}
+	return imageSize;
 }
 
-QPixmap CachedImageFile::GetPixmap(const QSize& preferredSize) const {
-	if (!cachePixmapInitialized) {initCachePixmap();}
+QSize CachedImageFile::readImageSize() const {
+	QByteArray data = Data;
+	QBuffer buffer(&data);
+	QImageReader reader(&buffer, Format.toLatin1());
+	if (!reader.canRead()) {return QSize();}
 
-	if (preferredSize.isValid() && preferredSize != cachedPixmapSize) {
-		*cachedPixmap = cachedPixmap->scaled(preferredSize, Qt::IgnoreAspectRatio, Qt::FastTransformation);
-		cachedPixmapSize = preferredSize;
-	}
+	const QSize size = reader.size();
+	if (size.isValid()) {return size;}
 
-	return *cachedPixmap;
+	// Format can't tell its size without decoding
+	const QImage image = reader.read();
+	return image.isNull() ? QSize() : image.size();
 }
 
-CachedImageFile* CachedImageFile::FromFile(const QString& fileName) {
-	QFile file(fileName);
+bool CachedImageFile::IsDecoded() const {
+	return cachePixmapInitialized;
+}
+
+// Sets pixmap decoded by ImageDecoder. Must be called from GUI thread
+void CachedImageFile::SetDecodedImage(const QImage& image) {
+	if (cachePixmapInitialized) {return;}
+
+	cachedPixmap = new QPixmap(QPixmap::fromImage(image));
+	cachePixmapInitialized = true;
+	ImageCache::I()->Insert(this, decodedBytes());
+}
+
+// Decodes image data into QImage. Doesn't touch any CachedImageFile, so may be called from any thread
+/*static*/
+QImage CachedImageFile::DecodeImage(const QByteArray& data, const QString& format) {
+	QImage image;
+	image.loadFromData(data, format.toStdString().c_str());
+	return image;
+}
 
-	if (!file.exists()) {
-		return 0;
+QPixmap CachedImageFile::GetPixmap(const QSize& preferredSize) const {
+	if (cachePixmapInitialized) {
+		ImageCache::I()->Touch(const_cast<CachedImageFile*>(this));
+	} else {
+		initCachePixmap();
 	}
 
-	if (!file.open(QIODevice::ReadOnly)) {return 0;}
+	if (!preferredSize.isValid() || preferredSize == cachedPixmap->size() || cachedPixmap->isNull()) {
+		return *cachedPixmap;
+	}
 
-	QByteArray array = file.readAll();
-	file.close();
+	for (int i = 0; i < scaledPixmaps.size(); ++i) {
+		if (scaledPixmaps.at(i).first == preferredSize) {
+			if (i > 0) {scaledPixmaps.move(i, 0);}
+			return scaledPixmaps.first().second;
+		}
+	}
+
+	const QPixmap scaled = cachedPixmap->scaled(preferredSize, Qt::IgnoreAspectRatio,
+												Qt::SmoothTransformation);
+	scaledPixmaps.prepend(qMakePair(preferredSize, scaled));
+
+	// Drop least recently used copies, but keep the one just made
+	int bytes = 0;
+	for (int i = 0; i < scaledPixmaps.size(); ++i) {
+		const QSize size = scaledPixmaps.at(i).first;
+		bytes += size.width() * size.height() * 4;
+		if (i > 0 && (i >= MaxScaledPixmaps || bytes > MaxScaledPixmapsBytes)) {
+			scaledPixmaps.erase(scaledPixmaps.begin() + i, scaledPixmaps.end());
+			break;
+		}
+	}
+	ImageCache::I()->Insert(const_cast<CachedImageFile*>(this), decodedBytes());
+
+	return scaled;
+}
+
+CachedImageFile* CachedImageFile::FromFile(const QString& fileName) {
+	QByteArray array;
+	if (!ReadFile(fileName, array)) {return 0;}
 
 	return new CachedImageFile(array, QFileInfo(fileName).fileName(), QFileInfo(fileName).suffix());
 }
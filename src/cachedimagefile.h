@@ -23,27 +23,48 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include <QSize>
 #include <QImage>
 #include <QPixmap>
+#include <QList>
+#include <QPair>
 
 namespace qNotesManager {
 	class CachedImageFile : public CachedFile {
 	private:
-		mutable QSize cachedPixmapSize;
-		mutable QPixmap* cachedPixmap;
+		mutable QPixmap* cachedPixmap; // decoded image in original size
 		mutable bool cachePixmapInitialized;
+		mutable QSize imageSize; // read from image header, so size is known before decoding
 		void initCachePixmap() const;
+		QSize readImageSize() const;
+		qint64 decodedBytes() const;
+		void releasePixmaps();
+		friend class ImageCache;
+
+		// Scaled copies of image, most recently used first. Encoded data stays the source of truth,
+		// scaled copies are always made from original size pixmap
+		typedef QPair<QSize, QPixmap> ScaledPixmap;
+		mutable QList<ScaledPixmap> scaledPixmaps;
+		static const int MaxScaledPixmaps = 4;
+		static const int MaxScaledPixmapsBytes = 4 * 1024 * 1024;
 
 		QString Format;
 
 	public:
 		CachedImageFile(const QByteArray& array, const QString& name, const QString& format);
+		CachedImageFile(const CachedImageFile& other);
+		CachedImageFile& operator=(const CachedImageFile&) = delete;
 		~CachedImageFile();
 
 		QString GetFormat() const;
 
+		QByteArray GetEncodedData() const;
+
 		bool IsValidImage() const;
 		QSize ImageSize() const;
 		QPixmap GetPixmap(const QSize& preferredSize = QSize()) const;
 
+		bool IsDecoded() const;
+		void SetDecodedImage(const QImage& image);
+		static QImage DecodeImage(const QByteArray& data, const QString& format);
+
 		static CachedImageFile* FromFile(const QString& fileName);
 	};
 }
@@ -116,13 +116,14 @@ quint32 updateCRC32(char ch, quint32 crc) {
 }
 
 quint32 crc32buf(const char *buf, size_t len) {
-	register quint32 oldcrc32;
-
-	oldcrc32 = 0xFFFFFFFF;
+	return ~crc32update(0xFFFFFFFF, buf, len);
+}
 
+/* Continues crc calculation for data read in chunks. Start with 0xFFFFFFFF, invert the result */
+quint32 crc32update(quint32 crc, const char *buf, size_t len) {
 	for ( ; len; --len, ++buf) {
-		oldcrc32 = updateCRC32(*buf, oldcrc32);
+		crc = updateCRC32(*buf, crc);
 	}
 
-	return ~oldcrc32;
+	return crc;
 }
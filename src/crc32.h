@@ -10,6 +10,7 @@
 
 quint32 updateCRC32(unsigned char ch, quint32 crc);
 quint32 crc32buf(const char *buf, size_t len);
+quint32 crc32update(quint32 crc, const char *buf, size_t len);
 
 
 
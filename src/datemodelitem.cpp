@@ -28,7 +28,8 @@ using namespace qNotesManager;
 DateModelItem::DateModelItem(DateComponent c, int v) :
 		BaseModelItem(BaseModelItem::date),
 		value(v),
-		component(c) {
+		component(c),
+		notesCount(0) {
 	if (value < 0) {value = 0;}
 	if (component == Month && value > 11) {value = 11;}
 }
@@ -38,7 +39,7 @@ QVariant DateModelItem::data(int role) const {
 	if (role == Qt::DecorationRole) {
 		return QIcon(":/gui/date");
 	} else if (role == Qt::DisplayRole) {
-		QString childrenCount = QString(" (%1)").arg(QString::number(ChildrenCount()));
+		QString childrenCount = QString(" (%1)").arg(QString::number(notesCount));
 		QString returnValue = "";
 		switch (component) {
 			case Year:
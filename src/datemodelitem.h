@@ -37,6 +37,7 @@ namespace qNotesManager {
 
 		int value;
 		DateComponent component;
+		int notesCount; // notes of this date, children are created only when item is expanded
 	};
 }
 
@@ -36,6 +36,7 @@ DateNavigationWidget::DateNavigationWidget(QWidget *parent) : QWidget(parent) {
 	textDateModel = 0;
 
 	treeView = new QTreeView();
+	treeView->setUniformRowHeights(true);
 	treeView->setHeaderHidden(true);
 	treeView->setEditTriggers(QAbstractItemView::SelectedClicked | QAbstractItemView::EditKeyPressed);
 
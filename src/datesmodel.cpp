@@ -24,12 +24,18 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include "global.h"
 
 #include <QDebug>
+#include <QVector>
+#include <QPair>
+
+#include <algorithm>
 
 using namespace qNotesManager;
 
 DatesModel::DatesModel(LookupField field, Document* doc) :
 		BaseModel(doc),
-		lookupField(field) {
+		lookupField(field),
+		document(doc),
+		bulkUpdate(false) {
 	BaseModelItem* root = new BaseModelItem();
 	root->SetSorted(true);
 	SetRootItem(root);
@@ -39,307 +45,361 @@ DatesModel::DatesModel(LookupField field, Document* doc) :
 					 this, SLOT(sl_NoteRegistered(Note*)));
 	QObject::connect(doc, SIGNAL(sg_ItemUnregistered(Note*)),
 					 this, SLOT(sl_NoteUnregistered(Note*)));
+	QObject::connect(doc->GetChangeBus(), SIGNAL(sg_ItemsChanged(const ItemChanges&)),
+					 this, SLOT(sl_ChangeBus_ItemsChanged(const ItemChanges&)));
 
 	const QList<Note*> notes = doc->GetNotesList();
+	if (notes.isEmpty()) {return;}
+
+	BeginBulkUpdate();
 	foreach (Note* n, notes) {
 		sl_NoteRegistered(n);
 	}
+	EndBulkUpdate();
 }
 
-void DatesModel::sl_Item_DataChanged(BaseModelItem* item) {
-	QModelIndex noteItemIndex = createIndex(item->parent()->IndexOfChild(item), 0, item);
-	emit dataChanged(noteItemIndex, noteItemIndex);
+// While bulk update is active, registered notes are only subscribed to. The index is built in one
+// pass when update ends
+void DatesModel::BeginBulkUpdate() {
+	bulkUpdate = true;
 }
 
-void DatesModel::sl_Note_DateChanged() {
-	Note* note = qobject_cast<Note*>(QObject::sender());
-	if (note == 0) {
-		WARNING("Casting error");
-		return;
-	}
-
-	QDate noteDate;
-	switch (lookupField) {
-	case CreationDate:
-		noteDate = note->GetCreationDate().date();
-		break;
-	case ModifyDate:
-		noteDate = note->GetModificationDate().date();
-		break;
-	case TextDate:
-		noteDate = note->GetTextCreationDate().date();
-		break;
-	default:
-		return;
-	}
-
-	if (!notesBridge.contains(note) && !noteDate.isValid()) {
-		return;
-	}
-
-	BaseModelItem* noteItem = 0;
+void DatesModel::EndBulkUpdate() {
+	if (!bulkUpdate) {return;}
+	bulkUpdate = false;
+	rebuild();
+}
 
-	// Check if date didn't changed
-	if (notesBridge.contains(note) && noteDate.isValid()) {
-		noteItem = notesBridge.value(note);
-		DateModelItem* dayItem = dynamic_cast<DateModelItem*>(noteItem->parent());
-		quint32 newDateID = GenerateDateID(noteDate.year(), noteDate.month(), noteDate.day());
-		quint32 oldDateID = GenerateDateID(dayItem);
-		if (oldDateID == newDateID) {return;}
+// Builds date index from all document notes and publishes year items with a single model reset.
+// Deeper levels are created in fetchMore()
+void DatesModel::rebuild() {
+	dateIndex.clear();
+	noteDates.clear();
+	populatedItems.clear();
+	notesBridge.clear();
+	datesBridge.clear();
+
+	foreach (Note* n, document->GetNotesList()) {
+		const QDate date = noteDate(n);
+		if (!date.isValid()) {continue;}
+		dateIndex[GenerateDateID(date.year(), date.month(), date.day())].append(n);
+		noteDates.insert(n, date);
 	}
 
-	if (notesBridge.contains(note)) {
-		noteItem = notesBridge.value(note);
-		removeNoteFromTree(dynamic_cast<NoteModelItem*>(noteItem));
-		qDebug() << "note item removed from tree";
+	BaseModelItem* root = new BaseModelItem();
+	root->SetSorted(true);
 
-		if (!noteDate.isValid()) {
-			notesBridge.remove(note);
-			delete noteItem;
-			qDebug() << "new date is invalid, note item deleted";
-			return;
-		}
+	QMap<qint32, QList<Note*> >::const_iterator it = dateIndex.constBegin();
+	while (it != dateIndex.constEnd()) {
+		const int year = noteDates.value(it.value().first()).year();
+		const qint32 yearID = GenerateDateID(year);
+		root->AddChild(createDateItem(DateModelItem::Year, year, yearID));
+		it = dateIndex.lowerBound(yearID + 10000); // skip to the next year
 	}
 
-	if (noteDate.isValid()) {
-		if (!notesBridge.contains(note)) {
-			noteItem = new NoteModelItem(note);
-			QObject::connect(noteItem, SIGNAL(sg_DataChanged(BaseModelItem*)),
-							 this, SLOT(sl_Item_DataChanged(BaseModelItem*)));
-			notesBridge.insert(note, noteItem);
-			qDebug() << "new note item created";
-		}
-
-		qDebug() << "trying to add item to tree";
-		addNoteToTree(dynamic_cast<NoteModelItem*>(noteItem));
-		qDebug() << "note item added to tree";
-	}
+	ResetRootItem(root);
 }
 
-void DatesModel::sl_NoteRegistered(Note* note) {
-	if (!note) {
-		WARNING("Null pointer recieved");
-		return;
-	}
-	if (notesBridge.contains(note)) {
-		WARNING("Note already registered");
-		return;
-	}
-
-
-	QDateTime (Note::*fp)() const;
-	fp = 0;
-
+QDate DatesModel::noteDate(const Note* note) const {
 	switch (lookupField) {
 	case CreationDate:
-		fp = &Note::GetCreationDate;
-		break;
+		return note->GetCreationDate().date();
 	case ModifyDate:
-		QObject::connect(note, SIGNAL(sg_ModifyDateChanged()), this, SLOT(sl_Note_DateChanged()));
-		fp = &Note::GetModificationDate;
-		break;
+		return note->GetModificationDate().date();
 	case TextDate:
-		QObject::connect(note, SIGNAL(sg_TextDateChanged()), this, SLOT(sl_Note_DateChanged()));
-		fp = &Note::GetTextCreationDate;
-		break;
+		return note->GetTextCreationDate().date();
 	default:
-		return;
+		return QDate();
 	}
+}
 
-	if (!((note->*fp)().isValid())) {return;} // if note has invalid date then just subscribe to signals
-
+NoteModelItem* DatesModel::createNoteItem(Note* note) {
 	NoteModelItem* noteItem = new NoteModelItem(note);
-	QObject::connect(noteItem, SIGNAL(sg_DataChanged(BaseModelItem*)),
-					 this, SLOT(sl_Item_DataChanged(BaseModelItem*)));
-	addNoteToTree(noteItem);
 	notesBridge.insert(note, noteItem);
+	return noteItem;
 }
 
-void DatesModel::sl_NoteUnregistered(Note* note) {
-	if (!note) {
-		WARNING("Null pointer recieved");
-		return;
-	}
+DateModelItem* DatesModel::createDateItem(DateModelItem::DateComponent component, int value, qint32 dateID) {
+	DateModelItem* item = new DateModelItem(component, value);
+	item->SetSorted(true);
+	const qint32 rangeSize = component == DateModelItem::Year ? 10000 :
+							 component == DateModelItem::Month ? 100 : 1;
+	item->notesCount = notesCountInRange(dateID, dateID + rangeSize);
+	datesBridge.insert(dateID, item);
+	return item;
+}
 
-	if (!notesBridge.contains(note)) {return;}
+/*virtual*/
+bool DatesModel::hasChildren(const QModelIndex& parent) const {
+	if (canFetchMore(parent)) {return true;} // date items are never empty
+	return BaseModel::hasChildren(parent);
+}
 
-	// delete items
-	BaseModelItem* noteItem = notesBridge.value(note);
-	QObject::disconnect(noteItem, 0, this, 0);
-	removeNoteFromTree(dynamic_cast<NoteModelItem*>(noteItem));
-	notesBridge.remove(note);
-	delete noteItem;
+/*virtual*/
+bool DatesModel::canFetchMore(const QModelIndex& parent) const {
+	if (!parent.isValid()) {return false;}
+	const BaseModelItem* item = static_cast<BaseModelItem*>(parent.internalPointer());
+	return item->DataType() == BaseModelItem::date && !populatedItems.contains(item);
 }
 
-void DatesModel::addNoteToTree(NoteModelItem* noteItem) {
-	if (!noteItem) {
-		WARNING("Null pointer recieved");
+/*virtual*/
+void DatesModel::fetchMore(const QModelIndex& parent) {
+	if (!canFetchMore(parent)) {return;}
+
+	DateModelItem* item = dynamic_cast<DateModelItem*>(static_cast<BaseModelItem*>(parent.internalPointer()));
+	if (item == 0) {
+		WARNING("Casting error");
 		return;
 	}
-	if (noteItem->GetStoredData() == 0) {
-		WARNING("Item has no internal data");
+	populatedItems.insert(item);
+
+	const qint32 itemID = GenerateDateID(item);
+	QList<BaseModelItem*> children;
+	QMap<qint32, QList<Note*> >::const_iterator it = dateIndex.lowerBound(itemID);
+
+	switch (item->component) {
+	case DateModelItem::Year:
+		while (it != dateIndex.constEnd() && it.key() < itemID + 10000) {
+			const int month = (it.key() - itemID) / 100;
+			const qint32 monthID = itemID + month * 100;
+			children << createDateItem(DateModelItem::Month, month, monthID);
+			it = dateIndex.lowerBound(monthID + 100); // skip to the next month
+		}
+		break;
+	case DateModelItem::Month:
+		while (it != dateIndex.constEnd() && it.key() < itemID + 100) {
+			children << createDateItem(DateModelItem::Day, it.key() - itemID, it.key());
+			++it;
+		}
+		break;
+	case DateModelItem::Day:
+		if (it != dateIndex.constEnd() && it.key() == itemID) {
+			QVector<QPair<QString, Note*> > sortedNotes;
+			sortedNotes.reserve(it.value().size());
+			foreach (Note* n, it.value()) {
+				sortedNotes.append(qMakePair(n->GetName().toUpper(), n));
+			}
+			std::sort(sortedNotes.begin(), sortedNotes.end());
+			for (int i = 0; i < sortedNotes.size(); ++i) {
+				children << createNoteItem(sortedNotes.at(i).second);
+			}
+		}
+		break;
+	default:
+		WARNING("Wrong case branch");
 		return;
 	}
 
-	QDate noteDate;
+	if (children.isEmpty()) {return;}
+
+	beginInsertRows(parent, 0, children.size() - 1);
+		foreach (BaseModelItem* child, children) {
+			item->AddChild(child);
+		}
+	endInsertRows();
+}
+
+void DatesModel::sl_ChangeBus_ItemsChanged(const ItemChanges& changes) {
+	if (bulkUpdate) {return;}
 
+	int dateFlag = 0;
 	switch (lookupField) {
-	case CreationDate:
-		noteDate = noteItem->GetStoredData()->GetCreationDate().date();
-		break;
 	case ModifyDate:
-		noteDate = noteItem->GetStoredData()->GetModificationDate().date();
+		dateFlag = ItemChangeBus::ModifyDateChanged;
 		break;
 	case TextDate:
-		noteDate = noteItem->GetStoredData()->GetTextCreationDate().date();
+		dateFlag = ItemChangeBus::TextDateChanged;
 		break;
 	default:
-		return;
+		break;
 	}
 
-	BaseModelItem* newParentItem = 0;
-
-	qint32 dayID =		GenerateDateID(noteDate.year(), noteDate.month(), noteDate.day());
-	qint32 monthID =	GenerateDateID(noteDate.year(), noteDate.month());
-	qint32 yearID =		GenerateDateID(noteDate.year());
-	int newElementPosition = 0;
+	QList<BaseModelItem*> changedItems;
+	for (ItemChanges::const_iterator it = changes.constBegin(); it != changes.constEnd(); ++it) {
+		if (it.key()->GetItemType() != AbstractFolderItem::Type_Note) {continue;}
+		Note* note = static_cast<Note*>(it.key());
 
-	if (datesBridge.contains(dayID)) { // Search for day item
-		newParentItem = datesBridge.value(dayID);
-	} else if (datesBridge.contains(monthID)) { // search for month
-		BaseModelItem* monthItem = datesBridge.value(monthID);
-		DateModelItem* dayItem = new DateModelItem(DateModelItem::Day, noteDate.day());
-		dayItem->SetSorted(true);
-		QModelIndex monthIndex = createIndex(monthItem->parent()->IndexOfChild(monthItem), 0, monthItem);
+		// Note is moved to another date before its item is updated
+		if ((it.value() & dateFlag) != 0) {updateNoteDate(note);}
+		if ((it.value() & ItemChangeBus::VisualChanges) == 0) {continue;}
 
-		newElementPosition = monthItem->FindInsertIndex(dayItem);
-
-		beginInsertRows(monthIndex, newElementPosition, newElementPosition); // find out new position, items sorting MUST be considered
-			monthItem->AddChildTo(dayItem, newElementPosition);
-		endInsertRows();
+		BaseModelItem* noteItem = notesBridge.value(note);
+		if (noteItem != 0) {
+			changedItems << noteItem;
+		}
+	}
 
-		datesBridge.insert(dayID, dayItem);
-		newParentItem = dayItem;
+	EmitItemsDataChanged(changedItems);
+}
 
-	} else if (datesBridge.contains(yearID)) { // search for year
-		BaseModelItem* yearItem = datesBridge.value(yearID);
-		DateModelItem* monthItem = new DateModelItem(DateModelItem::Month, noteDate.month());
-		monthItem->SetSorted(true);
-		QModelIndex yearIndex = createIndex(GetRootItem()->IndexOfChild(yearItem), 0, yearItem);
+void DatesModel::updateNoteDate(Note* note) {
+	const QDate date = noteDate(note);
 
-		newElementPosition = yearItem->FindInsertIndex(monthItem);
+	if (noteDates.contains(note)) {
+		if (noteDates.value(note) == date) {return;} // date didn't change
+		removeNote(note);
+	}
 
-		beginInsertRows(yearIndex, newElementPosition, newElementPosition);
-			yearItem->AddChildTo(monthItem, newElementPosition);
-		endInsertRows();
+	if (date.isValid()) {
+		addNote(note, date);
+	}
+}
 
-		datesBridge.insert(monthID, monthItem);
+void DatesModel::sl_NoteRegistered(Note* note) {
+	if (!note) {
+		WARNING("Null pointer recieved");
+		return;
+	}
+	if (noteDates.contains(note)) {
+		WARNING("Note already registered");
+		return;
+	}
 
-		DateModelItem* dayItem = new DateModelItem(DateModelItem::Day, noteDate.day());
-		dayItem->SetSorted(true);
-		QModelIndex monthIndex = createIndex(monthItem->parent()->IndexOfChild(monthItem), 0, monthItem);
+	if (bulkUpdate) {return;} // note will be indexed when bulk update ends
 
-		newElementPosition = monthItem->FindInsertIndex(dayItem);
+	const QDate date = noteDate(note);
+	if (!date.isValid()) {return;} // date changes come through change bus
 
-		beginInsertRows(monthIndex, newElementPosition, newElementPosition); // find out new position, items sorting MUST be considered
-			monthItem->AddChildTo(dayItem, newElementPosition);
-		endInsertRows();
+	addNote(note, date);
+}
 
-		datesBridge.insert(dayID, dayItem);
-		newParentItem = dayItem;
+void DatesModel::sl_NoteUnregistered(Note* note) {
+	if (!note) {
+		WARNING("Null pointer recieved");
+		return;
+	}
 
-	} else { // even year item was not found
-		DateModelItem* yearItem = new DateModelItem(DateModelItem::Year, noteDate.year());
-		yearItem->SetSorted(true);
+	if (bulkUpdate) {return;}
 
-		newElementPosition = GetRootItem()->FindInsertIndex(yearItem);
+	removeNote(note);
+}
 
-		beginInsertRows(QModelIndex(), newElementPosition, newElementPosition);
-			GetRootItem()->AddChildTo(yearItem, newElementPosition);
-		endInsertRows();
+// Adds note to date index. Only items that were already populated are updated, the rest is built
+// when user expands them
+void DatesModel::addNote(Note* note, const QDate& date) {
+	const qint32 yearID =	GenerateDateID(date.year());
+	const qint32 monthID =	GenerateDateID(date.year(), date.month());
+	const qint32 dayID =	GenerateDateID(date.year(), date.month(), date.day());
 
-		datesBridge.insert(yearID, yearItem);
+	dateIndex[dayID].append(note);
+	noteDates.insert(note, date);
+	updateNotesCount(date, 1);
 
-		DateModelItem* monthItem = new DateModelItem(DateModelItem::Month, noteDate.month());
-		monthItem->SetSorted(true);
-		QModelIndex yearIndex = createIndex(GetRootItem()->IndexOfChild(yearItem), 0, yearItem);
+	BaseModelItem* yearItem = datesBridge.value(yearID);
+	if (yearItem == 0) {
+		insertChild(GetRootItem(), createDateItem(DateModelItem::Year, date.year(), yearID));
+		return;
+	}
+	if (!populatedItems.contains(yearItem)) {return;}
 
-		newElementPosition = yearItem->FindInsertIndex(monthItem);
+	BaseModelItem* monthItem = datesBridge.value(monthID);
+	if (monthItem == 0) {
+		insertChild(yearItem, createDateItem(DateModelItem::Month, date.month(), monthID));
+		return;
+	}
+	if (!populatedItems.contains(monthItem)) {return;}
 
-		beginInsertRows(yearIndex, newElementPosition, newElementPosition);
-			yearItem->AddChildTo(monthItem, newElementPosition);
-		endInsertRows();
+	BaseModelItem* dayItem = datesBridge.value(dayID);
+	if (dayItem == 0) {
+		insertChild(monthItem, createDateItem(DateModelItem::Day, date.day(), dayID));
+		return;
+	}
+	if (!populatedItems.contains(dayItem)) {return;}
 
-		datesBridge.insert(monthID, monthItem);
+	insertChild(dayItem, createNoteItem(note));
+}
 
-		DateModelItem* dayItem = new DateModelItem(DateModelItem::Day, noteDate.day());
-		dayItem->SetSorted(true);
-		QModelIndex monthIndex = createIndex(monthItem->parent()->IndexOfChild(monthItem), 0, monthItem);
+// Removes note from date index and deletes items of dates, that have no notes anymore
+void DatesModel::removeNote(Note* note) {
+	if (!noteDates.contains(note)) {return;}
 
-		newElementPosition = monthItem->FindInsertIndex(dayItem);
+	const QDate date = noteDates.take(note);
+	updateNotesCount(date, -1);
+	const qint32 yearID =	GenerateDateID(date.year());
+	const qint32 monthID =	GenerateDateID(date.year(), date.month());
+	const qint32 dayID =	GenerateDateID(date.year(), date.month(), date.day());
 
-		beginInsertRows(monthIndex, newElementPosition, newElementPosition); // find out new position, items sorting MUST be considered
-			monthItem->AddChildTo(dayItem, newElementPosition);
-		endInsertRows();
+	QMap<qint32, QList<Note*> >::iterator it = dateIndex.find(dayID);
+	if (it != dateIndex.end()) {
+		it.value().removeOne(note);
+		if (it.value().isEmpty()) {dateIndex.erase(it);}
+	}
 
-		datesBridge.insert(dayID, dayItem);
-		newParentItem = dayItem;
+	BaseModelItem* noteItem = notesBridge.take(note);
+	if (noteItem != 0) {
+		removeChild(noteItem);
+		delete noteItem;
 	}
 
-	int newPosition = newParentItem->FindInsertIndex(noteItem);
-	QModelIndex newParentIndex = createIndex(newParentItem->parent()->IndexOfChild(newParentItem),
-											 0, newParentItem);
+	if (dateIndex.contains(dayID)) {return;}
+	removeDateItem(dayID);
 
-	beginInsertRows(newParentIndex, newPosition, newPosition);
-		newParentItem->AddChildTo(noteItem, newPosition);
-	endInsertRows();
-}
+	if (hasNotesInRange(monthID, monthID + 100)) {return;}
+	removeDateItem(monthID);
 
-void DatesModel::removeNoteFromTree(NoteModelItem* noteItem) {
-	// Remove noteItem from dayItem
-	BaseModelItem* dayItem = noteItem->parent();
-	QModelIndex dayIndex = createIndex(dayItem->parent()->IndexOfChild(dayItem), 0, dayItem);
+	if (hasNotesInRange(yearID, yearID + 10000)) {return;}
+	removeDateItem(yearID);
+}
 
-	beginRemoveRows(dayIndex, dayItem->IndexOfChild(noteItem), dayItem->IndexOfChild(noteItem));
-		dayItem->RemoveChild(noteItem);
-	endRemoveRows();
+bool DatesModel::hasNotesInRange(qint32 fromID, qint32 toID) const {
+	QMap<qint32, QList<Note*> >::const_iterator it = dateIndex.lowerBound(fromID);
+	return it != dateIndex.constEnd() && it.key() < toID;
+}
 
-	if (dayItem->ChildrenCount() > 0) {return;}
+int DatesModel::notesCountInRange(qint32 fromID, qint32 toID) const {
+	int count = 0;
+	QMap<qint32, QList<Note*> >::const_iterator it = dateIndex.lowerBound(fromID);
+	for (; it != dateIndex.constEnd() && it.key() < toID; ++it) {
+		count += it.value().size();
+	}
+	return count;
+}
 
-	BaseModelItem* monthItem = dayItem->parent();
-	QModelIndex monthIndex = createIndex(monthItem->parent()->IndexOfChild(monthItem), 0, monthItem);
-	qint32 dayItemID = GenerateDateID(dayItem);
+// Updates counters of existing year, month and day items of 'date'
+void DatesModel::updateNotesCount(const QDate& date, int delta) {
+	const qint32 ids[] = {GenerateDateID(date.year()),
+						  GenerateDateID(date.year(), date.month()),
+						  GenerateDateID(date.year(), date.month(), date.day())};
+
+	QList<BaseModelItem*> changedItems;
+	for (int i = 0; i < 3; ++i) {
+		DateModelItem* item = dynamic_cast<DateModelItem*>(datesBridge.value(ids[i]));
+		if (item == 0) {continue;}
+		item->notesCount += delta;
+		changedItems << item;
+	}
+	EmitItemsDataChanged(changedItems);
+}
 
-	beginRemoveRows(monthIndex, monthItem->IndexOfChild(dayItem), monthItem->IndexOfChild(dayItem));
-		monthItem->RemoveChild(dayItem);
-	endRemoveRows();
+QModelIndex DatesModel::itemIndex(BaseModelItem* item) const {
+	if (item == GetRootItem()) {return QModelIndex();}
+	return createIndex(item->parent()->IndexOfChild(item), 0, item);
+}
 
-	datesBridge.remove(dayItemID);
-	delete dayItem;
+void DatesModel::insertChild(BaseModelItem* parentItem, BaseModelItem* item) {
+	const int position = parentItem->FindInsertIndex(item);
 
-	if (monthItem->ChildrenCount() > 0) {return;}
+	beginInsertRows(itemIndex(parentItem), position, position);
+		parentItem->AddChildTo(item, position);
+	endInsertRows();
+}
 
-	BaseModelItem* yearItem = monthItem->parent();
-	QModelIndex yearIndex = createIndex(GetRootItem()->IndexOfChild(yearItem), 0, yearItem);
-	qint32 monthItemID = GenerateDateID(monthItem);
+void DatesModel::removeChild(BaseModelItem* item) {
+	BaseModelItem* parentItem = item->parent();
+	const int position = parentItem->IndexOfChild(item);
 
-	beginRemoveRows(yearIndex, yearItem->IndexOfChild(monthItem), yearItem->IndexOfChild(monthItem));
-		yearItem->RemoveChild(monthItem);
+	beginRemoveRows(itemIndex(parentItem), position, position);
+		parentItem->RemoveChild(item);
 	endRemoveRows();
+}
 
-	datesBridge.remove(monthItemID);
-	delete monthItem;
-
-	if (yearItem->ChildrenCount() > 0) {return;}
-
-	qint32 yearItemID = GenerateDateID(yearItem);
-
-	beginRemoveRows(QModelIndex(), GetRootItem()->IndexOfChild(yearItem), GetRootItem()->IndexOfChild(yearItem));
-		GetRootItem()->RemoveChild(yearItem);
-	endRemoveRows();
+void DatesModel::removeDateItem(qint32 dateID) {
+	BaseModelItem* item = datesBridge.take(dateID);
+	if (item == 0) {return;} // item was not created yet
 
-	datesBridge.remove(yearItemID);
-	delete yearItem;
+	removeChild(item);
+	populatedItems.remove(item);
+	delete item;
 }
 
 qint32 DatesModel::GenerateDateID(const int year, const int month, const int day) const {
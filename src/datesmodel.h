@@ -19,14 +19,18 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #define DATESMODEL_H
 
 #include "basemodel.h"
+#include "datemodelitem.h"
+#include "itemchangebus.h"
 
 #include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QDate>
 
 
 namespace qNotesManager {
 	class Note;
 	class NoteModelItem;
-	class DateModelItem;
 	class Document;
 
 
@@ -41,24 +45,53 @@ namespace qNotesManager {
 
 	private:
 		const LookupField lookupField;
+		Document* document;
+		bool bulkUpdate;
+
+		// Sorted date index: day ID -> notes of that day. Year, month and day items are built from
+		// it, note items are created only for days user has expanded
+		QMap<qint32, QList<Note*> > dateIndex;
+		QHash<const Note*, QDate> noteDates;
+		QSet<const BaseModelItem*> populatedItems;
+
 		QHash<const Note*, BaseModelItem*> notesBridge;
 		QHash<qint32, BaseModelItem*> datesBridge;
 		qint32 GenerateDateID(const int year, const int month = 0, const int day = 0) const;
 		qint32 GenerateDateID(const BaseModelItem*) const;
 
-		void addNoteToTree(NoteModelItem*);
-		void removeNoteFromTree(NoteModelItem*);
+		QDate noteDate(const Note*) const;
+		NoteModelItem* createNoteItem(Note*);
+		DateModelItem* createDateItem(DateModelItem::DateComponent, int value, qint32 dateID);
+		void rebuild();
+
+		bool hasNotesInRange(qint32 fromID, qint32 toID) const;
+		int notesCountInRange(qint32 fromID, qint32 toID) const;
+		void updateNotesCount(const QDate& date, int delta);
+		QModelIndex itemIndex(BaseModelItem*) const;
+		void insertChild(BaseModelItem* parentItem, BaseModelItem* item);
+		void removeChild(BaseModelItem* item);
+		void removeDateItem(qint32 dateID);
+
+		void addNote(Note*, const QDate&);
+		void removeNote(Note*);
+		void updateNoteDate(Note*);
 
 	public:
 		explicit DatesModel(LookupField field, Document*);
 
+		void BeginBulkUpdate();
+		void EndBulkUpdate();
+
+		/*virtual*/ bool hasChildren(const QModelIndex& parent = QModelIndex()) const;
+		/*virtual*/ bool canFetchMore(const QModelIndex& parent) const;
+		/*virtual*/ void fetchMore(const QModelIndex& parent);
+
 	private slots:
-		void sl_Note_DateChanged();
 
 		void sl_NoteRegistered(Note*);
 		void sl_NoteUnregistered(Note*);
 
-		void sl_Item_DataChanged(BaseModelItem*);
+		void sl_ChangeBus_ItemsChanged(const ItemChanges&);
 	};
 }
 
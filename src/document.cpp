@@ -24,7 +24,10 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include "application.h"
 #include "hierarchymodel.h"
 #include "tagsmodel.h"
+#include "tagslistmodel.h"
 #include "datesmodel.h"
+#include "quickopenindex.h"
+#include "itemchangebus.h"
 #include "cachedimagefile.h"
 #include "serializer.h"
 #include "global.h"
@@ -44,8 +47,11 @@ using namespace qNotesManager;
 Document::Document() : QObject(0) {
 	inInitMode = false;
 
+	changeBus = new ItemChangeBus(this);
+
 	rootFolder = new Folder("_root_", Folder::SystemFolder);
 	rootFolder->setParent(this);
+	rootFolder->SetChangeBus(changeBus);
 	QObject::connect(rootFolder, SIGNAL(sg_ItemAdded(AbstractFolderItem*const, int)),
 					 this, SLOT(sl_Folder_ItemAdded(AbstractFolderItem* const, int)));
 	QObject::connect(rootFolder, SIGNAL(sg_ItemRemoved(AbstractFolderItem*const)),
@@ -54,6 +60,7 @@ Document::Document() : QObject(0) {
 
 	tempFolder = new Folder("Temporary", Folder::TempFolder);
 	tempFolder->setParent(this);
+	tempFolder->SetChangeBus(changeBus);
 	QObject::connect(tempFolder, SIGNAL(sg_ItemAdded(AbstractFolderItem*const, int)),
 					 this, SLOT(sl_Folder_ItemAdded(AbstractFolderItem* const, int)));
 	QObject::connect(tempFolder, SIGNAL(sg_ItemRemoved(AbstractFolderItem*const)),
@@ -62,6 +69,7 @@ Document::Document() : QObject(0) {
 
 	trashFolder = new Folder("Trash", Folder::TrashFolder);
 	trashFolder->setParent(this);
+	trashFolder->SetChangeBus(changeBus);
 	QObject::connect(trashFolder, SIGNAL(sg_ItemAdded(AbstractFolderItem*const, int)),
 					 this, SLOT(sl_Folder_ItemAdded(AbstractFolderItem* const, int)));
 	QObject::connect(trashFolder, SIGNAL(sg_ItemRemoved(AbstractFolderItem*const)),
@@ -70,7 +78,7 @@ Document::Document() : QObject(0) {
 
 	pinnedFolder = 0;
 
-	tagsListModel = new QStandardItemModel(this);
+	tagsListModel = new TagsListModel(this);
 
 	hierarchyModel = new HierarchyModel(this);
 
@@ -82,6 +90,8 @@ Document::Document() : QObject(0) {
 
 	textDateModel = new DatesModel(DatesModel::TextDate, this);
 
+	quickOpenIndex = new QuickOpenIndex(this);
+
 
 	LockFolderItems = true;
 
@@ -100,13 +110,22 @@ Document::Document() : QObject(0) {
 	DefaultFolderIcon = Application::I()->DefaultFolderIcon;
 	DefaultNoteIcon = Application::I()->DefaultNoteIcon;
 
-	tagIcon = QIcon(":/gui/tag");
-
 	fileTimeStamp = QDateTime::currentDateTime();
 	doNotReloadFlag = false;
 }
 
 Document::~Document() {
+	// Items may be deleted after change bus, which is a QObject child too. Detach them first
+	foreach (Note* n, allNotes.toList()) {
+		n->SetChangeBus(0);
+	}
+	foreach (Folder* f, allFolders.toList()) {
+		f->SetChangeBus(0);
+	}
+	rootFolder->SetChangeBus(0);
+	tempFolder->SetChangeBus(0);
+	trashFolder->SetChangeBus(0);
+
 	delete rootFolder;
 	delete trashFolder;
 	delete tempFolder;
@@ -120,7 +139,7 @@ Document::~Document() {
 		delete customIcons[key];
 	}
 
-	foreach (Tag* t, allTags) {
+	foreach (Tag* t, allTags.toList()) {
 		delete t;
 	}
 }
@@ -281,6 +300,7 @@ void Document::RegisterItem(AbstractFolderItem* const item) {
 						 this, SLOT(sl_Folder_ItemRemoved(AbstractFolderItem*const)));
 
 		QObject::connect(f, SIGNAL(sg_DataChanged()), this, SLOT(sl_ItemDataChanged()));
+		f->SetChangeBus(changeBus);
 
 		allFolders.append(f);
 		emit sg_ItemRegistered(f);
@@ -301,6 +321,8 @@ void Document::RegisterItem(AbstractFolderItem* const item) {
 		QObject::connect(n, SIGNAL(sg_TagAdded(Tag*)), this, SLOT(sl_Note_TagAdded(Tag*)));
 		QObject::connect(n, SIGNAL(sg_TagRemoved(Tag*)), this, SLOT(sl_Note_TagRemoved(Tag*)));
 
+		n->SetChangeBus(changeBus);
+
 		// TODO: Register tags ?
 
 		allNotes.append(n);
@@ -308,26 +330,49 @@ void Document::RegisterItem(AbstractFolderItem* const item) {
 	}
 }
 
+// Items of removed branch are dropped from document lists in one pass
 void Document::UnregisterItem(AbstractFolderItem* const item) {
+	QList<Folder*> folders;
+	QList<Note*> notes;
+	collectBranch(item, folders, notes);
+	allFolders.removeAll(folders);
+	allNotes.removeAll(notes);
+
+	unregisterBranch(item);
+}
+
+void Document::collectBranch(AbstractFolderItem* const item, QList<Folder*>& folders,
+							 QList<Note*>& notes) const {
+	if (item->GetItemType() == AbstractFolderItem::Type_Folder) {
+		Folder* f = dynamic_cast<Folder*>(item);
+		folders << f;
+		for (int i = 0; i < f->Items.Count(); ++i) {
+			collectBranch(f->Items.ItemAt(i), folders, notes);
+		}
+	} else if (item->GetItemType() == AbstractFolderItem::Type_Note) {
+		notes << dynamic_cast<Note*>(item);
+	}
+}
+
+void Document::unregisterBranch(AbstractFolderItem* const item) {
 	if (item->GetItemType() == AbstractFolderItem::Type_Folder) {
 		Folder* f = dynamic_cast<Folder*>(item);
 		QObject::disconnect(f, 0, this, 0);
+		f->SetChangeBus(0);
 
-		allFolders.removeAll(f);
 		emit sg_ItemUnregistered(f);
 
 		for (int i = 0; i < f->Items.Count(); ++i) {
-			UnregisterItem(f->Items.ItemAt(i));
+			unregisterBranch(f->Items.ItemAt(i));
 		}
 
 	} else if (item->GetItemType() == AbstractFolderItem::Type_Note) {
 		Note* n = dynamic_cast<Note*>(item);
 		QObject::disconnect(n, 0, this, 0);
+		n->SetChangeBus(0);
 
 		n->Tags.Clear(); // ? Tags must be unregistered, but this line modifies note.
 
-		allNotes.removeAll(n);
-
 		if (bookmarks.contains(n)) {
 			RemoveBookmark(n);
 		}
@@ -340,19 +385,15 @@ void Document::RegisterTag(Tag* tag) {
 	allTags.append(tag);
 	tag->setParent(this);
 	tagsByName.insert(tag->GetName(), tag);
-	QStandardItem* i = new QStandardItem(tagIcon, tag->GetName());
-	tagsListModel->appendRow(i);
-	tagsListModel->sort(0, Qt::AscendingOrder);
+	tagsListModel->AddTag(tag->GetName());
 	emit sg_ItemRegistered(tag);
 }
 
 void Document::UnregisterTag(Tag* tag) {
-	allTags.removeAll(tag);
+	allTags.removeOne(tag);
 	tag->setParent(0);
 	tagsByName.remove(tag->GetName());
-	QList<QStandardItem*> itemsList = tagsListModel->findItems(tag->GetName(), Qt::MatchExactly, 0);
-	QStandardItem* item = tagsListModel->takeItem(itemsList.at(0)->row());
-	delete item;
+	tagsListModel->RemoveTag(tag->GetName());
 
 	emit sg_ItemUnregistered(tag);
 	delete tag;
@@ -403,7 +444,7 @@ Tag* Document::FindTagByName(QString name) const {
 	return tagsByName.contains(name) ? tagsByName.value(name) : 0;
 }
 
-QAbstractItemModel* Document::GetTagsListModel() const {
+TagsListModel* Document::GetTagsListModel() const {
 	return tagsListModel;
 }
 
@@ -427,12 +468,40 @@ DatesModel* Document::GetTextDatesModel() const {
 	return textDateModel;
 }
 
+QuickOpenIndex* Document::GetQuickOpenIndex() const {
+	return quickOpenIndex;
+}
+
+ItemChangeBus* Document::GetChangeBus() const {
+	return changeBus;
+}
+
+// Models stop tracking items one by one while document is being loaded and build their trees
+// once loading is finished
+void Document::beginBulkLoading() {
+	hierarchyModel->BeginBulkUpdate();
+	tagsModel->BeginBulkUpdate();
+	tagsListModel->BeginBulkUpdate();
+	creationDateModel->BeginBulkUpdate();
+	modificationDateModel->BeginBulkUpdate();
+	textDateModel->BeginBulkUpdate();
+}
+
+void Document::endBulkLoading() {
+	hierarchyModel->EndBulkUpdate();
+	tagsModel->EndBulkUpdate();
+	tagsListModel->EndBulkUpdate();
+	creationDateModel->EndBulkUpdate();
+	modificationDateModel->EndBulkUpdate();
+	textDateModel->EndBulkUpdate();
+}
+
 QList<Tag*> Document::GetTagsList() const {
-	return allTags;
+	return allTags.toList();
 }
 
 QList<Note*> Document::GetNotesList() const {
-	return allNotes;
+	return allNotes.toList();
 }
 
 void Document::AddCustomIcon(CachedImageFile* image) {
@@ -449,6 +518,7 @@ void Document::AddCustomIcon(CachedImageFile* image) {
 
 	QString name = image->GetMD5();
 	customIcons.insert(name, image);
+	itemIcons.clear();
 
 	QStandardItem* i = new QStandardItem(image->GetPixmap(QSize(16, 16)), QString());
 	i->setData(name, Qt::UserRole + 1);
@@ -473,6 +543,7 @@ void Document::AddCustomIconToStorage(CachedImageFile* image) {
 
 	QString name = image->GetMD5();
 	customIcons.insert(name, image);
+	itemIcons.clear();
 }
 
 void Document::RemoveCustomIcon(QString key) {
@@ -500,14 +571,15 @@ void Document::RemoveCustomIcon(QString key) {
 	}
 
 
+	const int keyIndex = Application::I()->GetIconIndex(key);
 	for (int i = 0; i < allNotes.size(); ++i) {
-		if (allNotes.at(i)->GetIconID() == key) {
+		if (allNotes.at(i)->GetIconIndex() == keyIndex) {
 			allNotes.at(i)->SetIconID(DefaultNoteIcon);
 		}
 	}
 
 	for (int i = 0; i < allFolders.size(); ++i) {
-		if (allFolders.at(i)->GetIconID() == key) {
+		if (allFolders.at(i)->GetIconIndex() == keyIndex) {
 			allFolders.at(i)->SetIconID(DefaultFolderIcon);
 		}
 	}
@@ -516,6 +588,7 @@ void Document::RemoveCustomIcon(QString key) {
 
 	delete customIcons[key];
 	customIcons.remove(key);
+	itemIcons.clear();
 
 	onChange();
 }
@@ -542,6 +615,23 @@ QPixmap Document::GetItemIcon(const QString key) const {
 	}
 }
 
+// Returns icon by interned id. Icons are painted for every visible item, so they are cached
+QPixmap Document::GetItemIcon(int iconIndex) const {
+	if (iconIndex < 0) {
+		WARNING("Index is out of bounds");
+		return QPixmap();
+	}
+
+	if (iconIndex >= itemIcons.size()) {
+		itemIcons.resize(iconIndex + 1);
+	}
+	QPixmap& icon = itemIcons[iconIndex];
+	if (icon.isNull()) {
+		icon = GetItemIcon(Application::I()->GetIconID(iconIndex));
+	}
+	return icon;
+}
+
 quint8 Document::GetCompressionLevel() const {
 	return compressionLevel;
 }
@@ -576,6 +666,18 @@ void Document::SetCipherData(const quint8 id, const QString& _password) {
 		onChange();
 	}
 
+	// Attachments of encrypted document must not stay on disk unencrypted
+	if (cipherID != 0) {
+		for (int i = 0; i < allNotes.size(); ++i) {
+			const Note* note = allNotes.at(i);
+			for (int f = 0; f < note->GetAttachedFilesCount(); ++f) {
+				if (!note->GetAttachedFile(f)->KeepInMemory()) {
+					WARNING("Could not move attached file to memory");
+				}
+			}
+		}
+	}
+
 	if (password != _password) {
 		if (cipherID == 0) {
 			password = QByteArray();
@@ -615,13 +717,13 @@ int Document::GetBookmarksCount() const {
 Note* Document::GetBookmark(int index) const {
 	if (index < 0 || index >= bookmarks.count()) {return 0;}
 
-	return bookmarks[index];
+	return bookmarks.at(index);
 }
 
 void Document::AddBookmark(Note* note) {
 	if (bookmarks.contains(note)) {return;}
 
-	bookmarks.push_back(note);
+	bookmarks.append(note);
 	onChange();
 	emit sg_BookmarksListChanged();
 }
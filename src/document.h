@@ -20,6 +20,8 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 
 #include <QObject>
 #include <QList>
+#include <QVector>
+#include <QPixmap>
 #include <QUuid>
 #include <QMap>
 #include <QSet>
@@ -28,6 +30,7 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include <QSemaphore>
 
 #include "documentvisualsettings.h"
+#include "indexedlist.h"
 
 /*
   Document class represents a document that contains all notes, folder, tags and can be saved to
@@ -42,7 +45,10 @@ namespace qNotesManager {
 	class DocumentSearchEngine;
 	class HierarchyModel;
 	class TagsModel;
+	class TagsListModel;
 	class DatesModel;
+	class QuickOpenIndex;
+	class ItemChangeBus;
 	class CachedImageFile;
 
 	class Document : public QObject {
@@ -60,26 +66,35 @@ namespace qNotesManager {
 		Folder*		trashFolder;
 		Folder*		pinnedFolder;
 
-		QList<Tag*>		allTags;
-		QList<Note*>	allNotes;
-		QList<Folder*>	allFolders;
-		QList<Note*> bookmarks;
+		IndexedList<Tag>	allTags;
+		IndexedList<Note>	allNotes;
+		IndexedList<Folder>	allFolders;
+		IndexedList<Note>	bookmarks;
 
 		QMap<QString, Tag*> tagsByName; // to quickly fing tag by name
 
 		void RegisterItem(AbstractFolderItem* const item);
 		void UnregisterItem(AbstractFolderItem* const item);
+		void collectBranch(AbstractFolderItem* const item, QList<Folder*>& folders,
+						   QList<Note*>& notes) const;
+		void unregisterBranch(AbstractFolderItem* const item);
 		void RegisterTag(Tag* tag);
 		void UnregisterTag(Tag* tag);
 
-		QStandardItemModel* tagsListModel; // used for completers in TagsLineEdit
+		void beginBulkLoading();
+		void endBulkLoading();
+
+		ItemChangeBus* changeBus;
+		TagsListModel* tagsListModel; // used for completers in TagsLineEdit
 		HierarchyModel* hierarchyModel;
 		TagsModel* tagsModel;
 		DatesModel* creationDateModel;
 		DatesModel* modificationDateModel;
 		DatesModel* textDateModel;
+		QuickOpenIndex* quickOpenIndex;
 
 		QHash<QString, CachedImageFile*> customIcons;
+		mutable QVector<QPixmap> itemIcons; // 16x16 icons by interned icon id, null if not loaded yet
 
 		QString fileName; // Document filename
 		quint16 fileVersion;
@@ -94,7 +109,6 @@ namespace qNotesManager {
 		QString DefaultNoteIcon;
 		QString DefaultFolderIcon;
 
-		QIcon tagIcon;
 
 		mutable QDateTime fileTimeStamp;
 		mutable bool doNotReloadFlag;
@@ -121,12 +135,14 @@ namespace qNotesManager {
 
 		Tag* FindTagByName(QString name) const;
 
-		QAbstractItemModel* GetTagsListModel() const;
+		TagsListModel* GetTagsListModel() const;
 		HierarchyModel* GetHierarchyModel() const;
 		TagsModel* GetTagsModel() const;
 		DatesModel* GetCreationDatesModel() const;
 		DatesModel* GetModificationDatesModel() const;
 		DatesModel* GetTextDatesModel() const;
+		QuickOpenIndex* GetQuickOpenIndex() const;
+		ItemChangeBus* GetChangeBus() const;
 
 		QList<Tag*> GetTagsList() const;
 		QList<Note*> GetNotesList() const;
@@ -137,6 +153,7 @@ namespace qNotesManager {
 		void AddCustomIconToStorage(CachedImageFile*);
 		void RemoveCustomIcon(QString);
 		QPixmap GetItemIcon(const QString) const;
+		QPixmap GetItemIcon(int iconIndex) const;
 
 		quint8 GetCompressionLevel() const;
 		void SetCompressionLevel(const quint8 level);
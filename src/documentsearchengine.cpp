@@ -18,7 +18,8 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include "documentsearchengine.h"
 
 #include "document.h"
-#include "documentsearchthread.h"
+#include "note.h"
+#include "searchquery.h"
 #include "global.h"
 
 #include <QEventLoop>
@@ -26,25 +27,37 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include <QRegExp>
 #include <QDebug>
 
+#include <algorithm>
+
 using namespace qNotesManager;
 
 DocumentSearchEngine::DocumentSearchEngine(QObject* parent) :
 		QObject(parent),
 		document(0),
-		thread(new DocumentSearchThread(this)) {
+		thread(new DocumentSearchThread(this)),
+		hasPendingQuery(false),
+		pendingMatchCase(false),
+		pendingSearchWholeWord(false),
+		pendingUseRegexp(false),
+		lastMatchCase(false),
+		lastQueryIsPlainText(false),
+		lastCandidatesValid(false),
+		fetchingMoreResults(false),
+		unhandledRunsCount(0) {
 
 	QObject::connect(thread, SIGNAL(sg_SearchResult(NoteFragment)),
-					 this, SIGNAL(sg_SearchResult(NoteFragment)));
+					 this, SLOT(sl_Thread_SearchResult(NoteFragment)));
 	QObject::connect(thread, SIGNAL(sg_SearchStarted()),
-					 this, SIGNAL(sg_SearchStarted()));
+					 this, SLOT(sl_Thread_SearchStarted()));
 	QObject::connect(thread, SIGNAL(sg_SearchProgress(int)),
 					 this, SIGNAL(sg_SearchProgress(int)), Qt::QueuedConnection);
-	QObject::connect(thread, SIGNAL(sg_SearchEnded()),
-					 this, SIGNAL(sg_SearchEnded()));
+	QObject::connect(thread, SIGNAL(finished()),
+					 this, SLOT(sl_Thread_Finished()), Qt::QueuedConnection);
 
 }
 
 DocumentSearchEngine::~DocumentSearchEngine() {
+	hasPendingQuery = false;
 	if (thread->isRunning()) {
 		thread->Deactivate();
 		thread->wait();
@@ -52,18 +65,55 @@ DocumentSearchEngine::~DocumentSearchEngine() {
 }
 
 bool DocumentSearchEngine::IsSearchActive() const {
-	return thread->isRunning();
+	return thread->isRunning() || hasPendingQuery;
 }
 
 bool DocumentSearchEngine::IsQueryValid(QString query, bool useRegExp) const {
 	if (!useRegExp) {
-		query = QRegExp::escape(query);
+		return SearchQuery::Parse(query).IsValid();
 	}
 
 	QRegExp regexp (query);
 	return regexp.isValid();
 }
 
+// Parses query and builds regexp for text search. Regexp is empty if query consists of filters only
+bool DocumentSearchEngine::buildSearch(const QString& query, bool matchCase, bool searchWholeWord,
+									   bool useRegexp, SearchQuery& parsedQuery, QRegExp& regexp) {
+	QString pattern;
+
+	if (useRegexp) {
+		parsedQuery = SearchQuery();
+		pattern = query;
+		if (searchWholeWord && !pattern.isEmpty()) {
+			pattern.prepend("\\b").append("\\b");
+		}
+	} else {
+		parsedQuery = SearchQuery::Parse(query);
+		if (!parsedQuery.IsValid()) {
+			emit sg_SearchError(parsedQuery.GetErrorString());
+			return false;
+		}
+		pattern = parsedQuery.TextPattern(searchWholeWord);
+	}
+
+	if (pattern.isEmpty() && !parsedQuery.HasFilters()) {
+		emit sg_SearchError("Search text is empty");
+		return false;
+	}
+
+	Qt::CaseSensitivity cs = matchCase ? Qt::CaseSensitive : Qt::CaseInsensitive;
+
+	regexp = QRegExp(pattern, cs);
+
+	if (!regexp.isValid()) {
+		emit sg_SearchError("Regexp is invalid");
+		return false;
+	}
+
+	return true;
+}
+
 void DocumentSearchEngine::StartSearch(QString query, bool matchCase, bool searchWholeWord,
 								  bool useRegexp) {
 	if (document == 0) {return;}
@@ -73,45 +123,235 @@ void DocumentSearchEngine::StartSearch(QString query, bool matchCase, bool searc
 		return;
 	}
 
-	if (query.isEmpty()) {
-		emit sg_SearchError("Search text is empty");
+	SearchQuery parsedQuery;
+	QRegExp regexp;
+	if (!buildSearch(query, matchCase, searchWholeWord, useRegexp, parsedQuery, regexp)) {
 		return;
 	}
 
-	if (!useRegexp) {
-		query = QRegExp::escape(query);
-	}
+	startThread(parsedQuery, regexp, matchCase, searchWholeWord,
+				!useRegexp && !searchWholeWord && !parsedQuery.HasFilters(), false);
+}
 
-	if (searchWholeWord) {
-		query.prepend("\\b").append("\\b");
-	}
+// Starts search that does not wait for the running one: running search is cancelled and new query
+// is started as soon as the thread stops. If the new query contains the previous one, only notes
+// matched by the previous query are searched.
+void DocumentSearchEngine::StartIncrementalSearch(QString query, bool matchCase,
+												  bool searchWholeWord, bool useRegexp) {
+	if (document == 0) {return;}
 
-	Qt::CaseSensitivity cs = matchCase ? Qt::CaseSensitive : Qt::CaseInsensitive;
+	if (thread->isRunning()) {
+		pendingQuery = query;
+		pendingMatchCase = matchCase;
+		pendingSearchWholeWord = searchWholeWord;
+		pendingUseRegexp = useRegexp;
+		hasPendingQuery = true;
 
-	QRegExp regexp (query, cs);
+		thread->Deactivate();
+		return;
+	}
 
-	if (!regexp.isValid()) {
-		emit sg_SearchError("Regexp is invalid");
+	hasPendingQuery = false;
+
+	SearchQuery parsedQuery;
+	QRegExp regexp;
+	if (!buildSearch(query, matchCase, searchWholeWord, useRegexp, parsedQuery, regexp)) {
 		return;
 	}
 
-	const QList<Note*> notes = document->GetNotesList();
+	const bool plainText = !useRegexp && !searchWholeWord && !parsedQuery.HasFilters();
+	const bool reuse = plainText && canReuseLastResults(parsedQuery, matchCase);
+	startThread(parsedQuery, regexp, matchCase, searchWholeWord, plainText, reuse);
+}
 
+// A note that contains every term of the new query contains every term of the previous one, if
+// each previous term is a part of some new term
+bool DocumentSearchEngine::canReuseLastResults(const SearchQuery& parsedQuery,
+											   bool matchCase) const {
+	if (!lastCandidatesValid || !lastQueryIsPlainText) {return false;}
+	if (lastTerms.isEmpty()) {return false;}
+	if (lastMatchCase && !matchCase) {return false;}
+
+	const Qt::CaseSensitivity cs = lastMatchCase ? Qt::CaseSensitive : Qt::CaseInsensitive;
+	const QStringList terms = parsedQuery.GetTextTerms();
+
+	foreach (const QString& lastTerm, lastTerms) {
+		bool found = false;
+		foreach (const QString& term, terms) {
+			if (term.contains(lastTerm, cs)) {
+				found = true;
+				break;
+			}
+		}
+		if (!found) {return false;}
+	}
+
+	return true;
+}
+
+void DocumentSearchEngine::startThread(const SearchQuery& parsedQuery, const QRegExp& regexp,
+									   bool matchCase, bool searchWholeWord, bool plainText,
+									   bool reuseLastResults) {
+	// Metadata filters are cheap, so text is searched only in notes that passed them
+	const QList<Note*> notes = parsedQuery.HasFilters() ? parsedQuery.SelectCandidates(document)
+														: document->GetNotesList();
+
+	// Note must contain all terms of the query
+	QList<QRegExp> requiredRegexps;
+	const QStringList terms = parsedQuery.GetTextTerms();
+	if (terms.count() > 1) {
+		const Qt::CaseSensitivity cs = matchCase ? Qt::CaseSensitive : Qt::CaseInsensitive;
+		foreach (const QString& term, terms) {
+			QString pattern = QRegExp::escape(term);
+			if (searchWholeWord) {
+				pattern.prepend("\\b").append("\\b");
+			}
+			requiredRegexps << QRegExp(pattern, cs);
+		}
+	}
+
+	thread->ClearNotesList();
 	thread->SetRegexp(regexp);
+	thread->SetRequiredRegexps(requiredRegexps);
+	thread->SetRankResults(true);
+	thread->SetCorpusSize(document->GetNotesList().count());
 	foreach (Note* n, notes) {
+		if (reuseLastResults && !lastCandidates.contains(n)) {continue;}
 		thread->AddNote(n);
 	}
 
+	lastTerms = terms;
+	lastMatchCase = matchCase;
+	lastQueryIsPlainText = plainText;
+	lastCandidates.clear();
+	lastCandidatesValid = false;
+	lastRegexp = regexp;
+	rankedTail.clear();
+	fetchingMoreResults = false;
+	fetchedPage.clear();
+
+	unhandledRunsCount++;
+	thread->start();
+}
+
+bool DocumentSearchEngine::HasMoreResults() const {
+	return !rankedTail.isEmpty();
+}
+
+// Searches fragments in the next page of best notes that were ranked but not shown yet
+void DocumentSearchEngine::FetchMoreResults() {
+	if (document == 0 || thread->isRunning() || rankedTail.isEmpty()) {return;}
+
+	const int count = qMin((int)DocumentSearchThread::ResultsPageSize, rankedTail.count());
+	std::partial_sort(rankedTail.begin(), rankedTail.begin() + count, rankedTail.end(),
+					  RankedNote::HasGreaterScore);
+
+	thread->ClearNotesList();
+	thread->SetRegexp(lastRegexp);
+	thread->SetRequiredRegexps(QList<QRegExp>());
+	thread->SetRankResults(false);
+	for (int i = 0; i < count; ++i) {
+		thread->AddNote(rankedTail.at(i).NotePtr);
+	}
+	fetchedPage = rankedTail.mid(0, count);
+	rankedTail.remove(0, count);
+
+	fetchingMoreResults = true;
+	unhandledRunsCount++;
 	thread->start();
 }
 
 void DocumentSearchEngine::StopSearch() {
+	hasPendingQuery = false;
 	if (thread->isRunning()) {
 		thread->Deactivate();
 		thread->wait();
 	}
 }
 
+// Stops search without waiting for the thread to finish
+void DocumentSearchEngine::CancelSearch() {
+	hasPendingQuery = false;
+	if (thread->isRunning()) {
+		thread->Deactivate();
+	}
+}
+
+void DocumentSearchEngine::sl_Thread_SearchStarted() {
+	// Next page of results is appended to the shown ones
+	if (fetchingMoreResults) {return;}
+
+	emit sg_SearchStarted();
+}
+
+void DocumentSearchEngine::sl_Thread_SearchResult(const NoteFragment& fragment) {
+	lastCandidates.insert(fragment.NotePrt);
+	emit sg_SearchResult(fragment);
+}
+
+void DocumentSearchEngine::sl_Thread_Finished() {
+	// Notification from a run that was stopped with StopSearch() before another one was started
+	unhandledRunsCount--;
+	if (unhandledRunsCount > 0) {return;}
+
+	// 'finished' is emitted right before the thread actually stops
+	thread->wait();
+
+	const QList<const Note*> unprocessedNotes = thread->TakeNotesList();
+
+	if (fetchingMoreResults) {
+		fetchingMoreResults = false;
+
+		// Notes of the page the stopped run did not reach are fetched again next time
+		const QSet<const Note*> unprocessed = unprocessedNotes.toSet();
+		foreach (const RankedNote& r, fetchedPage) {
+			if (unprocessed.contains(r.NotePtr)) {rankedTail.append(r);}
+		}
+		fetchedPage.clear();
+	} else {
+		// Notes the search did not reach (when cancelled) may still match the next query
+		foreach (const Note* n, unprocessedNotes) {
+			lastCandidates.insert(n);
+		}
+		foreach (const Note* n, thread->TakeMatchedNotes()) {
+			lastCandidates.insert(n);
+		}
+		lastCandidatesValid = true;
+
+		// Tail of cancelled search would be shown without its best notes
+		rankedTail = thread->TakeRankedTail();
+		if (!unprocessedNotes.isEmpty()) {
+			rankedTail.clear();
+		}
+
+		emit sg_SearchEnded();
+	}
+
+	emit sg_MoreResultsAvailable(HasMoreResults());
+
+	if (hasPendingQuery) {
+		StartIncrementalSearch(pendingQuery, pendingMatchCase, pendingSearchWholeWord,
+							   pendingUseRegexp);
+	}
+}
+
+// Notes created or changed after the last query started may match following queries, they are
+// searched again even if last query did not match them
+void DocumentSearchEngine::sl_Document_NoteAdded(Note* n) {
+	lastCandidates.insert(n);
+}
+
+void DocumentSearchEngine::sl_ChangeBus_ItemsChanged(const ItemChanges& changes) {
+	const int searchedFields = ItemChangeBus::NameChanged | ItemChangeBus::TextChanged |
+							   ItemChangeBus::PropertiesChanged | ItemChangeBus::TagsChanged;
+
+	for (ItemChanges::const_iterator it = changes.constBegin(); it != changes.constEnd(); ++it) {
+		if ((it.value() & searchedFields) == 0) {continue;}
+		if (it.key()->GetItemType() != AbstractFolderItem::Type_Note) {continue;}
+		lastCandidates.insert(static_cast<const Note*>(it.key()));
+	}
+}
+
 void DocumentSearchEngine::sl_Document_NoteDeleted(Note* n) {
 	// If thread is executing search in note n then wait until it ends, block user input
 	while(thread->CurrentNote() == n) {
@@ -119,6 +359,14 @@ void DocumentSearchEngine::sl_Document_NoteDeleted(Note* n) {
 	}
 
 	thread->RemoveNote(n);
+	lastCandidates.remove(n);
+
+	for (int i = rankedTail.count() - 1; i >= 0; --i) {
+		if (rankedTail.at(i).NotePtr == n) {rankedTail.remove(i);}
+	}
+	for (int i = fetchedPage.count() - 1; i >= 0; --i) {
+		if (fetchedPage.at(i).NotePtr == n) {fetchedPage.remove(i);}
+	}
 }
 
 void DocumentSearchEngine::SetTargetDocument(Document* doc) {
@@ -128,13 +376,23 @@ void DocumentSearchEngine::SetTargetDocument(Document* doc) {
 
 	if (document != 0) {
 		QObject::disconnect(document, 0, this, 0);
+		QObject::disconnect(document->GetChangeBus(), 0, this, 0);
 	}
 
 	document = doc;
+	lastCandidates.clear();
+	lastCandidatesValid = false;
+	rankedTail.clear();
+	fetchedPage.clear();
+	emit sg_MoreResultsAvailable(false);
 
 	if (document != 0) {
+		QObject::connect(document, SIGNAL(sg_ItemRegistered(Note*)),
+						 this, SLOT(sl_Document_NoteAdded(Note*)));
 		QObject::connect(document, SIGNAL(sg_ItemUnregistered(Note*)),
 						 this, SLOT(sl_Document_NoteDeleted(Note*)));
+		QObject::connect(document->GetChangeBus(), SIGNAL(sg_ItemsChanged(const ItemChanges&)),
+						 this, SLOT(sl_ChangeBus_ItemsChanged(const ItemChanges&)));
 		QObject::connect(document, SIGNAL(destroyed()),
 						 this, SLOT(sl_Document_Destroyed()));
 	}
@@ -143,6 +401,11 @@ void DocumentSearchEngine::SetTargetDocument(Document* doc) {
 void DocumentSearchEngine::sl_Document_Destroyed() {
 	// In case if we forget to null target document
 	document = 0;
+	hasPendingQuery = false;
+	lastCandidates.clear();
+	lastCandidatesValid = false;
+	rankedTail.clear();
+	fetchedPage.clear();
 
 	thread->ClearNotesList();
 }
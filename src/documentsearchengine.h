@@ -19,13 +19,19 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #define ABSTRACTSEARCHENGINE_H
 
 #include <QObject>
+#include <QRegExp>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
 
 #include "notefragment.h"
+#include "documentsearchthread.h"
+#include "itemchangebus.h"
 
 namespace qNotesManager {
 	class Note;
-	class DocumentSearchThread;
 	class Document;
+	class SearchQuery;
 
 	class DocumentSearchEngine : public QObject {
 	Q_OBJECT
@@ -34,16 +40,49 @@ namespace qNotesManager {
 		Document* document;
 		DocumentSearchThread* const thread;
 
+		// Query that is waiting for cancelled search to finish (search-as-you-type mode)
+		bool hasPendingQuery;
+		QString pendingQuery;
+		bool pendingMatchCase;
+		bool pendingSearchWholeWord;
+		bool pendingUseRegexp;
+
+		// Data of last started query, used to narrow down following queries
+		QStringList lastTerms;
+		bool lastMatchCase;
+		bool lastQueryIsPlainText;
+		bool lastCandidatesValid;
+		QSet<const Note*> lastCandidates; // notes matched by last query + notes it did not reach
+
+		// Ranked results that were not shown yet
+		QRegExp lastRegexp;
+		QVector<RankedNote> rankedTail;
+		bool fetchingMoreResults; // current run searches fragments for the next page of results
+		QVector<RankedNote> fetchedPage; // notes of that page, returned to tail if run is stopped
+
+		int unhandledRunsCount; // started runs whose 'finished' notification was not handled yet
+
+		bool buildSearch(const QString& query, bool matchCase, bool searchWholeWord, bool useRegexp,
+						 SearchQuery& parsedQuery, QRegExp& regexp);
+		bool canReuseLastResults(const SearchQuery& parsedQuery, bool matchCase) const;
+		void startThread(const SearchQuery& parsedQuery, const QRegExp& regexp, bool matchCase,
+						 bool searchWholeWord, bool plainText, bool reuseLastResults);
+
 	public:
 		explicit DocumentSearchEngine(QObject* parent);
 		~DocumentSearchEngine();
 
 		void StartSearch(QString query, bool matchCase = false, bool searchWholeWord = false,
 						 bool useRegexp = false);
+		void StartIncrementalSearch(QString query, bool matchCase = false,
+									bool searchWholeWord = false, bool useRegexp = false);
 		bool IsSearchActive() const;
 		void StopSearch();
+		void CancelSearch();
 		bool IsQueryValid(QString query, bool useRegExp) const;
 		void SetTargetDocument(Document* doc);
+		bool HasMoreResults() const;
+		void FetchMoreResults();
 
 	signals:
 		void sg_SearchStarted();
@@ -51,9 +90,15 @@ namespace qNotesManager {
 		void sg_SearchProgress(int);
 		void sg_SearchResult(const NoteFragment);
 		void sg_SearchError(QString);
+		void sg_MoreResultsAvailable(bool);
 
 	private slots:
+		void sl_Thread_SearchStarted();
+		void sl_Thread_SearchResult(const NoteFragment&);
+		void sl_Thread_Finished();
+		void sl_Document_NoteAdded(Note*);
 		void sl_Document_NoteDeleted(Note*);
+		void sl_ChangeBus_ItemsChanged(const ItemChanges&);
 		void sl_Document_Destroyed();
 
 	};
@@ -18,9 +18,14 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include "documentsearchthread.h"
 
 #include "note.h"
+#include "tag.h"
 #include "global.h"
 
 #include <QDebug>
+#include <QStringList>
+
+#include <algorithm>
+#include <math.h>
 
 using namespace qNotesManager;
 
@@ -29,7 +34,11 @@ DocumentSearchThread::DocumentSearchThread(QObject *parent) :
 		regexp(QRegExp()),
 		isActive(false),
 		currentNote(0),
+		rankResults(false),
+		corpusSize(0),
+		totalLength(0),
 		primarySearchQueueSize(0),
+		secondarySearchQueueSize(0),
 		processedNotesCount(0)
 {
 }
@@ -68,24 +77,46 @@ void DocumentSearchThread::run() {
 		WARNING("DocumentSearchThread::run: regexp is invalid");
 		return;
 	}
-	if (regexp == QRegExp()) {
-		WARNING("DocumentSearchThread::run: regexp is empty");
-		return;
-	}
 
-	const int symbolsForSample = 40;
-	int textMatchStart = -1;
-	int textMatchLength = -1;
-	int currentPos = 0;
-
-	listLock.lockForRead();
+	listLock.lockForWrite();
 	primarySearchQueueSize = searchQueue.size();
+	// Until notes are ranked, size of the second pass is estimated by its upper bound
+	secondarySearchQueueSize = rankResults ? qMin((int)ResultsPageSize, primarySearchQueueSize) : 0;
+	statistics.clear();
+	documentFrequencies.clear();
+	totalLength = 0;
+	rankedTail.clear();
 	listLock.unlock();
+	searchStartTime = QDateTime::currentDateTime();
 	processedNotesCount = 0;
 
 	SetActive(true);
 	emit sg_SearchStarted();
 
+	if (rankResults) {
+		// Relevance of a note depends on all matched notes, so every note is scanned first and
+		// fragments are searched only in the best ones
+		processQueue(true);
+		if (IsActive()) {
+			rankStatistics();
+			requiredRegexps.clear(); // Ranked notes are known to contain all terms
+			listLock.lockForRead();
+			secondarySearchQueueSize = searchQueue.size();
+			listLock.unlock();
+			processQueue(false);
+		}
+	} else {
+		processQueue(false);
+	}
+
+	regexp = QRegExp();
+	requiredRegexps.clear();
+	emit sg_SearchEnded();
+	SetActive(false);
+	SetCurrentNote(0);
+}
+
+void DocumentSearchThread::processQueue(bool collectStatistics) {
 	while(true) {
 		listLock.lockForRead();
 		if (searchQueue.isEmpty()) {
@@ -119,165 +150,217 @@ void DocumentSearchThread::run() {
 
 		SetCurrentNote(n);
 
-		// TODO: fix this mess
-
-		// Search in caption
-		// FIXME: fix situation when capturedText.length() > symbolsForSample
-		currentPos = 0;
-		QString text = currentNote->GetName();
-		while (true) {
-			textMatchStart = regexp.indexIn(text, currentPos);
-			textMatchLength = regexp.matchedLength();
-			if (textMatchStart != -1 && textMatchLength != -1) {
-				const int textLength = text.length();
-				const QString capturedText = regexp.capturedTexts().at(0);
-				const int appendSymbols = (symbolsForSample - capturedText.length()) / 2;
-				int sampleStart = (textMatchStart - appendSymbols) >= 0
-								  ? (textMatchStart - appendSymbols)
-								  : 0;
-				int sampleLength = (textMatchStart + textMatchLength + appendSymbols - 1) < textLength
-								  ? (textMatchStart + textMatchLength + appendSymbols - 1)
-								  : textLength;
-				const QString sample = text.mid(sampleStart, sampleLength);
-				const int sampleMatchStart = textMatchStart - sampleStart;//sample.indexOf(capturedText);
-
-
-
-				NoteFragment f(currentNote, NoteFragment::CaptionFragment, textMatchStart,
-							   textMatchLength, sample, sampleMatchStart, capturedText.length());
-				emit sg_SearchResult(f);
-			} else {break;}
-
-			currentPos = textMatchStart + 1;
+		if (collectStatistics) {
+			if (containsRequiredTerms(n)) {
+				this->collectStatistics(n);
+			}
+		} else if (regexp.pattern().isEmpty()) {
+			// Query consists of filters only, every queued note is a result
+			const int nameLength = n->GetName().length();
+			NoteFragment f(n, NoteFragment::CaptionFragment, 0, nameLength, nameLength);
+			emit sg_SearchResult(f);
+		} else if (containsRequiredTerms(n)) {
+			searchInNote();
 		}
 
-		// Search in author field
-		currentPos = 0;
-		text = currentNote->GetAuthor();
-		while (true) {
-			textMatchStart = regexp.indexIn(text, currentPos);
-			textMatchLength = regexp.matchedLength();
-			if (textMatchStart != -1 && textMatchLength != -1) {
-				const int textLength = text.length();
-				const QString capturedText = regexp.capturedTexts().at(0);
-				const int appendSymbols = (symbolsForSample - capturedText.length()) / 2;
-				int sampleStart = (textMatchStart - appendSymbols) >= 0 ? (textMatchStart - appendSymbols) : 0;
-				int sampleLength = (textMatchStart + textMatchLength + appendSymbols - 1) < textLength ?
-								   (textMatchStart + textMatchLength + appendSymbols - 1) : textLength;
-				const QString sample = text.mid(sampleStart, sampleLength);
-				const int sampleMatchStart = textMatchStart - sampleStart;//sample.indexOf(capturedText);
-
-
-
-				NoteFragment f(currentNote, NoteFragment::AuthorFragment, textMatchStart,
-							   textMatchLength, sample, sampleMatchStart, capturedText.length());
-				emit sg_SearchResult(f);
-			} else {break;}
-
-			currentPos = textMatchStart + 1;
+		// Search was cancelled in the middle of the note, keep it in the queue as not processed
+		if (!IsActive()) {
+			listLock.lockForWrite();
+			searchQueue.push_front(n);
+			listLock.unlock();
+			break;
 		}
 
-		// Search in source field
-		currentPos = 0;
-		text = currentNote->GetSource();
-		while (true) {
-			textMatchStart = regexp.indexIn(text, currentPos);
-			textMatchLength = regexp.matchedLength();
-			if (textMatchStart != -1 && textMatchLength != -1) {
-				const int textLength = text.length();
-				const QString capturedText = regexp.capturedTexts().at(0);
-				const int appendSymbols = (symbolsForSample - capturedText.length()) / 2;
-				int sampleStart = (textMatchStart - appendSymbols) >= 0 ? (textMatchStart - appendSymbols) : 0;
-				int sampleLength = (textMatchStart + textMatchLength + appendSymbols - 1) < textLength ?
-								   (textMatchStart + textMatchLength + appendSymbols - 1) : textLength;
-				const QString sample = text.mid(sampleStart, sampleLength);
-				const int sampleMatchStart = textMatchStart - sampleStart;//sample.indexOf(capturedText);
-
-
-
-				NoteFragment f(currentNote, NoteFragment::SourceFragment, textMatchStart,
-							   textMatchLength, sample, sampleMatchStart, capturedText.length());
-				emit sg_SearchResult(f);
-			} else {break;}
-
-			currentPos = textMatchStart + 1;
+		processedNotesCount++;
+		// Both passes of ranked search are counted, so progress grows steadily to 100
+		const int totalSize = primarySearchQueueSize + secondarySearchQueueSize;
+		int progress = 0;
+		if (totalSize != 0) {
+			progress = (int)(((qint64)processedNotesCount * 100) / totalSize);
 		}
+		emit sg_SearchProgress(progress);
+	}
+}
 
-		// Search in comment field
-		currentPos = 0;
-		text = currentNote->GetComment();
-		while (true) {
-			textMatchStart = regexp.indexIn(text, currentPos);
-			textMatchLength = regexp.matchedLength();
-			if (textMatchStart != -1 && textMatchLength != -1) {
-				const int textLength = text.length();
-				const QString capturedText = regexp.capturedTexts().at(0);
-				const int appendSymbols = (symbolsForSample - capturedText.length()) / 2;
-				int sampleStart = (textMatchStart - appendSymbols) >= 0 ? (textMatchStart - appendSymbols) : 0;
-				int sampleLength = (textMatchStart + textMatchLength + appendSymbols - 1) < textLength ?
-								   (textMatchStart + textMatchLength + appendSymbols - 1) : textLength;
-				const QString sample = text.mid(sampleStart, sampleLength);
-				const int sampleMatchStart = textMatchStart - sampleStart;//sample.indexOf(capturedText);
-
-
-
-				NoteFragment f(currentNote, NoteFragment::CommentFragment, textMatchStart,
-							   textMatchLength, sample, sampleMatchStart, capturedText.length());
-				emit sg_SearchResult(f);
-			} else {break;}
-
-			currentPos = textMatchStart + 1;
-		}
+// Searches for regexp matches in all fields of current note
+void DocumentSearchThread::searchInNote() {
+	searchInField(currentNote->GetName(), NoteFragment::CaptionFragment);
+	searchInField(currentNote->GetAuthor(), NoteFragment::AuthorFragment);
+	searchInField(currentNote->GetSource(), NoteFragment::SourceFragment);
+	searchInField(currentNote->GetComment(), NoteFragment::CommentFragment);
+	searchInField(currentNote->GetText(), NoteFragment::TextFragment);
+}
 
-		// Search in text
-		currentPos = 0;
-		const QString elide = "...";
-		text = currentNote->GetText();
-		while (true) {
-			// FIXME: fix situation when capturedText.length() > symbolsForSample
-			textMatchStart = regexp.indexIn(text, currentPos);
-			textMatchLength = regexp.matchedLength();
-			if (textMatchStart != -1 && textMatchLength != -1) {
+// Emits positions of all non-overlapping matches. Samples are built by results view when shown.
+void DocumentSearchThread::searchInField(const QString& text, NoteFragment::FragmentType type) {
+	int currentPos = 0;
+	while (isActive) {
+		const int matchStart = regexp.indexIn(text, currentPos);
+		if (matchStart == -1) {break;}
 
-				const int textLength = text.length();
-				const QString capturedText = regexp.capturedTexts().at(0);
-				const int appendSymbols = (symbolsForSample - capturedText.length() -
-										   (elide.length()*2)) / 2;
-				int sampleStart = (textMatchStart - appendSymbols) >= 0 ? (textMatchStart - appendSymbols) : 0;
-				int sampleLength = (textMatchStart + textMatchLength + appendSymbols - 1) < textLength ?
-								   (appendSymbols + textMatchLength + appendSymbols) : textLength;
+		const int matchLength = regexp.matchedLength();
+		emit sg_SearchResult(NoteFragment(currentNote, type, matchStart, matchLength, text.length()));
 
-				QString sample =
-						text.mid(sampleStart, sampleLength).append(elide).prepend(elide);
-				sample.replace(QRegExp("\n"), " ");
-				const int sampleMatchStart = textMatchStart - sampleStart + elide.length();
+		currentPos = matchStart + qMax(matchLength, 1);
+	}
+}
 
+// Returns true if every required term is found in any of note's fields
+bool DocumentSearchThread::containsRequiredTerms(const Note* n) {
+	if (requiredRegexps.isEmpty()) {return true;}
+
+	const QString name = n->GetName();
+	const QString author = n->GetAuthor();
+	const QString source = n->GetSource();
+	const QString comment = n->GetComment();
+	const QString text = n->GetText();
+
+	for (int i = 0; i < requiredRegexps.count(); ++i) {
+		QRegExp& r = requiredRegexps[i];
+		if (r.indexIn(name) == -1 && r.indexIn(author) == -1 && r.indexIn(source) == -1 &&
+			r.indexIn(comment) == -1 && r.indexIn(text) == -1) {
+			return false;
+		}
+	}
 
-				NoteFragment f(currentNote, NoteFragment::TextFragment, textMatchStart, textMatchLength, sample,
-							   sampleMatchStart, capturedText.length());
-				emit sg_SearchResult(f);
+	return true;
+}
 
+int DocumentSearchThread::countMatches(QRegExp& r, const QString& text) const {
+	int count = 0;
+	int pos = 0;
+	while ((pos = r.indexIn(text, pos)) != -1) {
+		count++;
+		pos += qMax(r.matchedLength(), 1);
+	}
+	return count;
+}
 
-			} else {
-				break;
+// Collects term frequencies of a note that matched the query. A query without separate required
+// terms is counted as a single term. Note is skipped if no term is found in it: required terms
+// are checked only for queries of several terms. Document frequencies are counted here too, so
+// only data of matched notes is kept until ranking.
+void DocumentSearchThread::collectStatistics(const Note* n) {
+	const double captionBoost = 2.0;
+	const double tagBoost = 1.5;
+	const double recencyBoost = 1.0;
+	const double recencyPeriod = 30.0; // days, note modified this long ago gets half of the boost
+
+	NoteStatistics s;
+	s.NotePtr = n;
+
+	if (!regexp.pattern().isEmpty()) {
+		QStringList fields;
+		fields << n->GetName() << n->GetAuthor() << n->GetSource() << n->GetComment()
+				<< n->GetText();
+		foreach (const QString& field, fields) {
+			s.Length += field.length();
+		}
+
+		const int termsCount = requiredRegexps.isEmpty() ? 1 : requiredRegexps.count();
+		s.TermFrequencies.reserve(termsCount);
+		bool matched = false;
+		for (int i = 0; i < termsCount; ++i) {
+			QRegExp& r = requiredRegexps.isEmpty() ? regexp : requiredRegexps[i];
+			int frequency = 0;
+			foreach (const QString& field, fields) {
+				frequency += countMatches(r, field);
 			}
-			currentPos = textMatchStart + 1;
+			s.TermFrequencies << frequency;
+			if (frequency > 0) {matched = true;}
 		}
+		// Tags are not searched for fragments, so a note matched by a tag only would show nothing
+		if (!matched) {return;}
 
-		processedNotesCount++;
-		int progress = 0;
-		if (primarySearchQueueSize != 0) {
-			progress = (int)(((qint64)processedNotesCount * 100) / primarySearchQueueSize);
+		if (regexp.indexIn(fields.at(0)) != -1) {s.Boost += captionBoost;}
+		for (int i = 0; i < n->Tags.Count(); ++i) {
+			if (regexp.indexIn(n->Tags.ItemAt(i)->GetName()) != -1) {
+				s.Boost += tagBoost;
+				break;
+			}
 		}
-		if (progress > 100) {progress = 100;}
-		emit sg_SearchProgress(progress);
 	}
 
+	const QDateTime modificationDate = n->GetModificationDate();
+	if (modificationDate.isValid()) {
+		double age = modificationDate.daysTo(searchStartTime);
+		if (age < 0) {age = 0;}
+		s.Boost += recencyBoost * recencyPeriod / (recencyPeriod + age);
+	}
 
-	regexp = QRegExp();
-	emit sg_SearchEnded();
-	SetActive(false);
-	SetCurrentNote(0);
+	QWriteLocker locker(&listLock);
+	if (documentFrequencies.size() < s.TermFrequencies.size()) {
+		documentFrequencies.resize(s.TermFrequencies.size());
+	}
+	for (int i = 0; i < s.TermFrequencies.size(); ++i) {
+		if (s.TermFrequencies.at(i) > 0) {documentFrequencies[i]++;}
+	}
+	totalLength += s.Length;
+	statistics << s;
+}
+
+// Removes note's data from statistics and its share of frequencies. Must be called under listLock
+void DocumentSearchThread::forgetStatistics(int index) {
+	const NoteStatistics& s = statistics.at(index);
+	for (int i = 0; i < s.TermFrequencies.size() && i < documentFrequencies.size(); ++i) {
+		if (s.TermFrequencies.at(i) > 0) {documentFrequencies[i]--;}
+	}
+	totalLength -= s.Length;
+	statistics.removeAt(index);
+}
+
+// Scores matched notes with BM25 plus boosts collected while scanning. IDF needs frequencies of
+// terms in all matched notes, so notes are ranked only when the scan is over. Best notes are
+// put back to the queue in order of relevance, the rest is kept in rankedTail to be fetched
+// on demand.
+void DocumentSearchThread::rankStatistics() {
+	const double k1 = 1.2;
+	const double b = 0.75;
+
+	QWriteLocker locker(&listLock);
+	searchQueue.clear();
+	if (statistics.isEmpty()) {return;}
+
+	const int termsCount = documentFrequencies.size();
+	const int notesCount = qMax(corpusSize, statistics.count());
+	const double averageLength = qMax((double)totalLength / statistics.count(), 1.0);
+	QVector<double> idf(termsCount, 0);
+	for (int i = 0; i < termsCount; ++i) {
+		const double df = documentFrequencies.at(i);
+		idf[i] = log(1.0 + (notesCount - df + 0.5) / (df + 0.5));
+	}
+
+	const int pageSize = ResultsPageSize;
+	QVector<RankedNote> top; // min-heap, the worst of best notes is at front
+	top.reserve(pageSize);
+	rankedTail.reserve(qMax(statistics.count() - pageSize, 0));
+
+	foreach (const NoteStatistics& s, statistics) {
+		const double lengthNorm = k1 * (1.0 - b + b * s.Length / averageLength);
+		double score = s.Boost;
+		for (int i = 0; i < s.TermFrequencies.size(); ++i) {
+			const double tf = s.TermFrequencies.at(i);
+			score += idf.at(i) * tf * (k1 + 1.0) / (tf + lengthNorm);
+		}
+
+		const RankedNote r(s.NotePtr, score);
+		if (top.count() < pageSize) {
+			top.append(r);
+			std::push_heap(top.begin(), top.end(), RankedNote::HasGreaterScore);
+		} else if (score > top.first().Score) {
+			std::pop_heap(top.begin(), top.end(), RankedNote::HasGreaterScore);
+			rankedTail.append(top.last());
+			top.last() = r;
+			std::push_heap(top.begin(), top.end(), RankedNote::HasGreaterScore);
+		} else {
+			rankedTail.append(r);
+		}
+	}
+
+	std::sort_heap(top.begin(), top.end(), RankedNote::HasGreaterScore);
+	foreach (const RankedNote& r, top) {
+		searchQueue.append(r.NotePtr);
+	}
 }
 
 void DocumentSearchThread::SetRegexp(const QRegExp& regexp) {
@@ -286,6 +369,25 @@ void DocumentSearchThread::SetRegexp(const QRegExp& regexp) {
 	this->regexp = regexp;
 }
 
+void DocumentSearchThread::SetRequiredRegexps(const QList<QRegExp>& list) {
+	if (isRunning()) {return;}
+
+	requiredRegexps = list;
+}
+
+void DocumentSearchThread::SetRankResults(bool rank) {
+	if (isRunning()) {return;}
+
+	rankResults = rank;
+}
+
+// Number of notes in document, used to weight rare terms
+void DocumentSearchThread::SetCorpusSize(int size) {
+	if (isRunning()) {return;}
+
+	corpusSize = size;
+}
+
 void DocumentSearchThread::AddNote(const Note* n) {
 	QWriteLocker locker(&listLock);
 	searchQueue.append(n);
@@ -294,9 +396,44 @@ void DocumentSearchThread::AddNote(const Note* n) {
 void DocumentSearchThread::RemoveNote(const Note* n) {
 	QWriteLocker locker(&listLock);
 	searchQueue.removeOne(n);
+
+	for (int i = statistics.count() - 1; i >= 0; --i) {
+		if (statistics.at(i).NotePtr == n) {forgetStatistics(i);}
+	}
+	for (int i = rankedTail.count() - 1; i >= 0; --i) {
+		if (rankedTail.at(i).NotePtr == n) {rankedTail.remove(i);}
+	}
 }
 
 void DocumentSearchThread::ClearNotesList() {
 	QWriteLocker locker(&listLock);
 	searchQueue.clear();
 }
+
+// Returns notes that were not searched yet and clears the queue
+QList<const Note*> DocumentSearchThread::TakeNotesList() {
+	QWriteLocker locker(&listLock);
+	QList<const Note*> list = searchQueue;
+	searchQueue.clear();
+	return list;
+}
+
+// Returns all notes matched by last ranked search
+QList<const Note*> DocumentSearchThread::TakeMatchedNotes() {
+	QWriteLocker locker(&listLock);
+	QList<const Note*> list;
+	list.reserve(statistics.count());
+	foreach (const NoteStatistics& s, statistics) {
+		list << s.NotePtr;
+	}
+	statistics.clear();
+	return list;
+}
+
+// Returns ranked notes that did not get into the first page of results
+QVector<RankedNote> DocumentSearchThread::TakeRankedTail() {
+	QWriteLocker locker(&listLock);
+	QVector<RankedNote> tail = rankedTail;
+	rankedTail.clear();
+	return tail;
+}
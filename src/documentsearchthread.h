@@ -22,34 +22,80 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include <QReadWriteLock>
 #include <QRegExp>
 #include <QList>
+#include <QVector>
+#include <QDateTime>
 
 #include "notefragment.h"
 
 namespace qNotesManager {
 	class Note;
 
+	class RankedNote {
+	public:
+		RankedNote() : NotePtr(0), Score(0) {}
+		RankedNote(const Note* n, double s) : NotePtr(n), Score(s) {}
+
+		const Note* NotePtr;
+		double Score;
+
+		static bool HasGreaterScore(const RankedNote& a, const RankedNote& b) {
+			return a.Score > b.Score;
+		}
+	};
+
 	class DocumentSearchThread : public QThread {
 		Q_OBJECT
 		private:
-			QRegExp regexp;
+			// Data of a matched note needed to rank it when all notes are scanned. Everything that
+			// does not depend on other notes is reduced to a single boost
+			class NoteStatistics {
+			public:
+				NoteStatistics() : NotePtr(0), Length(0), Boost(0) {}
+
+				const Note* NotePtr;
+				QVector<int> TermFrequencies;
+				int Length;
+				double Boost; // caption, tag and recency boosts
+			};
+
+			QRegExp regexp; // empty pattern means that every queued note is a result
+			QList<QRegExp> requiredRegexps; // terms that must all be found in a note
 			volatile bool isActive;
 			const Note* currentNote;
 			QList<const Note*> searchQueue;
+			bool rankResults;
+			int corpusSize;
+			QList<NoteStatistics> statistics;
+			QVector<int> documentFrequencies; // number of matched notes that contain each term
+			qint64 totalLength; // of all matched notes
+			QDateTime searchStartTime;
+			QVector<RankedNote> rankedTail;
 
 			mutable QReadWriteLock isActiveLock;
 			mutable QReadWriteLock listLock;
 
 			int primarySearchQueueSize;
+			int secondarySearchQueueSize; // notes searched for fragments after ranking
 			int processedNotesCount;
 
 			void SetCurrentNote(const Note*);
 			void SetActive(bool a);
+			void processQueue(bool collectStatistics);
+			void searchInNote();
+			void searchInField(const QString& text, NoteFragment::FragmentType type);
+			bool containsRequiredTerms(const Note*);
+			int countMatches(QRegExp& r, const QString& text) const;
+			void collectStatistics(const Note*);
+			void rankStatistics();
+			void forgetStatistics(int index);
 		protected:
 			/*virtual*/ void run();
 
 		public:
 			explicit DocumentSearchThread(QObject* parent);
 
+			static const int ResultsPageSize = 50; // results emitted at once when ranking is on
+
 			bool IsActive() const;
 			void Deactivate();
 
@@ -57,9 +103,15 @@ namespace qNotesManager {
 			const Note* CurrentNote() const;
 
 			void SetRegexp(const QRegExp& regexp);
+			void SetRequiredRegexps(const QList<QRegExp>& list);
+			void SetRankResults(bool rank);
+			void SetCorpusSize(int size);
 			void AddNote(const Note*);
 			void RemoveNote(const Note*);
 			void ClearNotesList();
+			QList<const Note*> TakeNotesList();
+			QList<const Note*> TakeMatchedNotes();
+			QVector<RankedNote> TakeRankedTail();
 
 		signals:
 			void sg_SearchResult(NoteFragment);
@@ -0,0 +1,189 @@
+/*
+This file is part of qNotesManager.
+
+qNotesManager is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+qNotesManager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "downloadscheduler.h"
+
+#include "httpimagedownloader.h"
+#include "cachedimagefile.h"
+#include "global.h"
+
+#include <QDateTime>
+
+using namespace qNotesManager;
+
+DownloadScheduler::DownloadScheduler() : QObject(0), activeCount(0) {
+	retryTimer.setSingleShot(true);
+	QObject::connect(&retryTimer, SIGNAL(timeout()), this, SLOT(sl_RetryTimer_Timeout()));
+}
+
+/*static*/
+DownloadScheduler* DownloadScheduler::I() {
+	static DownloadScheduler instance;
+	return &instance;
+}
+
+// Adds 'downloader' to requesters of 'url'. Request is started later, when limits allow
+void DownloadScheduler::Enqueue(HttpImageDownloader* downloader, const QUrl& url) {
+	if (!downloader) {
+		WARNING("Null pointer recieved");
+		return;
+	}
+
+	QMap<QUrl, Request>::iterator it = requests.find(url);
+	if (it == requests.end()) {
+		it = requests.insert(url, Request());
+		queue.append(url);
+	}
+	if (!it.value().Subscribers.contains(downloader)) {
+		it.value().Subscribers.append(downloader);
+	}
+
+	schedule();
+}
+
+void DownloadScheduler::Cancel(HttpImageDownloader* downloader, const QUrl& url) {
+	QMap<QUrl, Request>::iterator it = requests.find(url);
+	if (it == requests.end()) {return;}
+
+	Request& request = it.value();
+	request.Subscribers.removeAll(downloader);
+
+	if (request.Runner == downloader) {
+		// Somebody else may still wait for the image, request is queued again for them
+		stopRunning(url, request);
+		queue.prepend(url);
+	}
+
+	if (request.Subscribers.isEmpty()) {
+		queue.removeAll(url);
+		requests.erase(it);
+	}
+
+	schedule();
+}
+
+// Moves waiting request to the front of the queue, e.g. when its image is scrolled into view
+void DownloadScheduler::Prioritize(const QUrl& url) {
+	const int index = queue.indexOf(url);
+	if (index <= 0) {return;}
+
+	queue.move(index, 0);
+	schedule();
+}
+
+// Takes ownership of 'image'. Every requester gets its own copy
+void DownloadScheduler::Finished(const QUrl& url, CachedImageFile* image) {
+	QMap<QUrl, Request>::iterator it = requests.find(url);
+	if (it == requests.end()) {
+		WARNING("Unknown request finished");
+		delete image;
+		return;
+	}
+
+	stopRunning(url, it.value());
+	const QList<HttpImageDownloader*> subscribers = it.value().Subscribers;
+	requests.erase(it);
+
+	if (subscribers.isEmpty()) {delete image;}
+	// Receivers may start new downloads, so request is forgotten before delivering
+	for (int i = 0; i < subscribers.size(); ++i) {
+		CachedImageFile* copy = (i == subscribers.size() - 1) ? image : new CachedImageFile(*image);
+		subscribers.at(i)->deliver(url, copy);
+	}
+
+	schedule();
+}
+
+void DownloadScheduler::Failed(const QUrl& url, const QString& message) {
+	QMap<QUrl, Request>::iterator it = requests.find(url);
+	if (it == requests.end()) {
+		WARNING("Unknown request failed");
+		return;
+	}
+
+	Request& request = it.value();
+	stopRunning(url, request);
+	request.Failures++;
+	request.NextAttempt = QDateTime::currentMSecsSinceEpoch() + retryDelay(request.Failures);
+	queue.append(url);
+
+	const QList<HttpImageDownloader*> subscribers = request.Subscribers;
+	foreach (HttpImageDownloader* subscriber, subscribers) {
+		subscriber->deliverError(url, message);
+	}
+
+	schedule();
+}
+
+void DownloadScheduler::stopRunning(const QUrl& url, Request& request) {
+	if (!request.Runner) {return;}
+
+	request.Runner = 0;
+	activeCount--;
+	const QString host = url.host();
+	if (--activePerHost[host] <= 0) {activePerHost.remove(host);}
+}
+
+// Exponential delay with +-20% of jitter, so failed urls don't retry all at once
+qint64 DownloadScheduler::retryDelay(int failures) const {
+	qint64 delay = BaseRetryDelay;
+	for (int i = 1; i < failures && delay < MaxRetryDelay; ++i) {
+		delay *= 2;
+	}
+	delay = qMin(delay, MaxRetryDelay);
+
+	const qint64 jitter = delay / 5;
+	return delay - jitter + (qrand() % (2 * jitter + 1));
+}
+
+void DownloadScheduler::schedule() {
+	const qint64 now = QDateTime::currentMSecsSinceEpoch();
+	qint64 nextAttempt = 0;
+
+	for (int i = 0; i < queue.size() && activeCount < MaxActiveDownloads;) {
+		const QUrl url = queue.at(i);
+		Request& request = requests[url];
+
+		if (request.NextAttempt > now) {
+			if (nextAttempt == 0 || request.NextAttempt < nextAttempt) {
+				nextAttempt = request.NextAttempt;
+			}
+			++i;
+			continue;
+		}
+
+		const QString host = url.host();
+		if (activePerHost.value(host) >= MaxActiveDownloadsPerHost) {
+			++i;
+			continue;
+		}
+
+		queue.removeAt(i);
+		request.Runner = request.Subscribers.first();
+		activeCount++;
+		activePerHost[host]++;
+		request.Runner->start(url);
+	}
+
+	if (nextAttempt != 0) {
+		retryTimer.start(int(qMax(qint64(0), nextAttempt - now)));
+	}
+}
+
+void DownloadScheduler::sl_RetryTimer_Timeout() {
+	schedule();
+}
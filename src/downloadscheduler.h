@@ -0,0 +1,87 @@
+/*
+This file is part of qNotesManager.
+
+qNotesManager is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+qNotesManager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DOWNLOADSCHEDULER_H
+#define DOWNLOADSCHEDULER_H
+
+#include <QObject>
+#include <QUrl>
+#include <QMap>
+#include <QHash>
+#include <QList>
+#include <QTimer>
+
+/*
+  DownloadScheduler decides when HttpImageDownloader instances may start their requests. It limits
+  number of simultaneous downloads in total and per host, starts images shown in viewport first and
+  downloads an url only once when several notes need it, other requesters get copies of the image.
+  Failed urls are retried with exponential backoff and random jitter while anybody still waits for
+  them. Must be used from GUI thread.
+*/
+
+namespace qNotesManager {
+	class HttpImageDownloader;
+	class CachedImageFile;
+
+	class DownloadScheduler : public QObject {
+	Q_OBJECT
+	private:
+		explicit DownloadScheduler();
+		DownloadScheduler(const DownloadScheduler&) = delete;
+		DownloadScheduler& operator=(const DownloadScheduler&) = delete;
+		~DownloadScheduler() {}
+
+		class Request {
+		public:
+			Request() : Runner(0), Failures(0), NextAttempt(0) {}
+			QList<HttpImageDownloader*> Subscribers;
+			HttpImageDownloader* Runner; // downloader making the request now, 0 if request waits in queue
+			int Failures;
+			qint64 NextAttempt; // msecs since epoch
+		};
+
+		QMap<QUrl, Request> requests;
+		QList<QUrl> queue; // waiting requests, the first one is started first
+		QHash<QString, int> activePerHost;
+		int activeCount;
+		QTimer retryTimer;
+
+		void schedule();
+		void stopRunning(const QUrl& url, Request& request);
+		qint64 retryDelay(int failures) const;
+
+	public:
+		static DownloadScheduler* I();
+
+		static const int MaxActiveDownloads = 6;
+		static const int MaxActiveDownloadsPerHost = 2;
+		static const qint64 BaseRetryDelay = 2000;
+		static const qint64 MaxRetryDelay = 10 * 60 * 1000;
+
+		void Enqueue(HttpImageDownloader* downloader, const QUrl& url);
+		void Cancel(HttpImageDownloader* downloader, const QUrl& url);
+		void Prioritize(const QUrl& url);
+
+		void Finished(const QUrl& url, CachedImageFile* image);
+		void Failed(const QUrl& url, const QString& message);
+
+	private slots:
+		void sl_RetryTimer_Timeout();
+	};
+}
+
+#endif // DOWNLOADSCHEDULER_H
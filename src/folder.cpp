@@ -20,6 +20,7 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include "application.h"
 #include "document.h"
 #include "note.h"
+#include "itemchangebus.h"
 #include "global.h"
 
 #include <QDebug>
@@ -35,7 +36,7 @@ Folder::Folder(QString _name, FolderType _type) :
 		nameForeColor(defaultForeColor),
 		nameBackColor(defaultBackColor),
 		locked(false),
-		iconID(QString()),
+		iconIndex(0),
 		creationDate(QDateTime::currentDateTime()),
 		modificationDate(QDateTime::currentDateTime()),
 		expanded(false),
@@ -91,6 +92,7 @@ void Folder::SetName (const QString s) {
 	name = s;
 
 	emit sg_VisualPropertiesChanged();
+	notifyChanged(ItemChangeBus::NameChanged);
 	onChange();
 }
 
@@ -107,7 +109,7 @@ QPixmap Folder::GetIcon() const {
 		if (Application::I()->CurrentDocument() == 0) {
 			return QPixmap();
 		}
-		return Application::I()->CurrentDocument()->GetItemIcon(iconID);
+		return Application::I()->CurrentDocument()->GetItemIcon(iconIndex);
 	} else if (type == TrashFolder) {
 		if (Items.Count() > 0) {
 			return QPixmap(":/gui/bin-full");
@@ -122,20 +124,26 @@ QPixmap Folder::GetIcon() const {
 
 void Folder::SetIconID(const QString id) {
 	if (type != UserFolder) {return;}
-	if (iconID == id) {return;}
 	if (id.isEmpty()) {
 		WARNING("New icon id is empty");
 		return;
 	}
+	const int index = Application::I()->GetIconIndex(id);
+	if (iconIndex == index) {return;}
 
-	iconID = id;
+	iconIndex = index;
 
 	emit sg_VisualPropertiesChanged();
+	notifyChanged(ItemChangeBus::IconChanged);
 	onChange();
 }
 
 QString Folder::GetIconID() const {
-	return iconID;
+	return Application::I()->GetIconID(iconIndex);
+}
+
+int Folder::GetIconIndex() const {
+	return iconIndex;
 }
 
 QDateTime Folder::GetCreationDate() const {
@@ -157,6 +165,7 @@ void Folder::SetNameForeColor(const QColor c) {
 	nameForeColor = c;
 
 	emit sg_VisualPropertiesChanged();
+	notifyChanged(ItemChangeBus::ColorsChanged);
 	onChange();
 }
 
@@ -171,6 +180,7 @@ void Folder::SetNameBackColor(const QColor c) {
 	nameBackColor = c;
 
 	emit sg_VisualPropertiesChanged();
+	notifyChanged(ItemChangeBus::ColorsChanged);
 	onChange();
 }
 
@@ -207,6 +217,7 @@ void Folder::SetLocked(bool e) {
 	}
 
 	emit sg_VisualPropertiesChanged();
+	notifyChanged(ItemChangeBus::LockChanged);
 	onChange();
 }
 
@@ -48,7 +48,7 @@ namespace qNotesManager {
 		QColor			nameForeColor;
 		QColor			nameBackColor;
 		bool			locked;
-		QString			iconID;
+		int				iconIndex; // interned icon id, see Application::GetIconIndex
 		QDateTime		creationDate;
 		QDateTime		modificationDate;
 		bool			expanded;
@@ -68,6 +68,7 @@ namespace qNotesManager {
 		QPixmap GetIcon() const;
 		void SetIconID(const QString id);
 		QString GetIconID() const;
+		int GetIconIndex() const;
 
 		QDateTime GetCreationDate() const;
 		QDateTime GetModificationDate() const;
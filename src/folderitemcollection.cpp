@@ -174,8 +174,8 @@ void FolderItemCollection::Move(AbstractFolderItem* item, int to, Folder* newPar
 			WARNING("'to' index is out of bounds");
 			return;
 		}
-		_items.removeAll(item);
-		newParent ->Items._items.insert(to, item);
+		_items.removeOne(item);
+		newParent->Items._items.insert(to, item);
 		item->SetParent(newParent);
 	}
 
@@ -200,10 +200,10 @@ int FolderItemCollection::IndexOf(AbstractFolderItem* const item) const {
 		WARNING("Null pointer recieved");
 		return -1;
 	}
-	if (!_items.contains(item)) {
+	const int index = _items.indexOf(item);
+	if (index == -1) {
 		WARNING("The list doesn't contain specified item");
-		return -1;
 	}
 
-	return _items.indexOf(item);
+	return index;
 }
@@ -21,6 +21,8 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include <QObject>
 #include <QList>
 
+#include "indexedlist.h"
+
 /*
 FolderItemCollection is a collection of AbstractFolderItem items owned by a folder
 */
@@ -32,7 +34,7 @@ namespace qNotesManager {
 	class FolderItemCollection : public QObject {
 	Q_OBJECT
 	private:
-		QList<AbstractFolderItem*> _items;
+		IndexedList<AbstractFolderItem> _items;
 		Folder* const _owner;
 
 	public:
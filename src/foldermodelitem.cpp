@@ -33,11 +33,7 @@ FolderModelItem::FolderModelItem(Folder* _folder) :
 		folder(_folder) {
 	if (!folder) {
 		CRITICAL("Null pointer recieved");
-	} else {
-		QObject::connect(folder, SIGNAL(sg_VisualPropertiesChanged()),
-					 this, SLOT(sl_Folder_PropertiesChanged()));
 	}
-
 }
 
 QVariant FolderModelItem::data(int role) const {
@@ -109,10 +105,6 @@ Folder* FolderModelItem::GetStoredData() const {
 	return folder;
 }
 
-void FolderModelItem::sl_Folder_PropertiesChanged() {
-	emit sg_DataChanged(this);
-}
-
 // virtual
 bool FolderModelItem::LessThan(const BaseModelItem* item) const {
 	if (item->DataType() != BaseModelItem::folder) {
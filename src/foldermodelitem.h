@@ -24,7 +24,6 @@ namespace qNotesManager {
 	class Folder;
 
 	class FolderModelItem : public BaseModelItem {
-	Q_OBJECT
 	private:
 		Folder* folder;
 		void drawLockedIcon (QPixmap&) const;
@@ -42,9 +41,6 @@ namespace qNotesManager {
 		Qt::ItemFlags flags () const;
 		//virtual
 		bool LessThan(const BaseModelItem*) const;
-
-	private slots:
-		void sl_Folder_PropertiesChanged();
 	};
 }
 
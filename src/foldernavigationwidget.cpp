@@ -43,6 +43,7 @@ using namespace qNotesManager;
 
 FolderNavigationWidget::FolderNavigationWidget(QWidget *parent) : QWidget(parent) {
 	treeView = new QTreeView();
+	treeView->setUniformRowHeights(true);
 	treeView->setContextMenuPolicy(Qt::CustomContextMenu);
 	treeView->setDragEnabled(true);
 	treeView->setDropIndicatorShown(true);
@@ -754,7 +755,7 @@ void FolderNavigationWidget::sl_CustomBackColor_Triggered() {
 void FolderNavigationWidget::sl_ClearTrashAction_Triggered() {
 	Folder* f = Application::I()->CurrentDocument()->GetTrashFolder();
 	while (f->Items.Count() > 0) {
-		AbstractFolderItem* item = f->Items.ItemAt(0);
+		AbstractFolderItem* item = f->Items.ItemAt(f->Items.Count() - 1);
 		f->Items.Remove(item);
 		delete item;
 	}
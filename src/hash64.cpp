@@ -0,0 +1,146 @@
+/*
+This file is part of qNotesManager.
+
+qNotesManager is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+qNotesManager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "hash64.h"
+
+#include <QtEndian>
+
+#include <string.h>
+
+using namespace qNotesManager;
+
+namespace {
+	const quint64 Prime1 = Q_UINT64_C(0x9E3779B185EBCA87);
+	const quint64 Prime2 = Q_UINT64_C(0xC2B2AE3D27D4EB4F);
+	const quint64 Prime3 = Q_UINT64_C(0x165667B19E3779F9);
+	const quint64 Prime4 = Q_UINT64_C(0x85EBCA77C2B2AE63);
+	const quint64 Prime5 = Q_UINT64_C(0x27D4EB2F165667C5);
+
+	inline quint64 rotl(quint64 x, int r) {
+		return (x << r) | (x >> (64 - r));
+	}
+
+	inline quint64 read64(const char* p) {
+		quint64 v;
+		memcpy(&v, p, sizeof(v));
+		return qFromLittleEndian(v);
+	}
+
+	inline quint32 read32(const char* p) {
+		quint32 v;
+		memcpy(&v, p, sizeof(v));
+		return qFromLittleEndian(v);
+	}
+
+	inline quint64 round(quint64 acc, quint64 input) {
+		acc += input * Prime2;
+		acc = rotl(acc, 31);
+		return acc * Prime1;
+	}
+
+	inline quint64 mergeRound(quint64 acc, quint64 value) {
+		acc ^= round(0, value);
+		return acc * Prime1 + Prime4;
+	}
+}
+
+Hash64::Hash64(quint64 seed) :
+	v1(seed + Prime1 + Prime2),
+	v2(seed + Prime2),
+	v3(seed),
+	v4(seed - Prime1),
+	totalLength(0),
+	bufferSize(0) {
+}
+
+void Hash64::processStripe(const char* data) {
+	v1 = round(v1, read64(data));
+	v2 = round(v2, read64(data + 8));
+	v3 = round(v3, read64(data + 16));
+	v4 = round(v4, read64(data + 24));
+}
+
+void Hash64::Add(const char* data, qint64 length) {
+	if (!data || length <= 0) {return;}
+	totalLength += length;
+
+	if (bufferSize > 0) {
+		const int toCopy = int(qMin(qint64(StripeSize - bufferSize), length));
+		memcpy(buffer + bufferSize, data, toCopy);
+		bufferSize += toCopy;
+		data += toCopy;
+		length -= toCopy;
+		if (bufferSize < StripeSize) {return;}
+		processStripe(buffer);
+		bufferSize = 0;
+	}
+
+	while (length >= StripeSize) {
+		processStripe(data);
+		data += StripeSize;
+		length -= StripeSize;
+	}
+
+	if (length > 0) {
+		memcpy(buffer, data, length);
+		bufferSize = int(length);
+	}
+}
+
+quint64 Hash64::Result() const {
+	quint64 h = 0;
+	if (totalLength >= quint64(StripeSize)) {
+		h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+		h = mergeRound(h, v1);
+		h = mergeRound(h, v2);
+		h = mergeRound(h, v3);
+		h = mergeRound(h, v4);
+	} else {
+		h = v3 + Prime5; // v3 is the seed
+	}
+	h += totalLength;
+
+	const char* p = buffer;
+	const char* const end = buffer + bufferSize;
+	for (; p + 8 <= end; p += 8) {
+		h ^= round(0, read64(p));
+		h = rotl(h, 27) * Prime1 + Prime4;
+	}
+	if (p + 4 <= end) {
+		h ^= quint64(read32(p)) * Prime1;
+		h = rotl(h, 23) * Prime2 + Prime3;
+		p += 4;
+	}
+	for (; p < end; ++p) {
+		h ^= quint64(quint8(*p)) * Prime5;
+		h = rotl(h, 11) * Prime1;
+	}
+
+	h ^= h >> 33;
+	h *= Prime2;
+	h ^= h >> 29;
+	h *= Prime3;
+	h ^= h >> 32;
+	return h;
+}
+
+/*static*/
+quint64 Hash64::Of(const char* data, qint64 length) {
+	Hash64 hash;
+	hash.Add(data, length);
+	return hash.Result();
+}
@@ -0,0 +1,50 @@
+/*
+This file is part of qNotesManager.
+
+qNotesManager is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+qNotesManager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HASH64_H
+#define HASH64_H
+
+#include <QtGlobal>
+
+/*
+  Hash64 is a fast 64-bit non-cryptographic hash (XXH64 algorithm) used to identify file contents.
+  Data may be added in pieces of any size, the result is the same as for one piece.
+*/
+
+namespace qNotesManager {
+	class Hash64 {
+	private:
+		static const int StripeSize = 32;
+
+		quint64 v1, v2, v3, v4;
+		quint64 totalLength;
+		char buffer[StripeSize];	// tail of data that does not fill a stripe yet
+		int bufferSize;
+
+		void processStripe(const char* data);
+
+	public:
+		explicit Hash64(quint64 seed = 0);
+
+		void Add(const char* data, qint64 length);
+		quint64 Result() const;
+
+		static quint64 Of(const char* data, qint64 length);
+	};
+}
+
+#endif // HASH64_H
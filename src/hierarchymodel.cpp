@@ -31,36 +31,83 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 
 using namespace qNotesManager;
 
-HierarchyModel::HierarchyModel(Document* doc) : BaseModel(doc) {
-	Folder* rootFolder = doc->GetRoot();
-	if (rootFolder == 0) {
-		WARNING("Null reference");
-		return;
-	}
-	RegisterItem(rootFolder);
+HierarchyModel::HierarchyModel(Document* doc) : BaseModel(doc), document(doc), bulkUpdate(false) {
+	QObject::connect(doc->GetChangeBus(), SIGNAL(sg_ItemsChanged(const ItemChanges&)),
+					 this, SLOT(sl_ChangeBus_ItemsChanged(const ItemChanges&)));
+	rebuild();
+}
 
-	Folder* tempFolder = doc->GetTempFolder();
-	if (tempFolder == 0) {
-		WARNING("Null reference");
-		return;
+// Creates model item for the folder and all items inside of it. Children are appended in the folder
+// order, so no sorting or per-row model signals are involved
+BaseModelItem* HierarchyModel::createFolderItem(Folder* folder) {
+	QObject::connect(folder, SIGNAL(sg_ItemAdded(AbstractFolderItem* const, int)),
+					 this, SLOT(sl_Folder_ItemAdded(AbstractFolderItem* const, int)), Qt::UniqueConnection);
+	QObject::connect(folder, SIGNAL(sg_ItemAboutToBeRemoved(AbstractFolderItem*const)),
+					 this, SLOT(sl_Folder_ItemAboutToBeRemoved(AbstractFolderItem* const)), Qt::UniqueConnection);
+	QObject::connect(folder, SIGNAL(sg_ItemAboutToBeMoved(AbstractFolderItem*const, int, Folder*)),
+					 this, SLOT(sl_Folder_ItemAboutToBeMoved(AbstractFolderItem* const, int, Folder*)), Qt::UniqueConnection);
+	QObject::connect(folder, SIGNAL(sg_ItemsCollectionAboutToClear()),
+					 this, SLOT(sl_Folder_ItemsCollectionCleared()), Qt::UniqueConnection);
+
+	FolderModelItem* fi = new FolderModelItem(folder);
+	_bridge.insert(folder, fi);
+
+	for (int i = 0; i < folder->Items.Count(); ++i) {
+		AbstractFolderItem* item = folder->Items.ItemAt(i);
+		if (item->GetItemType() == AbstractFolderItem::Type_Folder) {
+			Folder* f = dynamic_cast<Folder*>(item);
+			fi->AddChild(createFolderItem(f));
+		} else {
+			Note* n = dynamic_cast<Note*>(item);
+			fi->AddChild(createNoteItem(n));
+		}
 	}
-	RegisterItem(tempFolder);
 
-	Folder* trashFolder = doc->GetTrashFolder();
-	if (trashFolder == 0) {
+	return fi;
+}
+
+BaseModelItem* HierarchyModel::createNoteItem(Note* note) {
+	NoteModelItem* noteItem = new NoteModelItem(note);
+	_bridge.insert(note, noteItem);
+	return noteItem;
+}
+
+// Builds the whole tree from document and publishes it with a single model reset
+void HierarchyModel::rebuild() {
+	Folder* rootFolder = document->GetRoot();
+	Folder* tempFolder = document->GetTempFolder();
+	Folder* trashFolder = document->GetTrashFolder();
+	if (rootFolder == 0 || tempFolder == 0 || trashFolder == 0) {
 		WARNING("Null reference");
 		return;
 	}
-	RegisterItem(trashFolder);
 
-	SeparatorModelItem* separatorItem = new SeparatorModelItem();
-	BaseModelItem* rootItem = _bridge.value(doc->GetRoot());
+	Folder* pinnedFolder = GetRootItem() != 0 ? GetPinnedFolder() : 0;
+
+	_bridge.clear();
+
+	BaseModelItem* rootItem = createFolderItem(rootFolder);
+	rootItem->AddChild(new SeparatorModelItem());
+	rootItem->AddChild(createFolderItem(tempFolder));
+	rootItem->AddChild(createFolderItem(trashFolder));
+
+	ResetRootItem(rootItem);
 
-	rootItem->AddChild(separatorItem);
-	rootItem->AddChild(_bridge.value(tempFolder));
-	rootItem->AddChild(_bridge.value(trashFolder));
+	if (pinnedFolder != 0 && _bridge.contains(pinnedFolder)) {
+		SetDisplayRootItem(_bridge.value(pinnedFolder));
+	}
+}
+
+// While bulk update is active, changes of folders are not tracked one by one. The tree is rebuilt
+// in one pass when update ends
+void HierarchyModel::BeginBulkUpdate() {
+	bulkUpdate = true;
+}
 
-	SetRootItem(rootItem);
+void HierarchyModel::EndBulkUpdate() {
+	if (!bulkUpdate) {return;}
+	bulkUpdate = false;
+	rebuild();
 }
 
 void HierarchyModel::RegisterItem(Folder* folder) { // Register folder and all items inside of it
@@ -73,33 +120,11 @@ void HierarchyModel::RegisterItem(Folder* folder) { // Register folder and all i
 		return;
 	}
 
-	QObject::connect(folder, SIGNAL(sg_ItemAdded(AbstractFolderItem* const, int)),
-					 this, SLOT(sl_Folder_ItemAdded(AbstractFolderItem* const, int)));
-	QObject::connect(folder, SIGNAL(sg_ItemAboutToBeRemoved(AbstractFolderItem*const)),
-					 this, SLOT(sl_Folder_ItemAboutToBeRemoved(AbstractFolderItem* const)));
-	QObject::connect(folder, SIGNAL(sg_ItemAboutToBeMoved(AbstractFolderItem*const, int, Folder*)),
-					 this, SLOT(sl_Folder_ItemAboutToBeMoved(AbstractFolderItem* const, int, Folder*)));
-	QObject::connect(folder, SIGNAL(sg_ItemsCollectionAboutToClear()),
-					 this, SLOT(sl_Folder_ItemsCollectionCleared()));
-
-	FolderModelItem* fi = new FolderModelItem(folder);
-	QObject::connect(fi, SIGNAL(sg_DataChanged(BaseModelItem*)), this, SLOT(sl_Item_DataChanged(BaseModelItem*)));
+	BaseModelItem* fi = createFolderItem(folder);
 	BaseModelItem* parent = _bridge.value(folder->GetParent());
 	if (parent != 0) {
 		parent->AddChildTo(fi, folder->GetParent()->Items.IndexOf(folder));
 	}
-	_bridge.insert(folder, fi);
-
-	for (int i = 0; i < folder->Items.Count(); ++i) {
-		AbstractFolderItem* item = folder->Items.ItemAt(i);
-		if (item->GetItemType() == AbstractFolderItem::Type_Folder) {
-			Folder* f = dynamic_cast<Folder*>(item);
-			RegisterItem(f);
-		} else {
-			Note* n = dynamic_cast<Note*>(item);
-			RegisterItem(n);
-		}
-	}
 }
 
 void HierarchyModel::RegisterItem(Note* note) {
@@ -114,11 +139,8 @@ void HierarchyModel::RegisterItem(Note* note) {
 
 	Folder* folder = note->GetParent();
 	BaseModelItem* parentItem = _bridge.value(folder);
-	NoteModelItem* noteItem = new NoteModelItem(note);
-	QObject::connect(noteItem, SIGNAL(sg_DataChanged(BaseModelItem*)),
-					 this, SLOT(sl_Item_DataChanged(BaseModelItem*)));
+	BaseModelItem* noteItem = createNoteItem(note);
 	parentItem->AddChildTo(noteItem, note->GetParent()->Items.IndexOf(note));
-	_bridge.insert(note, noteItem);
 }
 
 void HierarchyModel::UnregisterItem(Folder* folder) {
@@ -239,6 +261,8 @@ Folder* HierarchyModel::GetPinnedFolder() const {
 }
 
 void HierarchyModel::sl_Folder_ItemAdded(AbstractFolderItem* const item, int) {
+	if (bulkUpdate) {return;}
+
 	Folder* parent = static_cast<Folder*>(QObject::sender());
 	if (!_bridge.contains(parent)) {
 		WARNING("Unknown sender");
@@ -282,6 +306,8 @@ void HierarchyModel::sl_Folder_ItemAdded(AbstractFolderItem* const item, int) {
 }
 
 void HierarchyModel::sl_Folder_ItemAboutToBeRemoved(AbstractFolderItem* const item) {
+	if (bulkUpdate) {return;}
+
 	Folder* parent = static_cast<Folder*>(QObject::sender());
 	if (!_bridge.contains(parent)) {
 		WARNING("Unknown sender");
@@ -321,6 +347,8 @@ void HierarchyModel::sl_Folder_ItemAboutToBeRemoved(AbstractFolderItem* const it
 
 void HierarchyModel::sl_Folder_ItemAboutToBeMoved(AbstractFolderItem* const item,
 												  int newPosition, Folder* newParent) {
+	if (bulkUpdate) {return;}
+
 	Folder* parent = item->GetParent();
 	if (!_bridge.contains(parent)) {
 		WARNING("Item is not registered");
@@ -392,23 +420,20 @@ void HierarchyModel::sl_Folder_ItemsCollectionCleared() {
 	WARNING("Not implemented");
 }
 
-void HierarchyModel::sl_Item_DataChanged(BaseModelItem* modelItem) {
-	bool itemInVisibleBranch = false;
-	if (modelItem == GetDisplayRootItem() ||
-		modelItem->IsOffspringOf(GetDisplayRootItem())) {
-		itemInVisibleBranch = true;
-	}
+void HierarchyModel::sl_ChangeBus_ItemsChanged(const ItemChanges& changes) {
+	if (bulkUpdate) {return;}
 
-	if (!itemInVisibleBranch) {return;}
+	QList<BaseModelItem*> changedItems;
+	for (ItemChanges::const_iterator it = changes.constBegin(); it != changes.constEnd(); ++it) {
+		if ((it.value() & ItemChangeBus::VisualChanges) == 0) {continue;}
 
-	QModelIndex itemIndex;
-	if (modelItem->parent() == 0) {
-		itemIndex = QModelIndex();
-	} else {
-		itemIndex = createIndex(modelItem->parent()->IndexOfChild(modelItem), 0, modelItem);
+		BaseModelItem* modelItem = _bridge.value(it.key());
+		if (modelItem != 0) {
+			changedItems << modelItem;
+		}
 	}
 
-	emit dataChanged(itemIndex, itemIndex);
+	EmitItemsDataChanged(changedItems);
 }
 
 Qt::DropActions HierarchyModel::supportedDropActions () const {
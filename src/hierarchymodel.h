@@ -22,6 +22,7 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include <QMimeData>
 
 #include "basemodel.h"
+#include "itemchangebus.h"
 
 namespace qNotesManager {
 	class Folder;
@@ -33,6 +34,12 @@ namespace qNotesManager {
 	Q_OBJECT
 	private:
 		QHash<AbstractFolderItem*, BaseModelItem*>	_bridge;
+		Document* document;
+		bool bulkUpdate;
+
+		BaseModelItem* createFolderItem(Folder* folder);
+		BaseModelItem* createNoteItem(Note* note);
+		void rebuild();
 
 		void RegisterItem(Folder* folder);
 		void RegisterItem(Note* note);
@@ -54,13 +61,16 @@ namespace qNotesManager {
 		void SetPinnedFolder(Folder*);
 		Folder* GetPinnedFolder() const;
 
+		void BeginBulkUpdate();
+		void EndBulkUpdate();
+
 	private slots:
 		void sl_Folder_ItemAdded(AbstractFolderItem* const, int);
 		void sl_Folder_ItemAboutToBeRemoved(AbstractFolderItem* const);
 		void sl_Folder_ItemAboutToBeMoved(AbstractFolderItem* const, int, Folder*);
 		void sl_Folder_ItemsCollectionCleared();
 
-		void sl_Item_DataChanged(BaseModelItem*);
+		void sl_ChangeBus_ItemsChanged(const ItemChanges&);
 
 	public slots:
 		void sl_RequestEmitApplySelection(AbstractFolderItem*);
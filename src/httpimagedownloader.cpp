@@ -19,29 +19,55 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 
 #include "global.h"
 #include "cachedimagefile.h"
+#include "downloadscheduler.h"
 
 #include <QDebug>
 #include <QFile>
 #include <QFileInfo>
 #include <QImageReader>
 #include <QNetworkProxy>
+#include <QNetworkDiskCache>
+#include <QCoreApplication>
+#if QT_VERSION >= 0x050000
+#include <QStandardPaths>
+#else
+#include <QDesktopServices>
+#endif
 
 
 using namespace qNotesManager;
 
+namespace {
+	// Errors of reaching the server. Cached copy is not used when the server answered with an error
+	bool isConnectionError(QNetworkReply::NetworkError error) {
+		switch (error) {
+		case QNetworkReply::ConnectionRefusedError:
+		case QNetworkReply::RemoteHostClosedError:
+		case QNetworkReply::HostNotFoundError:
+		case QNetworkReply::TimeoutError:
+		case QNetworkReply::ProxyConnectionRefusedError:
+		case QNetworkReply::ProxyNotFoundError:
+		case QNetworkReply::ProxyTimeoutError:
+#if QT_VERSION >= 0x040700
+		case QNetworkReply::TemporaryNetworkFailureError:
+#endif
+		case QNetworkReply::UnknownNetworkError:
+			return true;
+		default:
+			return false;
+		}
+	}
+}
+
 HttpImageDownloader::HttpImageDownloader(QObject *parent) :
 		QObject(parent),
 		OriginalUrlAttribute((QNetworkRequest::Attribute)1000) {
-	manager = new QNetworkAccessManager(this);
+	manager = sharedManager();
 
 	connect(manager, SIGNAL(authenticationRequired(QNetworkReply*,QAuthenticator*)),
 			this, SLOT(sl_netManager_authenticationRequired(QNetworkReply*,QAuthenticator*)), Qt::DirectConnection);
-	connect(manager, SIGNAL(finished(QNetworkReply*)),
-			this, SLOT(sl_netManager_finished(QNetworkReply*)), Qt::DirectConnection);
 	connect(manager, SIGNAL(proxyAuthenticationRequired(QNetworkProxy,QAuthenticator*)),
 			this, SLOT(sl_netManager_proxyAuthenticationRequired(QNetworkProxy,QAuthenticator*)), Qt::DirectConnection);
-	connect(manager, SIGNAL(sslErrors(QNetworkReply*,QList<QSslError>)),
-			this, SLOT(sl_netManager_sslErrors(QNetworkReply*,QList<QSslError>)), Qt::DirectConnection);
 
 	networkErrorMessages.insert(0,		"QNetworkReply::NoError");
 	networkErrorMessages.insert(1,		"QNetworkReply::ConnectionRefusedError");
@@ -72,6 +98,55 @@ HttpImageDownloader::~HttpImageDownloader() {
 	CancelAllDownloads();
 }
 
+// All downloaders share one network manager with a persistent disk cache, so images are not
+// downloaded again in every session. Stale entries are revalidated with ETag / Last-Modified.
+/*static*/
+QNetworkAccessManager* HttpImageDownloader::sharedManager() {
+	static QNetworkAccessManager* instance = createSharedManager();
+	return instance;
+}
+
+/*static*/
+QNetworkAccessManager* HttpImageDownloader::createSharedManager() {
+	QNetworkAccessManager* manager = new QNetworkAccessManager();
+
+#if QT_VERSION >= 0x050000
+	const QString cacheLocation = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+#else
+	const QString cacheLocation = QDesktopServices::storageLocation(QDesktopServices::CacheLocation);
+#endif
+	if (!cacheLocation.isEmpty()) {
+		QNetworkDiskCache* cache = new QNetworkDiskCache(manager);
+		cache->setCacheDirectory(cacheLocation + "/images");
+		cache->setMaximumCacheSize(MaxDiskCacheSize);
+		manager->setCache(cache);
+	}
+
+	// Downloaders may be created in loading thread, replies must come to GUI thread
+	if (QCoreApplication::instance()) {
+		manager->moveToThread(QCoreApplication::instance()->thread());
+		manager->setParent(QCoreApplication::instance());
+	}
+
+	return manager;
+}
+
+QNetworkReply* HttpImageDownloader::get(const QNetworkRequest& request) {
+	QNetworkReply* reply = manager->get(request);
+	connect(reply, SIGNAL(downloadProgress(qint64,qint64)),this, SLOT(sl_reply_downloadProgress(qint64,qint64)));
+	connect(reply, SIGNAL(finished()), this, SLOT(sl_reply_finished()));
+	connect(reply, SIGNAL(sslErrors(QList<QSslError>)), this, SLOT(sl_reply_sslErrors(QList<QSslError>)));
+	return reply;
+}
+
+bool HttpImageDownloader::ownsReply(QNetworkReply* reply) const {
+	QMap<QUrl, QNetworkReply*>::const_iterator it = activeDownloads.constBegin();
+	for (; it != activeDownloads.constEnd(); ++it) {
+		if (it.value() == reply) {return true;}
+	}
+	return false;
+}
+
 void HttpImageDownloader::SetProxy(QNetworkProxy& p) {
 	manager->setProxy(p);
 }
@@ -85,29 +160,50 @@ void HttpImageDownloader::DisableProxy() {
 }
 
 void HttpImageDownloader::Download(QUrl url) {
-	if (activeDownloads.contains(url)) {return;}
+	if (requestedUrls.contains(url)) {return;}
+
+	requestedUrls.append(url);
+	DownloadScheduler::I()->Enqueue(this, url);
+}
 
-	QNetworkReply* reply = manager->get(QNetworkRequest(url));
+void HttpImageDownloader::start(const QUrl& url) {
+	activeDownloads.insert(url, get(QNetworkRequest(url)));
+}
 
-	activeDownloads.insert(url, reply);
+void HttpImageDownloader::deliver(const QUrl& url, CachedImageFile* image) {
+	requestedUrls.removeAll(url);
+	emit sg_DownloadFinished(url, image);
+}
 
-	connect(reply, SIGNAL(downloadProgress(qint64,qint64)),this, SLOT(sl_reply_downloadProgress(qint64,qint64)));
+// Url stays requested, DownloadScheduler will retry it later
+void HttpImageDownloader::deliverError(const QUrl& url, const QString& message) {
+	emit sg_DownloadError(url, message);
 }
 
 void HttpImageDownloader::CancelDownload(QUrl url) {
 	if (activeDownloads.contains(url)) {
-		activeDownloads[url]->abort();
-		activeDownloads.remove(url);
+		QNetworkReply* reply = activeDownloads.take(url);
+		// Manager is shared and outlives this object, so reply must not call us back
+		disconnectAndDeleteReply(reply);
+		reply->abort();
+	}
+
+	if (requestedUrls.removeAll(url) > 0) {
+		DownloadScheduler::I()->Cancel(this, url);
 	}
 }
 
 void HttpImageDownloader::CancelAllDownloads() {
-	foreach (QUrl url, activeDownloads.keys()) {
-		activeDownloads[url]->abort();
-		activeDownloads.remove(url);
+	foreach (QUrl url, requestedUrls) {
+		CancelDownload(url);
 	}
 }
 
+void HttpImageDownloader::Prioritize(const QUrl& url) {
+	if (!requestedUrls.contains(url)) {return;}
+	DownloadScheduler::I()->Prioritize(url);
+}
+
 QList<QUrl> HttpImageDownloader::ActiveDownloads() const {
 	return activeDownloads.keys();
 }
@@ -145,7 +241,17 @@ QUrl HttpImageDownloader::extractOriginalUrl(QNetworkReply* reply) {
 	return originalRequestUrl;
 }
 
-void HttpImageDownloader::sl_netManager_finished (QNetworkReply * reply) {
+void HttpImageDownloader::sl_reply_finished() {
+	QNetworkReply* reply = qobject_cast<QNetworkReply*>(QObject::sender());
+	if (!reply) {
+		WARNING("Casting error");
+		return;
+	}
+
+	processReply(reply);
+}
+
+void HttpImageDownloader::processReply(QNetworkReply* reply) {
 	if (!reply) {
 		WARNING("Null pointer recieved");
 		return;
@@ -161,6 +267,21 @@ void HttpImageDownloader::sl_netManager_finished (QNetworkReply * reply) {
 	qDebug() << "Reply isFinished: " << reply->isFinished() << "\n";
 
 	QNetworkReply::NetworkError error = reply->error();
+	const bool fromCache = reply->attribute(QNetworkRequest::SourceIsFromCacheAttribute).toBool();
+	// Request that already asked for cached copy only is not repeated
+	const bool cacheOnlyRequest =
+			reply->request().attribute(QNetworkRequest::CacheLoadControlAttribute).toInt() ==
+			QNetworkRequest::AlwaysCache;
+	if (isConnectionError(error) && !fromCache && !cacheOnlyRequest && manager->cache() &&
+			manager->cache()->metaData(reply->url()).isValid()) {
+		// Server is not reachable, but image was downloaded before
+		QNetworkRequest request = reply->request();
+		request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysCache);
+		request.setAttribute(OriginalUrlAttribute, originalRequestUrl);
+		activeDownloads[originalRequestUrl] = get(request);
+		disconnectAndDeleteReply(reply);
+		return;
+	}
 	if (error != QNetworkReply::NoError) {
 		qDebug() << "ERROR: Cannot load file: " << reply->request().url().toString();
 		downloadFailed(originalRequestUrl, "Cannot download file. Error type: " + networkErrorMessages[error]);
@@ -178,9 +299,7 @@ void HttpImageDownloader::sl_netManager_finished (QNetworkReply * reply) {
 		// In case of redirect put original url into OriginalUrlAttribute of new request
 		request.setAttribute(OriginalUrlAttribute, originalRequestUrl);
 
-		QNetworkReply* newReply = manager->get(request);
-		activeDownloads[originalRequestUrl] = newReply;
-		connect(newReply, SIGNAL(downloadProgress(qint64,qint64)),this, SLOT(sl_reply_downloadProgress(qint64,qint64)));
+		activeDownloads[originalRequestUrl] = get(request);
 		disconnectAndDeleteReply(reply);
 		return;
 	} else {
@@ -269,8 +388,8 @@ void HttpImageDownloader::sl_netManager_finished (QNetworkReply * reply) {
 	CachedImageFile* image = new CachedImageFile(replyData, info.fileName(), fileSuffix);
 
 	activeDownloads.remove(originalRequestUrl);
-	emit sg_DownloadFinished(originalRequestUrl, image);
 	disconnectAndDeleteReply(reply);
+	DownloadScheduler::I()->Finished(originalRequestUrl, image);
 }
 
 void HttpImageDownloader::disconnectAndDeleteReply(QNetworkReply* reply) {
@@ -285,14 +404,15 @@ void HttpImageDownloader::disconnectAndDeleteReply(QNetworkReply* reply) {
 
 void HttpImageDownloader::downloadFailed(QUrl url, QString message) {
 	activeDownloads.remove(url);
-	emit sg_DownloadError(url, message);
+	DownloadScheduler::I()->Failed(url, message);
 }
 
 void HttpImageDownloader::downloadSucceded(QUrl) {
 
 }
 
-void HttpImageDownloader::sl_netManager_authenticationRequired (QNetworkReply*, QAuthenticator*) {
+void HttpImageDownloader::sl_netManager_authenticationRequired (QNetworkReply* reply, QAuthenticator*) {
+	if (!ownsReply(reply)) {return;} // manager is shared
 	WARNING("sl_netManager_authenticationRequired");
 }
 
@@ -300,6 +420,6 @@ void HttpImageDownloader::sl_netManager_proxyAuthenticationRequired (const QNetw
 	WARNING("sl_netManager_proxyAuthenticationRequired");
 }
 
-void HttpImageDownloader::sl_netManager_sslErrors (QNetworkReply*, const QList<QSslError>&) {
-	WARNING("sl_netManager_sslError");
+void HttpImageDownloader::sl_reply_sslErrors (const QList<QSslError>&) {
+	WARNING("sl_reply_sslErrors");
 }
@@ -42,6 +42,7 @@ namespace qNotesManager {
 		/* virtual */ void Download(const QUrl);
 		/* virtual */ void CancelDownload(const QUrl);
 		/* virtual */ void CancelAllDownloads();
+		void Prioritize(const QUrl&);
 
 		QList<QUrl> ActiveDownloads() const;
 		bool HasActiveDownload(const QUrl) const;
@@ -49,14 +50,28 @@ namespace qNotesManager {
 	private:
 		const QNetworkRequest::Attribute OriginalUrlAttribute;
 
-		QNetworkAccessManager*		manager;
+		static const qint64 MaxDiskCacheSize = 50 * 1024 * 1024;
+		static QNetworkAccessManager* sharedManager();
+		static QNetworkAccessManager* createSharedManager();
+
+		QNetworkAccessManager*		manager; // shared by all downloaders
 		QMap<int, QString>			networkErrorMessages;
-		QMap<QUrl, QNetworkReply*>	activeDownloads;
+		QMap<QUrl, QNetworkReply*>	activeDownloads; // started requests
+		QList<QUrl>					requestedUrls; // started and waiting in DownloadScheduler
+
+		// Called by DownloadScheduler
+		friend class DownloadScheduler;
+		void start(const QUrl&);
+		void deliver(const QUrl&, CachedImageFile* image);
+		void deliverError(const QUrl&, const QString& message);
 
 		void downloadFailed(QUrl url, QString message);
 		void downloadSucceded(QUrl);
 		QUrl extractOriginalUrl(QNetworkReply*);
 		void disconnectAndDeleteReply(QNetworkReply*);
+		QNetworkReply* get(const QNetworkRequest&);
+		bool ownsReply(QNetworkReply*) const;
+		void processReply(QNetworkReply*);
 
 	signals:
 		void sg_DownloadFinished (QUrl url, CachedImageFile* image);
@@ -65,11 +80,11 @@ namespace qNotesManager {
 
 	private slots:
 		void sl_netManager_authenticationRequired (QNetworkReply* reply, QAuthenticator* authenticator);
-		void sl_netManager_finished (QNetworkReply* reply);
 		void sl_netManager_proxyAuthenticationRequired (const QNetworkProxy& proxy, QAuthenticator* authenticator);
-		void sl_netManager_sslErrors (QNetworkReply* reply, const QList<QSslError>& errors);
 
 		void sl_reply_downloadProgress(qint64,qint64);
+		void sl_reply_finished();
+		void sl_reply_sslErrors (const QList<QSslError>& errors);
 
 	};
 }
@@ -0,0 +1,134 @@
+/*
+This file is part of qNotesManager.
+
+qNotesManager is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+qNotesManager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "imagecache.h"
+
+#include "cachedimagefile.h"
+#include "global.h"
+
+#include <QMutexLocker>
+
+using namespace qNotesManager;
+
+ImageCache::ImageCache() : lastStamp(0) {
+	statistics.BudgetBytes = qint64(DefaultBudgetMegabytes) * 1024 * 1024;
+}
+
+/*static*/
+ImageCache* ImageCache::I() {
+	static ImageCache instance;
+	return &instance;
+}
+
+void ImageCache::touch(CachedImageFile* image, Entry& entry) {
+	if (entry.Stamp != 0) {usage.remove(entry.Stamp);}
+	entry.Stamp = ++lastStamp;
+	usage.insert(entry.Stamp, image);
+}
+
+// Drops least recently used pixmaps until cache fits the budget. 'keep' is being returned to
+// the caller right now and must survive
+void ImageCache::evict(CachedImageFile* keep) {
+	QMap<quint64, CachedImageFile*>::iterator it = usage.begin();
+	while (statistics.UsedBytes > statistics.BudgetBytes && it != usage.end()) {
+		CachedImageFile* image = it.value();
+		if (image == keep || pins.contains(image)) {
+			++it;
+			continue;
+		}
+
+		statistics.UsedBytes -= entries.value(image).Bytes;
+		statistics.Evictions++;
+		entries.remove(image);
+		it = usage.erase(it);
+		image->releasePixmaps();
+	}
+}
+
+// Registers decoded pixmaps of 'image' or updates their size
+void ImageCache::Insert(CachedImageFile* image, qint64 bytes) {
+	if (!image) {
+		WARNING("Null pointer recieved");
+		return;
+	}
+
+	QMutexLocker locker(&mutex);
+	QHash<CachedImageFile*, Entry>::iterator it = entries.find(image);
+	if (it == entries.end()) {
+		statistics.Misses++;
+		it = entries.insert(image, Entry());
+	}
+
+	statistics.UsedBytes += bytes - it.value().Bytes;
+	it.value().Bytes = bytes;
+	touch(image, it.value());
+
+	evict(image);
+}
+
+// Called when decoded image is used
+void ImageCache::Touch(CachedImageFile* image) {
+	QMutexLocker locker(&mutex);
+	QHash<CachedImageFile*, Entry>::iterator it = entries.find(image);
+	if (it == entries.end()) {return;}
+
+	statistics.Hits++;
+	touch(image, it.value());
+}
+
+// Called when image is deleted
+void ImageCache::Remove(CachedImageFile* image) {
+	QMutexLocker locker(&mutex);
+	pins.remove(image);
+
+	QHash<CachedImageFile*, Entry>::iterator it = entries.find(image);
+	if (it == entries.end()) {return;}
+
+	statistics.UsedBytes -= it.value().Bytes;
+	usage.remove(it.value().Stamp);
+	entries.erase(it);
+}
+
+void ImageCache::Pin(CachedImageFile* image) {
+	QMutexLocker locker(&mutex);
+	pins[image]++;
+}
+
+void ImageCache::Unpin(CachedImageFile* image) {
+	QMutexLocker locker(&mutex);
+	QHash<CachedImageFile*, int>::iterator it = pins.find(image);
+	if (it == pins.end()) {
+		WARNING("Image is not pinned");
+		return;
+	}
+
+	it.value()--;
+	if (it.value() == 0) {pins.erase(it);}
+
+	evict(0);
+}
+
+void ImageCache::SetBudget(qint64 bytes) {
+	QMutexLocker locker(&mutex);
+	statistics.BudgetBytes = bytes;
+	evict(0);
+}
+
+ImageCache::Statistics ImageCache::GetStatistics() {
+	QMutexLocker locker(&mutex);
+	return statistics;
+}
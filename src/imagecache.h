@@ -0,0 +1,85 @@
+/*
+This file is part of qNotesManager.
+
+qNotesManager is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+qNotesManager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef IMAGECACHE_H
+#define IMAGECACHE_H
+
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+
+/*
+  ImageCache limits memory taken by decoded note images. Every CachedImageFile reports its decoded
+  pixmaps here, when total size exceeds the budget, least recently used pixmaps are dropped. Encoded
+  data is kept, so a dropped image is decoded again when it is needed. Images of notes that are shown
+  in editor are pinned and never dropped.
+*/
+
+namespace qNotesManager {
+	class CachedImageFile;
+
+	class ImageCache {
+	public:
+		class Statistics {
+		public:
+			Statistics() : Hits(0), Misses(0), Evictions(0), UsedBytes(0), BudgetBytes(0) {}
+			quint64 Hits;		// decoded image was requested and was in memory
+			quint64 Misses;		// decoded image was requested and had to be decoded
+			quint64 Evictions;
+			qint64 UsedBytes;
+			qint64 BudgetBytes;
+		};
+
+	private:
+		ImageCache();
+		ImageCache(const ImageCache&) = delete;
+		ImageCache& operator=(const ImageCache&) = delete;
+
+		class Entry {
+		public:
+			Entry() : Stamp(0), Bytes(0) {}
+			quint64 Stamp;
+			qint64 Bytes;
+		};
+
+		QHash<CachedImageFile*, Entry> entries;
+		QMap<quint64, CachedImageFile*> usage; // last use stamp -> image, least recently used first
+		QHash<CachedImageFile*, int> pins;
+		quint64 lastStamp;
+		Statistics statistics;
+		QMutex mutex;
+
+		void touch(CachedImageFile* image, Entry& entry);
+		void evict(CachedImageFile* keep);
+
+	public:
+		static ImageCache* I();
+		static const int DefaultBudgetMegabytes = 256;
+
+		void Insert(CachedImageFile* image, qint64 bytes);
+		void Touch(CachedImageFile* image);
+		void Remove(CachedImageFile* image);
+
+		void Pin(CachedImageFile* image);
+		void Unpin(CachedImageFile* image);
+
+		void SetBudget(qint64 bytes);
+		Statistics GetStatistics();
+	};
+}
+
+#endif // IMAGECACHE_H
@@ -0,0 +1,126 @@
+/*
+This file is part of qNotesManager.
+
+qNotesManager is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+qNotesManager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "imagedecoder.h"
+
+#include "cachedimagefile.h"
+#include "textdocument.h"
+#include "global.h"
+
+#include <QRunnable>
+#include <QThread>
+#include <QMutexLocker>
+#include <QCoreApplication>
+
+using namespace qNotesManager;
+
+class ImageDecoder::DecodeTask : public QRunnable {
+private:
+	ImageDecoder* decoder;
+	const QString name;
+	const QByteArray data;
+	const QString format;
+
+public:
+	DecodeTask(ImageDecoder* d, const QString& n, const QByteArray& a, const QString& f) :
+		decoder(d), name(n), data(a), format(f) {}
+
+	void run() {
+		decoder->taskFinished(name, CachedImageFile::DecodeImage(data, format));
+	}
+};
+
+ImageDecoder::ImageDecoder() : QObject(0) {
+	// Results must come to GUI thread, whatever thread asked for the decoder first
+	if (QCoreApplication::instance()) {
+		moveToThread(QCoreApplication::instance()->thread());
+	}
+	// Leave one core for GUI thread
+	pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+}
+
+ImageDecoder::~ImageDecoder() {
+	pool.waitForDone();
+}
+
+/*static*/
+ImageDecoder* ImageDecoder::I() {
+	static ImageDecoder instance;
+	return &instance;
+}
+
+// Starts decoding of 'image' unless it is decoded or being decoded already. 'requester' gets the
+// result in its sl_ImageDecoder_ImageDecoded slot. Must be called from GUI thread
+void ImageDecoder::Decode(const CachedImageFile* image, TextDocument* requester) {
+	if (!image || !requester) {
+		WARNING("Null pointer recieved");
+		return;
+	}
+	if (image->IsDecoded()) {return;}
+
+	const QString name = image->GetMD5();
+	QList<QPointer<TextDocument> >& documents = requesters[name];
+	if (!documents.contains(requester)) {documents.append(requester);}
+
+	if (pendingImages.contains(name)) {return;}
+
+	pendingImages.insert(name);
+	pool.start(new DecodeTask(this, name, image->GetEncodedData(), image->GetFormat()));
+}
+
+// Must be called from GUI thread
+void ImageDecoder::Cancel(TextDocument* requester) {
+	QMutableHashIterator<QString, QList<QPointer<TextDocument> > > it(requesters);
+	while (it.hasNext()) {
+		it.next();
+		it.value().removeAll(requester);
+		if (it.value().isEmpty()) {it.remove();}
+	}
+}
+
+bool ImageDecoder::IsPending(const QString& name) const {
+	return pendingImages.contains(name);
+}
+
+// Called from worker threads
+void ImageDecoder::taskFinished(const QString& name, const QImage& image) {
+	QMutexLocker locker(&resultsMutex);
+	results.append(qMakePair(name, image));
+	if (results.size() == 1) {
+		QMetaObject::invokeMethod(this, "sl_DeliverResults", Qt::QueuedConnection);
+	}
+}
+
+void ImageDecoder::sl_DeliverResults() {
+	QList<QPair<QString, QImage> > decoded;
+	{
+		QMutexLocker locker(&resultsMutex);
+		decoded.swap(results);
+	}
+
+	for (int i = 0; i < decoded.size(); ++i) {
+		const QString& name = decoded.at(i).first;
+		pendingImages.remove(name);
+
+		const QList<QPointer<TextDocument> > documents = requesters.take(name);
+		foreach (const QPointer<TextDocument>& document, documents) {
+			if (document.isNull()) {continue;}
+			QMetaObject::invokeMethod(document, "sl_ImageDecoder_ImageDecoded", Qt::AutoConnection,
+									  Q_ARG(QString, name), Q_ARG(QImage, decoded.at(i).second));
+		}
+	}
+}
@@ -0,0 +1,73 @@
+/*
+This file is part of qNotesManager.
+
+qNotesManager is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+qNotesManager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef IMAGEDECODER_H
+#define IMAGEDECODER_H
+
+#include <QObject>
+#include <QThreadPool>
+#include <QMutex>
+#include <QImage>
+#include <QString>
+#include <QList>
+#include <QPair>
+#include <QSet>
+#include <QHash>
+#include <QPointer>
+
+/*
+  ImageDecoder decodes note images into QImage in a pool of worker threads, so opening a note with
+  many big pictures does not freeze the editor. Workers decode a copy of image data and never touch
+  the image itself. Results are delivered in GUI thread to the documents that requested the image
+  only.
+*/
+
+namespace qNotesManager {
+	class CachedImageFile;
+	class TextDocument;
+
+	class ImageDecoder : public QObject {
+	Q_OBJECT
+	private:
+		class DecodeTask;
+
+		explicit ImageDecoder();
+		ImageDecoder(const ImageDecoder&) = delete;
+		ImageDecoder& operator=(const ImageDecoder&) = delete;
+		~ImageDecoder();
+
+		QThreadPool pool;
+		QSet<QString> pendingImages; // used in GUI thread only
+		QHash<QString, QList<QPointer<TextDocument> > > requesters; // used in GUI thread only
+
+		QMutex resultsMutex;
+		QList<QPair<QString, QImage> > results;
+		void taskFinished(const QString& name, const QImage& image);
+
+	public:
+		static ImageDecoder* I();
+
+		void Decode(const CachedImageFile* image, TextDocument* requester);
+		void Cancel(TextDocument* requester);
+		bool IsPending(const QString& name) const;
+
+	private slots:
+		void sl_DeliverResults();
+	};
+}
+
+#endif // IMAGEDECODER_H
@@ -50,6 +50,18 @@ void ImageLoader::Download(const QUrl url) {
 	}
 }
 
+// Starts download of 'url' before other waiting ones
+void ImageLoader::Prioritize(const QUrl& url) {
+	if (url.scheme() == "http" || url.scheme() == "https") {
+		httpImageLoader->Prioritize(url);
+	}
+}
+
+// Failed http downloads are retried by DownloadScheduler, other ones must be requested again
+bool ImageLoader::RetriesFailedDownloads(const QUrl& url) const {
+	return url.scheme() == "http" || url.scheme() == "https";
+}
+
 void ImageLoader::CancelAllDownloads() {
 	localImageLoader->CancelAllDownloads();
 	httpImageLoader->CancelAllDownloads();
@@ -38,6 +38,8 @@ namespace qNotesManager {
 
 		void Download(const QUrl);
 		void CancelAllDownloads();
+		void Prioritize(const QUrl&);
+		bool RetriesFailedDownloads(const QUrl&) const;
 
 	signals:
 		void sg_DownloadFinished (QUrl url, CachedImageFile* image);
@@ -0,0 +1,84 @@
+/*
+This file is part of qNotesManager.
+
+qNotesManager is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+qNotesManager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "imagestore.h"
+
+#include "cachedimagefile.h"
+#include "global.h"
+
+#include <QMutexLocker>
+
+using namespace qNotesManager;
+
+ImageStore::ImageStore() {
+}
+
+/*static*/
+ImageStore* ImageStore::I() {
+	static ImageStore instance;
+	return &instance;
+}
+
+// Takes ownership of 'image' and returns image that must be used instead. If an image with the same
+// data is already stored, 'image' is deleted and the stored one is returned
+CachedImageFile* ImageStore::Acquire(CachedImageFile* image) {
+	if (!image) {
+		WARNING("Null pointer recieved");
+		return 0;
+	}
+
+	const quint64 key = image->GetHash();
+	QMutexLocker locker(&mutex);
+
+	QMultiHash<quint64, Entry>::iterator it = images.find(key);
+	for (; it != images.end() && it.key() == key; ++it) {
+		CachedImageFile* storedImage = it.value().first;
+		if (storedImage != image && !storedImage->HasSameDataAs(image)) {continue;}
+
+		it.value().second++;
+		if (storedImage != image) {
+			delete image;
+		}
+		return storedImage;
+	}
+
+	images.insert(key, qMakePair(image, 1));
+	return image;
+}
+
+void ImageStore::Release(CachedImageFile* image) {
+	if (!image) {
+		WARNING("Null pointer recieved");
+		return;
+	}
+
+	const quint64 key = image->GetHash();
+	QMutexLocker locker(&mutex);
+
+	QMultiHash<quint64, Entry>::iterator it = images.find(key);
+	while (it != images.end() && it.key() == key && it.value().first != image) {++it;}
+	if (it == images.end() || it.key() != key) {
+		WARNING("Image is not in the store");
+		return;
+	}
+
+	it.value().second--;
+	if (it.value().second == 0) {
+		images.erase(it);
+		delete image;
+	}
+}
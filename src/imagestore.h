@@ -0,0 +1,53 @@
+/*
+This file is part of qNotesManager.
+
+qNotesManager is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+qNotesManager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef IMAGESTORE_H
+#define IMAGESTORE_H
+
+#include <QMultiHash>
+#include <QPair>
+#include <QMutex>
+
+/*
+  ImageStore keeps a single copy of every note image in memory, keyed by fast hash of image data.
+  Images with equal hashes are compared byte by byte, so a hash collision never merges two images.
+  Text documents acquire images they show and release them when they are destroyed, the image is
+  deleted when nobody uses it. Images are acquired from loading thread too, so access is locked.
+*/
+
+namespace qNotesManager {
+	class CachedImageFile;
+
+	class ImageStore {
+	private:
+		ImageStore();
+		ImageStore(const ImageStore&) = delete;
+		ImageStore& operator=(const ImageStore&) = delete;
+
+		typedef QPair<CachedImageFile*, int> Entry;	// image and references count
+		QMultiHash<quint64, Entry> images;
+		QMutex mutex;
+
+	public:
+		static ImageStore* I();
+
+		CachedImageFile* Acquire(CachedImageFile* image);
+		void Release(CachedImageFile* image);
+	};
+}
+
+#endif // IMAGESTORE_H
@@ -0,0 +1,159 @@
+/*
+This file is part of qNotesManager.
+
+qNotesManager is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+qNotesManager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INDEXEDLIST_H
+#define INDEXEDLIST_H
+
+#include <QList>
+#include <QHash>
+
+/*
+  IndexedList is an ordered list of unique pointers with a pointer-to-position hash, so
+  membership tests and position lookups do not scan the list. Positions after an insertion or
+  move are renumbered lazily, on the next lookup of a shifted item. Removed items leave a hole
+  that is dropped on the next positional access, so removing many items costs one pass.
+*/
+
+namespace qNotesManager {
+	template<class T>
+	class IndexedList {
+	private:
+		mutable QList<T*> items;			// removed items are kept as null until compaction
+		mutable QHash<T*, int> positions;	// positions in 'items'
+		mutable int firstStalePosition;		// positions of items starting from this one may be wrong
+		mutable int removedCount;
+		mutable int firstRemovedPosition;
+
+		void invalidateFrom(int index) const {
+			if (index < firstStalePosition) {firstStalePosition = index;}
+		}
+
+		int rawIndexOf(T* item) const {
+			typename QHash<T*, int>::const_iterator it = positions.constFind(item);
+			if (it == positions.constEnd()) {return -1;}
+
+			const int position = it.value();
+			if (position < firstStalePosition) {return position;}
+
+			for (int i = firstStalePosition; i < items.size(); ++i) {
+				if (items.at(i) != 0) {positions[items.at(i)] = i;}
+			}
+			firstStalePosition = items.size();
+			return positions.value(item);
+		}
+
+		// Drops holes left by removed items
+		void compact() const {
+			if (removedCount == 0) {return;}
+
+			int to = firstRemovedPosition;
+			for (int from = firstRemovedPosition; from < items.size(); ++from) {
+				if (items.at(from) != 0) {items[to++] = items.at(from);}
+			}
+			items.erase(items.begin() + to, items.end());
+
+			invalidateFrom(firstRemovedPosition);
+			removedCount = 0;
+		}
+
+		void markRemoved(int index) {
+			items[index] = 0;
+			if (removedCount == 0 || index < firstRemovedPosition) {firstRemovedPosition = index;}
+			removedCount++;
+		}
+
+	public:
+		IndexedList() : firstStalePosition(0), removedCount(0), firstRemovedPosition(0) {}
+
+		int count() const {return items.count() - removedCount;}
+		int size() const {return count();}
+		bool isEmpty() const {return count() == 0;}
+		T* at(int index) const {compact(); return items.at(index);}
+		const QList<T*>& toList() const {compact(); return items;}
+
+		bool contains(T* item) const {return positions.contains(item);}
+
+		int indexOf(T* item) const {
+			compact();
+			return rawIndexOf(item);
+		}
+
+		// Item must not be in the list already
+		void append(T* item) {
+			const int index = items.size();
+			items.append(item);
+			positions.insert(item, index);
+			if (firstStalePosition == index) {firstStalePosition++;}
+		}
+
+		// Item must not be in the list already
+		void insert(int index, T* item) {
+			compact();
+			if (index == items.size()) {
+				append(item);
+				return;
+			}
+			items.insert(index, item);
+			positions.insert(item, index);
+			invalidateFrom(index);
+		}
+
+		bool removeOne(T* item) {
+			const int index = rawIndexOf(item);
+			if (index == -1) {return false;}
+
+			positions.remove(item);
+			if (index == items.size() - 1) {
+				items.removeLast();
+				if (firstStalePosition > items.size()) {firstStalePosition = items.size();}
+			} else {
+				markRemoved(index);
+			}
+			return true;
+		}
+
+		// Removes all listed items in one pass, returns number of removed items
+		int removeAll(const QList<T*>& list) {
+			int removed = 0;
+			foreach (T* item, list) {
+				const int index = rawIndexOf(item);
+				if (index == -1) {continue;}
+				positions.remove(item);
+				markRemoved(index);
+				removed++;
+			}
+			compact();
+			return removed;
+		}
+
+		void move(int from, int to) {
+			compact();
+			items.move(from, to);
+			invalidateFrom(qMin(from, to));
+		}
+
+		void clear() {
+			items.clear();
+			positions.clear();
+			firstStalePosition = 0;
+			removedCount = 0;
+			firstRemovedPosition = 0;
+		}
+	};
+}
+
+#endif // INDEXEDLIST_H
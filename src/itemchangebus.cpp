@@ -0,0 +1,58 @@
+/*
+This file is part of qNotesManager.
+
+qNotesManager is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+qNotesManager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "itemchangebus.h"
+
+#include "global.h"
+
+using namespace qNotesManager;
+
+ItemChangeBus::ItemChangeBus(QObject* parent) : QObject(parent),
+		flushScheduled(false) {
+}
+
+// Remembers item change. Subscribers are notified when control returns to event loop
+void ItemChangeBus::Post(AbstractFolderItem* item, int changes) {
+	if (!item) {
+		WARNING("Null pointer recieved");
+		return;
+	}
+	if (changes == 0) {return;}
+
+	pendingChanges[item] |= changes;
+
+	if (!flushScheduled) {
+		flushScheduled = true;
+		QMetaObject::invokeMethod(this, "sl_Flush", Qt::QueuedConnection);
+	}
+}
+
+// Drops pending changes of item, that is going to be deleted or removed from document
+void ItemChangeBus::Forget(AbstractFolderItem* item) {
+	pendingChanges.remove(item);
+}
+
+void ItemChangeBus::sl_Flush() {
+	flushScheduled = false;
+	if (pendingChanges.isEmpty()) {return;}
+
+	// Subscribers may post new changes, they will be delivered on next iteration
+	const ItemChanges changes = pendingChanges;
+	pendingChanges.clear();
+
+	emit sg_ItemsChanged(changes);
+}
@@ -0,0 +1,71 @@
+/*
+This file is part of qNotesManager.
+
+qNotesManager is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+qNotesManager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ITEMCHANGEBUS_H
+#define ITEMCHANGEBUS_H
+
+#include <QObject>
+#include <QHash>
+
+/*
+  ItemChangeBus collects changes of document's notes and folders and delivers them to subscribers
+  once per event loop iteration. Several changes of the same item are merged into a single mask, so
+  models and indexes subscribe to the bus once instead of connecting to every item.
+*/
+
+namespace qNotesManager {
+	class AbstractFolderItem;
+
+	typedef QHash<AbstractFolderItem*, int> ItemChanges; // item -> mask of ItemChangeBus::ChangeFlag
+
+	class ItemChangeBus : public QObject {
+	Q_OBJECT
+	public:
+		enum ChangeFlag {
+			NameChanged =		0x0001,
+			IconChanged =		0x0002,
+			ColorsChanged =		0x0004,
+			LockChanged =		0x0008,
+			ParentChanged =		0x0010,
+			TextChanged =		0x0020,
+			PropertiesChanged =	0x0040, // author, source, comment
+			TagsChanged =		0x0080,
+			ModifyDateChanged =	0x0100, // only when the day changes
+			TextDateChanged =	0x0200,
+
+			VisualChanges = NameChanged | IconChanged | ColorsChanged | LockChanged
+		};
+
+	private:
+		ItemChanges pendingChanges;
+		bool flushScheduled;
+
+	public:
+		explicit ItemChangeBus(QObject* parent = 0);
+
+		void Post(AbstractFolderItem* item, int changes);
+		void Forget(AbstractFolderItem* item);
+
+	signals:
+		void sg_ItemsChanged(const ItemChanges&);
+
+	private slots:
+		void sl_Flush();
+	};
+}
+
+#endif // ITEMCHANGEBUS_H
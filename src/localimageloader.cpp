@@ -17,96 +17,176 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 
 #include "localimageloader.h"
 
-#include <QTimer>
 #include <QFileInfo>
-#include <QDebug>
-
+#include <QRunnable>
+#include <QThread>
+#include <QMutexLocker>
+#include <QCoreApplication>
 
+#include "global.h"
 #include "cachedimagefile.h"
 
 using namespace qNotesManager;
 
-void LocalImageLoadWorker::sl_process() {
-	while(true) {
-		lock.lockForRead();
-		if (queue.isEmpty()) {
-			SetNeedRestart(true);
-			lock.unlock();
-			break;
-		}
-		lock.unlock();
+class LocalImageLoadPool::LoadTask : public QRunnable {
+private:
+	LocalImageLoadPool* owner;
+	const QString path;
 
-		lock.lockForWrite();
-		QUrl url = queue.takeFirst();
-		lock.unlock();
+public:
+	LoadTask(LocalImageLoadPool* o, const QString& p) : owner(o), path(p) {}
 
-		QFileInfo info(url.toLocalFile());
-		if (!info.exists()) {
-			emit sg_DownloadError(url, "File does not exists");
+	void run() {
+		LoadResult result;
+		result.Path = path;
+
+		if (!QFileInfo(path).exists()) {
+			result.Error = "File does not exists";
 		} else {
-			CachedImageFile* image = CachedImageFile::FromFile(info.absoluteFilePath());
-			emit sg_DownloadFinished(url, image);
+			result.Image = CachedImageFile::FromFile(path);
+			if (!result.Image) {
+				result.Error = "Could not read file";
+			} else {
+				// checksums are cached inside and copied with the image
+				result.Image->GetMD5();
+				result.Image->GetHash();
+				result.Decoded = CachedImageFile::DecodeImage(result.Image->GetEncodedData(),
+															  result.Image->GetFormat());
+			}
 		}
+
+		owner->taskFinished(result);
 	}
+};
 
-	emit sg_finished();
+LocalImageLoadPool::LocalImageLoadPool() : QObject(0) {
+	// Results must come to GUI thread, whatever thread asked for the pool first
+	if (QCoreApplication::instance()) {
+		moveToThread(QCoreApplication::instance()->thread());
+	}
+	pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount(), MaxThreads));
 }
 
-void LocalImageLoadWorker::AddUrl(const QUrl& url) {
-	lock.lockForWrite();
-	queue.append(url);
-	lock.unlock();
+LocalImageLoadPool::~LocalImageLoadPool() {
+	pool.waitForDone();
+	foreach (const LoadResult& result, results) {
+		delete result.Image;
+	}
 }
 
-void LocalImageLoadWorker::CancelAllDownloads() {
-	lock.lockForWrite();
-	queue.clear();
-	lock.unlock();
+/*static*/
+LocalImageLoadPool* LocalImageLoadPool::I() {
+	static LocalImageLoadPool instance;
+	return &instance;
 }
 
-bool LocalImageLoadWorker::NeedRestart() const {
-	QReadLocker locker(&NRlock);
-	return needRestart;
+// Must be called from GUI thread
+void LocalImageLoadPool::Load(const QString& path, LocalImageLoader* requester) {
+	if (!requester) {
+		WARNING("Null pointer recieved");
+		return;
+	}
+
+	QList<QPointer<LocalImageLoader> >& loaders = requesters[path];
+	if (!loaders.contains(requester)) {loaders.append(requester);}
+
+	if (pendingPaths.contains(path)) {return;}
+
+	pendingPaths.insert(path);
+	pool.start(new LoadTask(this, path));
 }
 
-void LocalImageLoadWorker::SetNeedRestart(bool v) {
-	QWriteLocker locker(&NRlock);
-	needRestart = v;
+// Must be called from GUI thread
+void LocalImageLoadPool::Cancel(LocalImageLoader* requester) {
+	QMutableHashIterator<QString, QList<QPointer<LocalImageLoader> > > it(requesters);
+	while (it.hasNext()) {
+		it.next();
+		it.value().removeAll(requester);
+		if (it.value().isEmpty()) {it.remove();}
+	}
 }
 
-LocalImageLoader::LocalImageLoader(QObject *parent) : QObject (parent) {
-	thread = new QThread(this);
-	worker = new LocalImageLoadWorker();
-	// do not set worker's parent because it will be moved to another thread
-	worker->moveToThread(thread);
+// Called from worker threads
+void LocalImageLoadPool::taskFinished(const LoadResult& result) {
+	QMutexLocker locker(&resultsMutex);
+	results.append(result);
+	if (results.size() == 1) {
+		QMetaObject::invokeMethod(this, "sl_DeliverResults", Qt::QueuedConnection);
+	}
+}
 
-	QObject::connect(thread, SIGNAL(started()), worker, SLOT(sl_process()));
-	QObject::connect(worker, SIGNAL(sg_finished()), thread, SLOT(quit()));
+void LocalImageLoadPool::sl_DeliverResults() {
+	QList<LoadResult> loaded;
+	{
+		QMutexLocker locker(&resultsMutex);
+		loaded.swap(results);
+	}
 
-	QObject::connect(worker, SIGNAL(sg_DownloadError(QUrl,QString)),
-					 this, SIGNAL(sg_DownloadError(QUrl,QString)), Qt::QueuedConnection);
-	QObject::connect(worker, SIGNAL(sg_DownloadFinished(QUrl,CachedImageFile*)),
-					 this, SIGNAL(sg_DownloadFinished(QUrl,CachedImageFile*)), Qt::QueuedConnection);
+	foreach (const LoadResult& result, loaded) {
+		pendingPaths.remove(result.Path);
+		const QList<QPointer<LocalImageLoader> > loaders = requesters.take(result.Path);
+
+		QByteArray data;
+		QString format;
+		QString md5;
+		quint64 hash = 0;
+		if (result.Image) {
+			data = result.Image->GetEncodedData();
+			format = result.Image->GetFormat();
+			md5 = result.Image->GetMD5();
+			hash = result.Image->GetHash();
+			delete result.Image;
+		}
 
+		foreach (const QPointer<LocalImageLoader>& loader, loaders) {
+			if (loader.isNull()) {continue;}
+			QMetaObject::invokeMethod(loader, "sl_Pool_FileLoaded", Qt::AutoConnection,
+									  Q_ARG(QString, result.Path), Q_ARG(QByteArray, data),
+									  Q_ARG(QString, format), Q_ARG(QString, md5),
+									  Q_ARG(quint64, hash), Q_ARG(QImage, result.Decoded),
+									  Q_ARG(QString, result.Error));
+		}
+	}
+}
+
+
+LocalImageLoader::LocalImageLoader(QObject *parent) : QObject (parent) {
 }
 
 LocalImageLoader::~LocalImageLoader() {
-	if (thread->isRunning()) {
-		worker->CancelAllDownloads();
-		thread->wait();
-	}
-	delete worker;
+	LocalImageLoadPool::I()->Cancel(this);
 }
 
 void LocalImageLoader::Download(const QUrl& url) {
-	worker->AddUrl(url);
-	if (worker->NeedRestart()) {
-		thread->wait();
-		worker->SetNeedRestart(false);
-		thread->start();
-	}
+	const QString path = QFileInfo(url.toLocalFile()).absoluteFilePath();
+	QList<QUrl>& urls = requests[path];
+	if (!urls.contains(url)) {urls.append(url);}
+
+	LocalImageLoadPool::I()->Load(path, this);
 }
 
 void LocalImageLoader::CancelAllDownloads() {
-	worker->CancelAllDownloads();
+	requests.clear();
+	LocalImageLoadPool::I()->Cancel(this);
+}
+
+void LocalImageLoader::sl_Pool_FileLoaded(const QString& path, const QByteArray& data,
+										  const QString& format, const QString& md5, quint64 hash,
+										  const QImage& decoded, const QString& error) {
+	if (!requests.contains(path)) {return;}
+
+	const QList<QUrl> urls = requests.take(path);
+	foreach (const QUrl& url, urls) {
+		if (!error.isEmpty()) {
+			emit sg_DownloadError(url, error);
+			continue;
+		}
+
+		// Every receiver owns its image
+		CachedImageFile* image = new CachedImageFile(data, QFileInfo(path).fileName(), format);
+		image->SetMD5(md5);
+		image->SetHash(hash);
+		if (!decoded.isNull()) {image->SetDecodedImage(decoded);}
+		emit sg_DownloadFinished(url, image);
+	}
 }
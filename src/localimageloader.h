@@ -21,44 +21,64 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include <QObject>
 #include <QList>
 #include <QUrl>
-#include <QReadWriteLock>
-#include <QThread>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <QImage>
+#include <QThreadPool>
+#include <QPointer>
 
 namespace qNotesManager {
 	class CachedImageFile;
-
-	class LocalImageLoadWorker : public QObject {
+	class LocalImageLoader;
+
+	/*
+	  LocalImageLoadPool reads, hashes and decodes local image files in a bounded pool of threads. It
+	  is shared by all loaders, a file requested several times is read once. Results are passed by
+	  value to the loaders that requested the file only, so they survive queued delivery when a
+	  loader lives in another thread.
+	*/
+	class LocalImageLoadPool : public QObject {
 		Q_OBJECT
 	private:
-		QList<QUrl> queue;
-		mutable QReadWriteLock lock;
-
-		mutable bool needRestart;
-		mutable QReadWriteLock NRlock;
+		class LoadTask;
+		class LoadResult {
+		public:
+			LoadResult() : Image(0) {}
+			QString Path;
+			CachedImageFile* Image;
+			QImage Decoded;
+			QString Error;
+		};
+
+		explicit LocalImageLoadPool();
+		LocalImageLoadPool(const LocalImageLoadPool&) = delete;
+		LocalImageLoadPool& operator=(const LocalImageLoadPool&) = delete;
+		~LocalImageLoadPool();
+
+		static const int MaxThreads = 4;
+		QThreadPool pool;
+		QSet<QString> pendingPaths; // used in GUI thread only
+		QHash<QString, QList<QPointer<LocalImageLoader> > > requesters; // used in GUI thread only
+
+		QMutex resultsMutex;
+		QList<LoadResult> results;
+		void taskFinished(const LoadResult& result);
 
 	public:
-		explicit LocalImageLoadWorker() : QObject(0), needRestart(true) {}
-		void AddUrl(const QUrl&);
-		void CancelAllDownloads();
+		static LocalImageLoadPool* I();
 
-		bool NeedRestart() const;
-		void SetNeedRestart(bool);
+		void Load(const QString& path, LocalImageLoader* requester);
+		void Cancel(LocalImageLoader* requester);
 
-	signals:
-		void sg_DownloadFinished (QUrl url, CachedImageFile* image);
-		void sg_DownloadError (QUrl url, QString errorDescription);
-
-		void sg_finished();
-
-	public slots:
-		void sl_process();
+	private slots:
+		void sl_DeliverResults();
 	};
 
 	class LocalImageLoader : public QObject {
 	Q_OBJECT
 	private:
-		QThread* thread;
-		LocalImageLoadWorker* worker;
+		QHash<QString, QList<QUrl> > requests; // file path -> urls that point to it
 
 	public:
 		explicit LocalImageLoader(QObject *parent);
@@ -71,6 +91,11 @@ namespace qNotesManager {
 		void sg_DownloadFinished (QUrl url, CachedImageFile* image);
 		void sg_DownloadError (QUrl url, QString errorDescription);
 		void sg_Progress(QUrl url, int percent);
+
+	private slots:
+		void sl_Pool_FileLoaded(const QString& path, const QByteArray& data, const QString& format,
+								const QString& md5, quint64 hash, const QImage& decoded,
+								const QString& error);
 	};
 }
 
@@ -26,6 +26,7 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include "mainwindow.h"
 #include "application.h"
 #include "appinfo.h"
+#include "cachedfile.h"
 
 
 using namespace qNotesManager;
@@ -41,6 +42,7 @@ bool errorOutput;
 int main(int argc, char** argv) {
 	QApplication app(argc, argv);
 	app.setQuitOnLastWindowClosed(false);
+	CachedFile::InitStorage();
 
 	QString helpScreenText = QString().append("Usage: \n").append(VER_PRODUCTNAME_STR).append(
 			" [-v] [-h] [options] [file]\n"
@@ -91,7 +93,9 @@ int main(int argc, char** argv) {
 		w.OpenDocument(Application::I()->Settings.GetLastDocumentName());
 	}
 
-	return app.exec();
+	const int result = app.exec();
+	CachedFile::ClearStorage();
+	return result;
 }
 
 #if QT_VERSION >= 0x050000
@@ -34,6 +34,7 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include "appinfo.h"
 #include "bookmarksmenu.h"
 #include "custommessagebox.h"
+#include "quickopenwidget.h"
 
 #include <QDebug>
 #include <QHBoxLayout>
@@ -127,6 +128,13 @@ void MainWindow::createActions() {
 	globalSearchAction->setShortcut(QKeySequence(Qt::ControlModifier |Qt::ShiftModifier | Qt::Key_F));
 	globalSearchAction->setEnabled(false);
 
+	goToNoteAction = new QAction("Go to note...", this);
+	goToNoteAction->setToolTip("Find note by caption");
+	QObject::connect(goToNoteAction, SIGNAL(triggered()),
+					 this, SLOT(sl_GoToNoteAction_Triggered()));
+	goToNoteAction->setShortcut(QKeySequence(Qt::ControlModifier | Qt::Key_P));
+	goToNoteAction->setEnabled(false);
+
 	exitAction = new QAction(QPixmap(":/gui/power"), "Exit", this);
 	QObject::connect(exitAction, SIGNAL(triggered()),
 					 this, SLOT(sl_ExitAction_Triggered()));
@@ -252,6 +260,7 @@ void MainWindow::createControls() {
 	documentMenu->addAction(documentPropertiesAction);
 	documentMenu->addSeparator();
 	documentMenu->addAction(globalSearchAction);
+	documentMenu->addAction(goToNoteAction);
 	documentMenu->addSeparator();
 	documentMenu->addMenu(recentFilesMenu);
 	documentMenu->addSeparator();
@@ -521,6 +530,16 @@ void MainWindow::sl_GlobalSearchAction_Triggered() {
 	searchWidget->show();
 }
 
+void MainWindow::sl_GoToNoteAction_Triggered() {
+	Document* doc = Application::I()->CurrentDocument();
+	if (!doc) {return;}
+
+	QuickOpenWidget w(doc, this);
+	if (w.exec() == QDialog::Accepted && w.SelectedNote() != 0) {
+		notesTabWidget->OpenNote(w.SelectedNote());
+	}
+}
+
 void MainWindow::sl_SearchResults_CloseRequest() {
 	searchResultsWidget->hide();
 }
@@ -560,6 +579,7 @@ void MainWindow::sl_ApplicationSettingsAction_Triggered() {
 	if (w.exec() == QDialog::Accepted) {
 		trayIcon->setVisible(Application::I()->Settings.GetShowSystemTray());
 		navigationPanel->UpdateViewsVisibility();
+		navigationPanel->UpdateItemsText();
 	}
 }
 
@@ -619,6 +639,7 @@ void MainWindow::sl_Application_CurrentDocumentChanged(Document* oldDoc) {
 	closeDocumentAction->setEnabled(enable);
 	documentPropertiesAction->setEnabled(enable);
 	globalSearchAction->setEnabled(enable);
+	goToNoteAction->setEnabled(enable);
 	sl_Clipboard_DataChanged();
 
 
@@ -80,6 +80,7 @@ namespace qNotesManager {
 		QAction* closeDocumentAction;
 		QAction* documentPropertiesAction;
 		QAction* globalSearchAction;
+		QAction* goToNoteAction;
 		QAction* exitAction;
 		QMenu* recentFilesMenu;
 
@@ -162,6 +163,7 @@ namespace qNotesManager {
 		void sl_CloseDocumentAction_Triggered(bool* actionCancelled = 0, bool* actionDelayed = 0, bool suppressSaving = false);
 		void sl_DocumentPropertiesAction_Triggered();
 		void sl_GlobalSearchAction_Triggered();
+		void sl_GoToNoteAction_Triggered();
 		void sl_OpenRecentFileAction_Triggered();
 		void sl_ExitAction_Triggered();
 
@@ -22,6 +22,8 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 
 #include <QPainter>
 #include <QItemEditorFactory>
+#include <QApplication>
+#include <QStyle>
 
 using namespace qNotesManager;
 
@@ -39,11 +41,59 @@ void ModelItemDelegate::paint (QPainter* painter, const QStyleOptionViewItem& op
 		WARNING("Null pointer recieved");
 		return;
 	}
-	if (item->DataType() != BaseModelItem::Separator) {
-		QItemDelegate::paint(painter, option, index);
+	if (item->DataType() == BaseModelItem::Separator) {
+		paintSeparator(painter, option);
 		return;
 	}
 
+	const QStyleOptionViewItem opt = setOptions(index, option);
+	PaintCache& cache = cachedData(item, index, opt);
+
+	const int textMargin = QApplication::style()->pixelMetric(QStyle::PM_FocusFrameHMargin) + 1;
+	QRect checkRect;
+	QRect decorationRect = cache.icon.isNull() ? QRect() : QRect(QPoint(0, 0), cache.icon.size());
+	QRect displayRect(0, 0, cache.textWidth + 2 * textMargin, opt.fontMetrics.height());
+	doLayout(opt, &checkRect, &decorationRect, &displayRect, false);
+
+	painter->save();
+		drawBackground(painter, opt, index);
+		if (!cache.icon.isNull()) {
+			drawDecoration(painter, opt, decorationRect, cache.icon);
+		}
+		paintText(painter, opt, displayRect, cache);
+		drawFocus(painter, opt, displayRect);
+	painter->restore();
+}
+
+// Same as QItemDelegate::drawDisplay, but elided text is taken from cache
+void ModelItemDelegate::paintText(QPainter* painter, const QStyleOptionViewItem& option,
+								  const QRect& rect, PaintCache& cache) const {
+	QPalette::ColorGroup cg = (option.state & QStyle::State_Enabled) ? QPalette::Normal : QPalette::Disabled;
+	if (cg == QPalette::Normal && !(option.state & QStyle::State_Active)) {
+		cg = QPalette::Inactive;
+	}
+	if (option.state & QStyle::State_Selected) {
+		painter->fillRect(rect, option.palette.brush(cg, QPalette::Highlight));
+		painter->setPen(option.palette.color(cg, QPalette::HighlightedText));
+	} else {
+		painter->setPen(option.palette.color(cg, QPalette::Text));
+	}
+
+	if (cache.text.isEmpty()) {return;}
+
+	const int textMargin = QApplication::style()->pixelMetric(QStyle::PM_FocusFrameHMargin) + 1;
+	const QRect textRect = rect.adjusted(textMargin, 0, -textMargin, 0);
+	if (cache.elidedWidth != textRect.width()) {
+		cache.elidedText = option.fontMetrics.elidedText(cache.text, option.textElideMode,
+														 textRect.width());
+		cache.elidedWidth = textRect.width();
+	}
+
+	painter->setFont(option.font);
+	painter->drawText(textRect, option.displayAlignment, cache.elidedText);
+}
+
+void ModelItemDelegate::paintSeparator(QPainter* painter, const QStyleOptionViewItem& option) const {
 	const int lineWidth = 2;
 	const int horizontalOffset = 5;
 	const int verticalOffset = option.rect.height() / 2 + option.rect.height() % 2;
@@ -67,6 +117,50 @@ void ModelItemDelegate::paint (QPainter* painter, const QStyleOptionViewItem& op
 	painter->restore();
 }
 
+// Returns cached data of item, queries model if item was not painted yet or was changed since
+ModelItemDelegate::PaintCache& ModelItemDelegate::cachedData(const BaseModelItem* item,
+															 const QModelIndex& index,
+															 const QStyleOptionViewItem& option) const {
+	watchModel(index.model());
+
+	QHash<const BaseModelItem*, PaintCache>::iterator it = paintCache.find(item);
+	if (it == paintCache.end() || it.value().font != option.font) {
+		PaintCache cache;
+		cache.font = option.font;
+		cache.text = index.data(Qt::DisplayRole).toString();
+		cache.textWidth = option.fontMetrics.width(cache.text);
+		cache.elidedWidth = -1;
+		const QVariant decorationData = index.data(Qt::DecorationRole);
+		if (decorationData.isValid()) {
+			cache.icon = decoration(option, decorationData);
+		}
+		it = paintCache.insert(item, cache);
+	}
+
+	return it.value();
+}
+
+void ModelItemDelegate::watchModel(const QAbstractItemModel* model) const {
+	if (!model || watchedModels.contains(model)) {return;}
+	watchedModels.insert(model);
+
+	QObject::connect(model, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+					 this, SLOT(sl_Model_DataChanged(QModelIndex,QModelIndex)));
+	// Removed items may be deleted and their addresses reused by new ones
+	QObject::connect(model, SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)),
+					 this, SLOT(sl_Model_ItemsRemoved()));
+	QObject::connect(model, SIGNAL(modelAboutToBeReset()),
+					 this, SLOT(sl_Model_ItemsRemoved()));
+	QObject::connect(model, SIGNAL(layoutChanged()),
+					 this, SLOT(sl_Model_ItemsRemoved()));
+	QObject::connect(model, SIGNAL(rowsInserted(QModelIndex,int,int)),
+					 this, SLOT(sl_Model_RowsInserted(QModelIndex)));
+	QObject::connect(model, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)),
+					 this, SLOT(sl_Model_RowsMoved(QModelIndex,int,int,QModelIndex)));
+	QObject::connect(model, SIGNAL(destroyed(QObject*)),
+					 this, SLOT(sl_Model_Destroyed(QObject*)));
+}
+
 void ModelItemDelegate::setEditorData(QWidget* editor, const QModelIndex& index) const {
 	_isEditing = true;
 	QItemDelegate::setEditorData(editor, index);
@@ -76,6 +170,40 @@ bool ModelItemDelegate::isEditing() const {
 	return _isEditing;
 }
 
+void ModelItemDelegate::ClearCache() {
+	paintCache.clear();
+}
+
 void ModelItemDelegate::sl_Delegate_closeEditor (QWidget*) {
 	_isEditing = false;
 }
+
+void ModelItemDelegate::sl_Model_DataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight) {
+	const QAbstractItemModel* model = topLeft.model();
+	if (!model) {return;}
+
+	const QModelIndex parent = topLeft.parent();
+	for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+		paintCache.remove(static_cast<const BaseModelItem*>(model->index(row, 0, parent).internalPointer()));
+	}
+}
+
+void ModelItemDelegate::sl_Model_RowsInserted(const QModelIndex& parent) {
+	if (!parent.isValid()) {return;}
+	paintCache.remove(static_cast<const BaseModelItem*>(parent.internalPointer()));
+}
+
+void ModelItemDelegate::sl_Model_RowsMoved(const QModelIndex& sourceParent, int, int,
+										   const QModelIndex& destinationParent) {
+	sl_Model_RowsInserted(sourceParent);
+	sl_Model_RowsInserted(destinationParent);
+}
+
+void ModelItemDelegate::sl_Model_ItemsRemoved() {
+	paintCache.clear();
+}
+
+void ModelItemDelegate::sl_Model_Destroyed(QObject* model) {
+	watchedModels.remove(model);
+	paintCache.clear();
+}
@@ -19,12 +19,43 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #define MODELITEMDELEGATE_H
 
 #include <QItemDelegate>
+#include <QPixmap>
+#include <QHash>
+#include <QSet>
+
+/*
+  ModelItemDelegate draws items of navigation models. Display text, its width, elided text and
+  icon pixmap of each painted item are cached until the model reports the item changed, so
+  repaints while scrolling do not query the model and lay out text again. Titles may contain number
+  of children, so parent's data is dropped when rows are inserted or moved.
+*/
 
 namespace qNotesManager {
+	class BaseModelItem;
+
 	class ModelItemDelegate : public QItemDelegate {
 	Q_OBJECT
 	private:
+		class PaintCache {
+		public:
+			QFont font;
+			QPixmap icon;
+			QString text;
+			int textWidth;
+			QString elidedText;
+			int elidedWidth; // width 'elidedText' was calculated for
+		};
+
 		mutable bool _isEditing;
+		mutable QHash<const BaseModelItem*, PaintCache> paintCache;
+		mutable QSet<const QObject*> watchedModels;
+
+		PaintCache& cachedData(const BaseModelItem*, const QModelIndex&,
+							   const QStyleOptionViewItem&) const;
+		void watchModel(const QAbstractItemModel*) const;
+		void paintSeparator(QPainter*, const QStyleOptionViewItem&) const;
+		void paintText(QPainter*, const QStyleOptionViewItem&, const QRect&, PaintCache&) const;
+
 	public:
 		explicit ModelItemDelegate(QObject *parent = 0);
 
@@ -33,9 +64,15 @@ namespace qNotesManager {
 
 		void setEditorData(QWidget* editor, const QModelIndex& index) const;
 		bool isEditing() const;
+		void ClearCache();
 
 	private slots:
 		void sl_Delegate_closeEditor (QWidget*);
+		void sl_Model_DataChanged(const QModelIndex&, const QModelIndex&);
+		void sl_Model_RowsInserted(const QModelIndex&);
+		void sl_Model_RowsMoved(const QModelIndex&, int, int, const QModelIndex&);
+		void sl_Model_ItemsRemoved();
+		void sl_Model_Destroyed(QObject*);
 	};
 }
 
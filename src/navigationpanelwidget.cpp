@@ -33,10 +33,10 @@ NavigationPanelWidget::NavigationPanelWidget(QWidget *parent) : QWidget(parent)
 	QObject::connect(tabWidget, SIGNAL(currentChanged(int)),
 					 this, SLOT(sl_TabWidget_CurrentChanged(int)));
 
-	QItemDelegate* delegate = new ModelItemDelegate(this);
+	itemDelegate = new ModelItemDelegate(this);
 
 	hierarchyWidget = new FolderNavigationWidget();
-	hierarchyWidget->SetModelItemDelegate(delegate);
+	hierarchyWidget->SetModelItemDelegate(itemDelegate);
 	QObject::connect(hierarchyWidget, SIGNAL(sg_NoteClicked(Note*)),
 					 this, SIGNAL(sg_NoteClicked(Note*)));
 	QObject::connect(hierarchyWidget, SIGNAL(sg_NoteDoubleClicked(Note*)),
@@ -46,7 +46,7 @@ NavigationPanelWidget::NavigationPanelWidget(QWidget *parent) : QWidget(parent)
 	tabWidget->addTab(hierarchyWidget, QIcon(QPixmap(":/gui/folder-tree")), "Folders");
 
 	tagsWidget = new TagsNavigationWidget();
-	tagsWidget->SetModelItemDelegate(delegate);
+	tagsWidget->SetModelItemDelegate(itemDelegate);
 	QObject::connect(tagsWidget, SIGNAL(sg_NoteClicked(Note*)),
 					 this, SIGNAL(sg_NoteClicked(Note*)));
 	QObject::connect(tagsWidget, SIGNAL(sg_NoteDoubleClicked(Note*)),
@@ -54,7 +54,7 @@ NavigationPanelWidget::NavigationPanelWidget(QWidget *parent) : QWidget(parent)
 	tabWidget->addTab(tagsWidget, QIcon(":/gui/tag"), "Tags"); // TODO: make icon and title widget's properties
 
 	datesWidget = new DateNavigationWidget();
-	datesWidget->SetModelItemDelegate(delegate);
+	datesWidget->SetModelItemDelegate(itemDelegate);
 	QObject::connect(datesWidget, SIGNAL(sg_NoteClicked(Note*)),
 					 this, SIGNAL(sg_NoteClicked(Note*)));
 	QObject::connect(datesWidget, SIGNAL(sg_NoteDoubleClicked(Note*)),
@@ -118,6 +118,12 @@ QList<QAction*> NavigationPanelWidget::GetSelectedItemsActions() const {
 	return QList<QAction*>();
 }
 
+// Item titles depend on settings, cached titles are dropped and views are repainted
+void NavigationPanelWidget::UpdateItemsText() {
+	itemDelegate->ClearCache();
+	tabWidget->update();
+}
+
 void NavigationPanelWidget::UpdateViewsVisibility() {
 	int tagsWidgetIndex = tabWidget->indexOf(tagsWidget);
 	if (tagsWidgetIndex >= 0 && !Application::I()->Settings.GetShowTagsTreeView()) {
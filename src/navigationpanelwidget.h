@@ -25,6 +25,7 @@ namespace qNotesManager {
 	class FolderNavigationWidget;
 	class TagsNavigationWidget;
 	class DateNavigationWidget;
+	class ModelItemDelegate;
 	class Note;
 	class Document;
 
@@ -36,6 +37,7 @@ namespace qNotesManager {
 		FolderNavigationWidget*		hierarchyWidget;
 		TagsNavigationWidget*		tagsWidget;
 		DateNavigationWidget*		datesWidget;
+		ModelItemDelegate*			itemDelegate;
 
 	public:
 		explicit NavigationPanelWidget(QWidget *parent = 0);
@@ -44,6 +46,7 @@ namespace qNotesManager {
 		void SetTargetDocument(Document*);
 		QList<QAction*> GetSelectedItemsActions() const;
 		void UpdateViewsVisibility();
+		void UpdateItemsText();
 
 
 	signals:
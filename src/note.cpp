@@ -20,6 +20,7 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include "application.h"
 #include "document.h"
 #include "textdocument.h"
+#include "itemchangebus.h"
 #include "global.h"
 #include "cachedimagefile.h"
 #include "cachedfile.h"
@@ -35,7 +36,7 @@ Note::Note(QString _name) :
 		creationDate(QDateTime::currentDateTime()),
 		modificationDate(QDateTime::currentDateTime()),
 		textDate(QDateTime()),
-		iconID(""),
+		iconIndex(0),
 		author(QString()),
 		source(QString()),
 		comment(QString()),
@@ -103,6 +104,7 @@ void Note::SetName (QString s) {
 	lock.unlock();
 
 	emit sg_VisualPropertiesChanged();
+	notifyChanged(ItemChangeBus::NameChanged);
 	emit sg_PropertyChanged();
 	onChange();
 }
@@ -136,28 +138,34 @@ QPixmap Note::GetIcon() const {
 	if (Application::I()->CurrentDocument() == 0) {
 		return QPixmap();
 	}
-	QPixmap icon = Application::I()->CurrentDocument()->GetItemIcon(iconID);
+	QPixmap icon = Application::I()->CurrentDocument()->GetItemIcon(iconIndex);
 	return icon;
 }
 
 void Note::SetIconID(QString id) {
-	if (iconID == id) {
-		return;
-	}
 	if (id.isEmpty()) {
 		WARNING("New icon id is empty");
 		return;
 	}
+	const int index = Application::I()->GetIconIndex(id);
+	if (iconIndex == index) {
+		return;
+	}
 
-	iconID = id;
+	iconIndex = index;
 
 	emit sg_VisualPropertiesChanged();
+	notifyChanged(ItemChangeBus::IconChanged);
 	emit sg_PropertyChanged();
 	onChange();
 }
 
 QString Note::GetIconID() const {
-	return iconID;
+	return Application::I()->GetIconID(iconIndex);
+}
+
+int Note::GetIconIndex() const {
+	return iconIndex;
 }
 
 QString Note::GetText() const {
@@ -178,12 +186,14 @@ void Note::SetText(QString t) {
 	GetTextDocument()->setPlainText(t);
 
 	emit sg_TextChanged();
+	notifyChanged(ItemChangeBus::TextChanged);
 }
 
 void Note::SetHtml(QString t) {
 	GetTextDocument()->setHtml(t);
 
 	emit sg_TextChanged();
+	notifyChanged(ItemChangeBus::TextChanged);
 }
 
 QColor Note::GetNameForeColor() const {
@@ -203,6 +213,7 @@ void Note::SetNameForeColor(QColor c) {
 	nameForeColor = c;
 
 	emit sg_VisualPropertiesChanged();
+	notifyChanged(ItemChangeBus::ColorsChanged);
 	emit sg_PropertyChanged();
 	onChange();
 }
@@ -224,6 +235,7 @@ void Note::SetNameBackColor(QColor c) {
 	nameBackColor = c;
 
 	emit sg_VisualPropertiesChanged();
+	notifyChanged(ItemChangeBus::ColorsChanged);
 	emit sg_PropertyChanged();
 	onChange();
 }
@@ -253,6 +265,7 @@ void Note::SetLocked(bool e) {
 	lock.unlock();
 
 	emit sg_VisualPropertiesChanged();
+	notifyChanged(ItemChangeBus::LockChanged);
 	emit sg_PropertyChanged();
 	onChange();
 }
@@ -273,6 +286,7 @@ void Note::SetAuthor(QString a) {
 	lock.unlock();
 
 	emit sg_PropertyChanged();
+	notifyChanged(ItemChangeBus::PropertiesChanged);
 	onChange();
 }
 
@@ -292,6 +306,7 @@ void Note::SetSource(QString s) {
 	lock.unlock();
 
 	emit sg_PropertyChanged();
+	notifyChanged(ItemChangeBus::PropertiesChanged);
 	onChange();
 }
 
@@ -307,6 +322,7 @@ void Note::SetTextCreationDate(QDateTime d) {
 	textDate = d;
 
 	emit sg_TextDateChanged();
+	notifyChanged(ItemChangeBus::TextDateChanged);
 	emit sg_PropertyChanged();
 	onChange();
 }
@@ -327,6 +343,7 @@ void Note::SetComment(QString c) {
 	lock.unlock();
 
 	emit sg_PropertyChanged();
+	notifyChanged(ItemChangeBus::PropertiesChanged);
 	onChange();
 }
 
@@ -393,6 +410,7 @@ void Note::onChange() {
 
 	if (modifyDateChanged) {
 		emit sg_ModifyDateChanged();
+		notifyChanged(ItemChangeBus::ModifyDateChanged);
 	}
 	emit sg_DataChanged();
 }
@@ -400,12 +418,17 @@ void Note::onChange() {
 void Note::sl_TagsCollectionModified(Tag*) {
 	if (IsTagsListInitializationInProgress) {return;}
 	emit sg_PropertyChanged();
+	notifyChanged(ItemChangeBus::TagsChanged);
 	onChange();
 }
 
 void Note::sl_TextUpdateTimer_Timeout() {
-	QWriteLocker locker(&lock);
-	text = document->toPlainText();
+	{
+		QWriteLocker locker(&lock);
+		text = document->toPlainText();
+	}
+	// Text typed in editor reaches search only here
+	notifyChanged(ItemChangeBus::TextChanged);
 }
 
 void Note::sl_InitTextDocument() const {
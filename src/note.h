@@ -43,7 +43,7 @@ namespace qNotesManager {
 		QDateTime				creationDate;
 		QDateTime				modificationDate;
 		QDateTime				textDate;
-		QString					iconID;
+		int						iconIndex;			// interned icon id, see Application::GetIconIndex
 		QString					author;
 		QString					source;
 		QString					comment;
@@ -77,6 +77,7 @@ namespace qNotesManager {
 		QPixmap GetIcon() const;
 		void SetIconID(QString id);
 		QString GetIconID() const;
+		int GetIconIndex() const;
 
 		QString GetText() const;
 		void SetText(QString);
@@ -247,22 +247,22 @@ void NoteEditWidget::ShowFragment(const NoteFragment& fragment) {
 	case NoteFragment::CaptionFragment:
 		expandPropertiesPanel();
 		captionEdit->setFocus();
-		captionEdit->setSelection(fragment.MatchStart, fragment.MatchLength);
+		captionEdit->setSelection(fragment.Start, fragment.Length);
 		break;
 	case NoteFragment::AuthorFragment:
 		expandPropertiesPanel();
 		authorEdit->setFocus();
-		authorEdit->setSelection(fragment.MatchStart, fragment.MatchLength);
+		authorEdit->setSelection(fragment.Start, fragment.Length);
 		break;
 	case NoteFragment::CommentFragment:
 		expandPropertiesPanel();
 		commentEdit->setFocus();
-		commentEdit->setSelection(fragment.MatchStart, fragment.MatchLength);
+		commentEdit->setSelection(fragment.Start, fragment.Length);
 		break;
 	case NoteFragment::SourceFragment:
 		expandPropertiesPanel();
 		sourceEdit->setFocus();
-		sourceEdit->setSelection(fragment.MatchStart, fragment.MatchLength);
+		sourceEdit->setSelection(fragment.Start, fragment.Length);
 		break;
 	default:
 		WARNING("Unhandled case branch");
@@ -17,6 +17,7 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 
 #include "notefragment.h"
 
+#include "note.h"
 #include "global.h"
 
 #include <QtGlobal>
@@ -31,23 +32,18 @@ NoteFragment::NoteFragment() :
 		Type(CaptionFragment),
 		Start(-1),
 		Length(0),
-		Sample(QString()),
-		MatchStart(-1),
-		MatchLength(0) {
+		FieldLength(0) {
 	if (NoteFragment::metaTypeID == 0) {
 		NoteFragment::metaTypeID = qRegisterMetaType<NoteFragment>("NoteFragment");
 	}
 }
 
-NoteFragment::NoteFragment(const Note* n, FragmentType t, int s, int l,
-						   QString sample, int ss, int sl) :
+NoteFragment::NoteFragment(const Note* n, FragmentType t, int s, int l, int fieldLength) :
 		NotePrt(n),
 		Type(t),
 		Start(s),
 		Length(l),
-		Sample(sample),
-		MatchStart(ss),
-		MatchLength(sl)
+		FieldLength(fieldLength)
 {
 	if (NoteFragment::metaTypeID == 0) {
 		NoteFragment::metaTypeID = qRegisterMetaType<NoteFragment>("NoteFragment");
@@ -68,10 +64,59 @@ NoteFragment::NoteFragment(const NoteFragment& f) :
 		Type(f.Type),
 		Start(f.Start),
 		Length(f.Length),
-		Sample(f.Sample),
-		MatchStart(f.MatchStart),
-		MatchLength(f.MatchLength) {
+		FieldLength(f.FieldLength) {
 
 }
 
+QString NoteFragment::fieldText() const {
+	if (!NotePrt) {return QString();}
 
+	switch (Type) {
+	case CaptionFragment:
+		return NotePrt->GetName();
+	case AuthorFragment:
+		return NotePrt->GetAuthor();
+	case SourceFragment:
+		return NotePrt->GetSource();
+	case CommentFragment:
+		return NotePrt->GetComment();
+	case TextFragment:
+		return NotePrt->GetText();
+	default:
+		WARNING("Unknown fragment type");
+		return QString();
+	}
+}
+
+// Returns bounds of fragment's sample in field text
+void NoteFragment::sampleBounds(int textLength, int& start, int& end) const {
+	const int symbolsForSample = 40;
+	const int elidedSymbols = (Type == TextFragment) ? 6 : 0;
+	const int appendSymbols = qMax((symbolsForSample - Length - elidedSymbols) / 2, 0);
+
+	start = qBound(0, Start - appendSymbols, textLength);
+	end = qBound(start, Start + Length + appendSymbols, textLength);
+}
+
+// Builds fragment with some text around it and returns position of the match in the sample.
+// Text samples are elided and put in one line. If the field was changed since the search, -1 is
+// returned and the sample is only the text found at the old position
+int NoteFragment::BuildSample(QString& sample) const {
+	const QString text = fieldText();
+	const bool stale = text.length() != FieldLength;
+	int start = 0;
+	int end = 0;
+	sampleBounds(text.length(), start, end);
+
+	if (Type != TextFragment) {
+		sample = text.mid(start, end - start);
+		return stale ? -1 : Start - start;
+	}
+
+	const QLatin1String elide("...");
+	sample.clear();
+	sample.reserve(end - start + 6);
+	sample.append(elide).append(text.midRef(start, end - start)).append(elide);
+	sample.replace(QChar('\n'), QChar(' '));
+	return stale ? -1 : Start - start + 3;
+}
@@ -25,10 +25,16 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 namespace qNotesManager {
 	class Note;
 
+	// Position of a search match in one of note's fields. Text around the match is taken from the
+	// note only when it is shown. Length of the field is kept to find out that the field was changed
+	// since the search
 	class NoteFragment {
 	private:
 		static int metaTypeID;
 
+		QString fieldText() const;
+		void sampleBounds(int textLength, int& start, int& end) const;
+
 	public:
 		enum FragmentType {
 			CaptionFragment,
@@ -39,8 +45,7 @@ namespace qNotesManager {
 		};
 
 		NoteFragment();
-		NoteFragment(const Note* n, FragmentType t, int s, int l,
-					 QString sample = "", int ss = 0, int sl = 0);
+		NoteFragment(const Note* n, FragmentType t, int s, int l, int fieldLength);
 		NoteFragment(const NoteFragment&);
 		~NoteFragment() {};
 
@@ -48,9 +53,9 @@ namespace qNotesManager {
 		const FragmentType Type;
 		const int Start;
 		const int Length;
-		const QString Sample;
-		const int MatchStart;
-		const int MatchLength;
+		const int FieldLength;
+
+		int BuildSample(QString& sample) const;
 	};
 }
 
@@ -31,9 +31,6 @@ using namespace qNotesManager;
 NoteModelItem::NoteModelItem(Note* note) : BaseModelItem(BaseModelItem::note), _storedData(note) {
 	if (!note) {
 		WARNING("Null pointer recieved");
-	} else {
-		QObject::connect(note, SIGNAL(sg_VisualPropertiesChanged()),
-					 this, SLOT(sl_Note_PropertiesChanged()));
 	}
 }
 
@@ -101,10 +98,6 @@ Note* NoteModelItem::GetStoredData() const {
 	return _storedData;
 }
 
-void NoteModelItem::sl_Note_PropertiesChanged() {
-	emit sg_DataChanged(this);
-}
-
 // virtual
 bool NoteModelItem::LessThan(const BaseModelItem* item) const {
 	if (item->DataType() != BaseModelItem::note) {
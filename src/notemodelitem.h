@@ -24,7 +24,6 @@ namespace qNotesManager {
 	class Note;
 
 	class NoteModelItem : public BaseModelItem {
-	Q_OBJECT
 	private:
 		Note*		_storedData;
 		void drawLock(QPixmap&) const;
@@ -42,9 +41,6 @@ namespace qNotesManager {
 		Qt::ItemFlags flags () const;
 		/*virtual*/
 		bool LessThan(const BaseModelItem*) const;
-
-	private slots:
-		void sl_Note_PropertiesChanged();
 	};
 }
 
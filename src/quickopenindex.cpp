@@ -0,0 +1,319 @@
+/*
+This file is part of qNotesManager.
+
+qNotesManager is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+qNotesManager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "quickopenindex.h"
+
+#include "document.h"
+#include "folder.h"
+#include "note.h"
+#include "global.h"
+
+#include <QVarLengthArray>
+
+#include <algorithm>
+
+using namespace qNotesManager;
+
+QuickOpenIndex::QuickOpenIndex(Document* doc) : QObject(doc),
+		document(doc),
+		pathsExpired(false) {
+	if (!doc) {
+		WARNING("Null pointer recieved");
+		return;
+	}
+
+	QObject::connect(doc, SIGNAL(sg_ItemRegistered(Note*)),
+					 this, SLOT(sl_Document_NoteRegistered(Note*)));
+	QObject::connect(doc, SIGNAL(sg_ItemUnregistered(Note*)),
+					 this, SLOT(sl_Document_NoteUnregistered(Note*)));
+	QObject::connect(doc, SIGNAL(sg_ItemUnregistered(Folder*)),
+					 this, SLOT(sl_Document_FolderUnregistered(Folder*)));
+	QObject::connect(doc->GetChangeBus(), SIGNAL(sg_ItemsChanged(const ItemChanges&)),
+					 this, SLOT(sl_ChangeBus_ItemsChanged(const ItemChanges&)));
+
+	foreach (Note* n, doc->GetNotesList()) {
+		sl_Document_NoteRegistered(n);
+	}
+}
+
+void QuickOpenIndex::sl_Document_NoteRegistered(Note* n) {
+	if (!n) {
+		WARNING("Null pointer recieved");
+		return;
+	}
+	if (entryIndexes.contains(n)) {return;}
+
+	Entry entry;
+	entry.NotePtr = n;
+	updateEntry(entry);
+
+	entryIndexes.insert(n, entries.count());
+	entries.append(entry);
+}
+
+void QuickOpenIndex::sl_Document_NoteUnregistered(Note* n) {
+	if (!entryIndexes.contains(n)) {return;}
+
+	// Last entry takes place of removed one
+	const int index = entryIndexes.take(n);
+	const int lastIndex = entries.count() - 1;
+	if (index != lastIndex) {
+		entries[index] = entries.at(lastIndex);
+		entryIndexes.insert(entries.at(index).NotePtr, index);
+	}
+	entries.remove(lastIndex);
+}
+
+void QuickOpenIndex::sl_Document_FolderUnregistered(Folder* f) {
+	folderPaths.remove(f);
+}
+
+void QuickOpenIndex::sl_ChangeBus_ItemsChanged(const ItemChanges& changes) {
+	for (ItemChanges::const_iterator it = changes.constBegin(); it != changes.constEnd(); ++it) {
+		if ((it.value() & (ItemChangeBus::NameChanged | ItemChangeBus::ParentChanged)) == 0) {continue;}
+
+		if (it.key()->GetItemType() == AbstractFolderItem::Type_Folder) {
+			// Paths of all notes inside renamed or moved folder are changed, they are rebuilt on next query
+			folderPaths.clear();
+			pathsExpired = true;
+			continue;
+		}
+
+		const Note* n = static_cast<const Note*>(it.key());
+		QHash<const Note*, int>::const_iterator index = entryIndexes.constFind(n);
+		if (index != entryIndexes.constEnd()) {
+			updateEntry(entries[index.value()]);
+		}
+	}
+}
+
+void QuickOpenIndex::updateEntry(Entry& entry) {
+	const QString path = folderPath(entry.NotePtr->GetParent());
+	const QString caption = entry.NotePtr->GetName().toLower();
+
+	entry.Text = path.isEmpty() ? caption : path + "/" + caption;
+	entry.CaptionOffset = entry.Text.length() - caption.length();
+	entry.CharMask = charMask(entry.Text.constData(), entry.Text.length());
+}
+
+// Returns lowercased folder path, which is empty for notes in root folder
+QString QuickOpenIndex::folderPath(const Folder* folder) {
+	if (!folder || folder == document->GetRoot()) {return QString();}
+
+	QHash<const Folder*, QString>::const_iterator it = folderPaths.constFind(folder);
+	if (it != folderPaths.constEnd()) {return it.value();}
+
+	const QString path = folder->GetPath().toLower();
+	folderPaths.insert(folder, path);
+	return path;
+}
+
+void QuickOpenIndex::updatePaths() {
+	for (int i = 0; i < entries.count(); ++i) {
+		updateEntry(entries[i]);
+	}
+	pathsExpired = false;
+}
+
+quint64 QuickOpenIndex::charBit(ushort c) {
+	if (c >= 'a' && c <= 'z') {return Q_UINT64_C(1) << (c - 'a');}
+	if (c >= '0' && c <= '9') {return Q_UINT64_C(1) << (26 + c - '0');}
+	if (c < 128) {return 0;} // Spaces and punctuation
+	return Q_UINT64_C(1) << (36 + c % 28);
+}
+
+quint64 QuickOpenIndex::charMask(const QChar* text, int length) {
+	quint64 mask = 0;
+	for (int i = 0; i < length; ++i) {
+		mask |= charBit(text[i].unicode());
+	}
+	return mask;
+}
+
+bool QuickOpenIndex::isWordStart(const QChar* text, int index) {
+	return index == 0 || !text[index - 1].isLetterOrNumber();
+}
+
+// Scores the shortest occurrence of query, that ends where the first occurrence ends.
+// Returns NoMatch if text does not contain query characters in the same order.
+int QuickOpenIndex::score(const QChar* text, int length, const ushort* query, int queryLength) {
+	const int scoreMatch = 16;
+	const int scoreGapStart = 3;
+	const int scoreGapExtension = 1;
+	const int bonusWordStart = 8;
+	const int bonusConsecutive = 4;
+	const int firstCharMultiplier = 2;
+
+	int q = 0;
+	int end = -1;
+	for (int i = 0; i < length; ++i) {
+		if (text[i].unicode() == query[q] && ++q == queryLength) {
+			end = i;
+			break;
+		}
+	}
+	if (end == -1) {return NoMatch;}
+
+	q = queryLength - 1;
+	int start = end;
+	for (int i = end; i >= 0; --i) {
+		if (text[i].unicode() == query[q] && --q < 0) {
+			start = i;
+			break;
+		}
+	}
+
+	int result = 0;
+	int consecutive = 0;
+	bool inGap = false;
+	q = 0;
+	for (int i = start; i <= end; ++i) {
+		if (q < queryLength && text[i].unicode() == query[q]) {
+			int bonus = isWordStart(text, i) ? bonusWordStart : 0;
+			if (consecutive > 0) {bonus = qMax(bonus, bonusConsecutive);}
+			if (q == 0) {bonus *= firstCharMultiplier;}
+
+			result += scoreMatch + bonus;
+			consecutive++;
+			inGap = false;
+			q++;
+		} else {
+			result -= inGap ? scoreGapExtension : scoreGapStart;
+			inGap = true;
+			consecutive = 0;
+		}
+	}
+
+	return result;
+}
+
+// Scores text allowing one query character to be mistyped, missing or extra
+int QuickOpenIndex::scoreWithTypo(const QChar* text, int length, const ushort* query,
+								  int queryLength) {
+	const int typoPenalty = 32;
+
+	// prefixEnd[i]: text position after the earliest match of query[0, i)
+	QVarLengthArray<int, 64> prefixEnd(queryLength + 1);
+	prefixEnd[0] = 0;
+	int pos = 0;
+	for (int i = 0; i < queryLength; ++i) {
+		while (pos < length && text[pos].unicode() != query[i]) {pos++;}
+		prefixEnd[i + 1] = (pos < length) ? ++pos : length + 1;
+	}
+
+	// suffixStart[i]: text position of the latest match of query[i, queryLength)
+	QVarLengthArray<int, 64> suffixStart(queryLength + 1);
+	suffixStart[queryLength] = length;
+	pos = length - 1;
+	for (int i = queryLength - 1; i >= 0; --i) {
+		while (pos >= 0 && text[pos].unicode() != query[i]) {pos--;}
+		suffixStart[i] = (pos >= 0) ? pos-- : -1;
+	}
+
+	for (int skipped = 0; skipped < queryLength; ++skipped) {
+		if (prefixEnd[skipped] > suffixStart[skipped + 1]) {continue;}
+
+		QVarLengthArray<ushort, 64> reducedQuery;
+		for (int i = 0; i < queryLength; ++i) {
+			if (i != skipped) {reducedQuery.append(query[i]);}
+		}
+		const int result = score(text, length, reducedQuery.constData(), reducedQuery.size());
+		if (result != NoMatch) {return result - typoPenalty;}
+	}
+
+	return NoMatch;
+}
+
+void QuickOpenIndex::findMatches(const ushort* query, int queryLength, quint64 queryMask,
+								 bool allowTypo, int maxResults, QVector<Match>& heap) const {
+	const int captionBonus = 32;
+
+	for (int i = 0; i < entries.count(); ++i) {
+		const Entry& entry = entries.at(i);
+		const QChar* text = entry.Text.constData();
+		const int length = entry.Text.length();
+		const quint64 missingChars = queryMask & ~entry.CharMask;
+
+		int result = NoMatch;
+		if (missingChars == 0) {
+			result = score(text + entry.CaptionOffset, length - entry.CaptionOffset,
+						   query, queryLength);
+			if (result != NoMatch) {
+				result += captionBonus;
+			} else if (entry.CaptionOffset > 0) {
+				result = score(text, length, query, queryLength);
+			}
+			// Exact matches were found on first pass
+			if (allowTypo && result != NoMatch) {continue;}
+		}
+		if (allowTypo && result == NoMatch && (missingChars & (missingChars - 1)) == 0) {
+			result = scoreWithTypo(text, length, query, queryLength);
+		}
+		if (result == NoMatch) {continue;}
+
+		// Shorter captions are preferred
+		result -= (length - entry.CaptionOffset) / 8;
+
+		const Match m(entry.NotePtr, result);
+		if (heap.count() < maxResults) {
+			heap.append(m);
+			std::push_heap(heap.begin(), heap.end(), Match::HasGreaterScore);
+		} else if (result > heap.first().Score) {
+			std::pop_heap(heap.begin(), heap.end(), Match::HasGreaterScore);
+			heap.last() = m;
+			std::push_heap(heap.begin(), heap.end(), Match::HasGreaterScore);
+		}
+	}
+}
+
+// Returns best matches, sorted by score. Spaces in query are ignored.
+QList<QuickOpenIndex::Match> QuickOpenIndex::Find(const QString& query, int maxResults) {
+	QList<Match> results;
+	if (maxResults <= 0) {return results;}
+
+	const QString loweredQuery = query.toLower();
+	QVarLengthArray<ushort, 64> queryChars;
+	quint64 queryMask = 0;
+	for (int i = 0; i < loweredQuery.length(); ++i) {
+		const QChar c = loweredQuery.at(i);
+		if (c.isSpace()) {continue;}
+		queryChars.append(c.unicode());
+		queryMask |= charBit(c.unicode());
+	}
+	if (queryChars.isEmpty()) {return results;}
+
+	if (pathsExpired) {
+		updatePaths();
+	}
+
+	QVector<Match> heap; // min-heap, the worst of best matches is at front
+	heap.reserve(maxResults);
+	findMatches(queryChars.constData(), queryChars.size(), queryMask, false, maxResults, heap);
+
+	// Typos are looked for only if there are not enough exact matches
+	const int minQueryLengthForTypos = 3;
+	if (heap.count() < maxResults && queryChars.size() >= minQueryLengthForTypos) {
+		findMatches(queryChars.constData(), queryChars.size(), queryMask, true, maxResults, heap);
+	}
+
+	std::sort_heap(heap.begin(), heap.end(), Match::HasGreaterScore);
+	results.reserve(heap.count());
+	foreach (const Match& m, heap) {
+		results << m;
+	}
+
+	return results;
+}
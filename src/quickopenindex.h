@@ -0,0 +1,102 @@
+/*
+This file is part of qNotesManager.
+
+qNotesManager is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+qNotesManager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef QUICKOPENINDEX_H
+#define QUICKOPENINDEX_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QList>
+
+#include <climits>
+
+#include "itemchangebus.h"
+
+/*
+  QuickOpenIndex keeps lowercased captions and folder paths of all document's notes to find notes
+  by fuzzy query. Query characters must appear in the same order in note's 'path/caption' string,
+  matches at word starts and consecutive matches are scored higher, caption matches are preferred
+  to path matches. If there are no such matches, one query character may be mistyped.
+*/
+
+namespace qNotesManager {
+	class Note;
+	class Folder;
+	class Document;
+
+	class QuickOpenIndex : public QObject {
+	Q_OBJECT
+	public:
+		class Match {
+		public:
+			Match() : NotePtr(0), Score(0) {}
+			Match(Note* n, int s) : NotePtr(n), Score(s) {}
+
+			Note* NotePtr;
+			int Score;
+
+			static bool HasGreaterScore(const Match& a, const Match& b) {
+				return a.Score > b.Score;
+			}
+		};
+
+	private:
+		class Entry {
+		public:
+			Entry() : NotePtr(0), CaptionOffset(0), CharMask(0) {}
+
+			Note* NotePtr;
+			QString Text;		// lowercased 'path/caption'
+			int CaptionOffset;	// caption start in Text
+			quint64 CharMask;	// bit per character class present in Text, used to skip entries fast
+		};
+
+		static const int NoMatch = INT_MIN;
+
+		Document* document;
+		QVector<Entry> entries;
+		QHash<const Note*, int> entryIndexes;
+		QHash<const Folder*, QString> folderPaths; // cache of lowercased folder paths
+		bool pathsExpired;
+
+		void updateEntry(Entry& entry);
+		QString folderPath(const Folder* folder);
+		void updatePaths();
+		void findMatches(const ushort* query, int queryLength, quint64 queryMask, bool allowTypo,
+						 int maxResults, QVector<Match>& heap) const;
+
+		static quint64 charMask(const QChar* text, int length);
+		static quint64 charBit(ushort c);
+		static bool isWordStart(const QChar* text, int index);
+		static int score(const QChar* text, int length, const ushort* query, int queryLength);
+		static int scoreWithTypo(const QChar* text, int length, const ushort* query, int queryLength);
+
+	public:
+		explicit QuickOpenIndex(Document*);
+
+		QList<Match> Find(const QString& query, int maxResults);
+
+	private slots:
+		void sl_Document_NoteRegistered(Note*);
+		void sl_Document_NoteUnregistered(Note*);
+		void sl_Document_FolderUnregistered(Folder*);
+		void sl_ChangeBus_ItemsChanged(const ItemChanges&);
+	};
+}
+
+#endif // QUICKOPENINDEX_H
@@ -0,0 +1,110 @@
+/*
+This file is part of qNotesManager.
+
+qNotesManager is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+qNotesManager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "quickopenwidget.h"
+
+#include "document.h"
+#include "quickopenindex.h"
+#include "folder.h"
+#include "note.h"
+#include "global.h"
+
+#include <QVBoxLayout>
+#include <QKeyEvent>
+#include <QCoreApplication>
+
+using namespace qNotesManager;
+
+QuickOpenWidget::QuickOpenWidget(Document* doc, QWidget* parent) : QDialog(parent),
+		document(doc) {
+	queryEdit = new QLineEdit(this);
+	queryEdit->setToolTip("Type part of note's caption or folder path. Letters may be skipped");
+	queryEdit->installEventFilter(this);
+	QObject::connect(queryEdit, SIGNAL(textChanged(QString)),
+					 this, SLOT(sl_QueryEdit_TextChanged(QString)));
+
+	resultsList = new QListWidget(this);
+	QObject::connect(resultsList, SIGNAL(itemActivated(QListWidgetItem*)),
+					 this, SLOT(sl_ResultsList_ItemActivated(QListWidgetItem*)));
+
+	QVBoxLayout* mainLayout = new QVBoxLayout();
+	mainLayout->addWidget(queryEdit);
+	mainLayout->addWidget(resultsList);
+	setLayout(mainLayout);
+
+	setWindowTitle("Go to note");
+	resize(450, 350);
+}
+
+void QuickOpenWidget::sl_QueryEdit_TextChanged(const QString& query) {
+	const int maxResults = 20;
+
+	resultsList->clear();
+	foundNotes.clear();
+	if (!document) {return;}
+
+	const QList<QuickOpenIndex::Match> matches =
+			document->GetQuickOpenIndex()->Find(query, maxResults);
+	foreach (const QuickOpenIndex::Match& m, matches) {
+		Note* n = m.NotePtr;
+		QString text = n->GetName();
+		const Folder* parent = n->GetParent();
+		if (parent && parent != document->GetRoot()) {
+			text.append(" (").append(parent->GetPath()).append(")");
+		}
+
+		new QListWidgetItem(QIcon(n->GetIcon()), text, resultsList);
+		foundNotes << n;
+	}
+
+	if (resultsList->count() > 0) {
+		resultsList->setCurrentRow(0);
+	}
+}
+
+void QuickOpenWidget::sl_ResultsList_ItemActivated(QListWidgetItem*) {
+	accept();
+}
+
+// Up, Down and Enter in query field control results list
+bool QuickOpenWidget::eventFilter(QObject* watched, QEvent* event) {
+	if (watched == queryEdit && event->type() == QEvent::KeyPress) {
+		QKeyEvent* keyEvent = static_cast<QKeyEvent*>(event);
+		switch (keyEvent->key()) {
+		case Qt::Key_Up:
+		case Qt::Key_Down:
+		case Qt::Key_PageUp:
+		case Qt::Key_PageDown:
+			QCoreApplication::sendEvent(resultsList, event);
+			return true;
+		case Qt::Key_Return:
+		case Qt::Key_Enter:
+			if (SelectedNote()) {accept();}
+			return true;
+		default:
+			break;
+		}
+	}
+
+	return QDialog::eventFilter(watched, event);
+}
+
+Note* QuickOpenWidget::SelectedNote() const {
+	const int row = resultsList->currentRow();
+	if (row < 0 || row >= foundNotes.count()) {return 0;}
+
+	return foundNotes.at(row);
+}
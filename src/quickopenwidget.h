@@ -0,0 +1,51 @@
+/*
+This file is part of qNotesManager.
+
+qNotesManager is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+qNotesManager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef QUICKOPENWIDGET_H
+#define QUICKOPENWIDGET_H
+
+#include <QDialog>
+#include <QLineEdit>
+#include <QListWidget>
+
+namespace qNotesManager {
+	class Document;
+	class Note;
+
+	class QuickOpenWidget : public QDialog {
+	Q_OBJECT
+	private:
+		QLineEdit* queryEdit;
+		QListWidget* resultsList;
+
+		Document* document;
+		QList<Note*> foundNotes;
+
+	protected:
+		/*virtual*/ bool eventFilter(QObject* watched, QEvent* event);
+
+	public:
+		explicit QuickOpenWidget(Document* doc, QWidget* parent = 0);
+
+		Note* SelectedNote() const;
+
+	private slots:
+		void sl_QueryEdit_TextChanged(const QString&);
+		void sl_ResultsList_ItemActivated(QListWidgetItem*);
+	};
+}
+
+#endif // QUICKOPENWIDGET_H
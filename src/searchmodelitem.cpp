@@ -26,24 +26,27 @@ using namespace qNotesManager;
 
 SearchModelItem::SearchModelItem(const NoteFragment& f) :
 		BaseModelItem(BaseModelItem::SearchResult),
-		fragment(f) {
+		fragment(f),
+		sampleMatchStart(-1),
+		sampleIsBuilt(false) {
 	expired = false;
 	if (!fragment.NotePrt) {
 		WARNING("Null pointer recieved");
-	} else {
-		QObject::connect(fragment.NotePrt, SIGNAL(sg_TextChanged()),
-						 this, SLOT(sl_Note_TextChanged()));
 	}
 }
 
 /* virtual */
 QVariant SearchModelItem::data(int role) const {
 	if (role == Qt::DisplayRole) {
-		return fragment.Sample;
+		buildSample();
+		return sample;
 	} else if (role == HighlightStartRole) {
-		return fragment.MatchStart;
+		buildSample();
+		return qMax(sampleMatchStart, 0);
 	} else if (role == HightlightLengthRole) {
-		return fragment.MatchLength;
+		// Match position is not known in changed text, nothing is highlighted
+		buildSample();
+		return (expired || sampleMatchStart < 0) ? 0 : fragment.Length;
 	} else if (role == Qt::DecorationRole) {
 		switch(fragment.Type) {
 			case NoteFragment::CaptionFragment:
@@ -84,7 +87,14 @@ NoteFragment SearchModelItem::Fragment() const {
 	return fragment;
 }
 
-void SearchModelItem::sl_Note_TextChanged() {
+void SearchModelItem::SetExpired() {
 	expired = true;
-	emit sg_DataChanged(this);
+	sampleIsBuilt = false;
+}
+
+void SearchModelItem::buildSample() const {
+	if (sampleIsBuilt) {return;}
+
+	sampleMatchStart = fragment.BuildSample(sample);
+	sampleIsBuilt = true;
 }
@@ -23,22 +23,25 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 
 namespace qNotesManager {
 	class SearchModelItem : public BaseModelItem {
-	Q_OBJECT
 	private:
 		const NoteFragment fragment;
 		bool expired;
 
+		// Sample is built once, when item is shown first
+		mutable QString sample;
+		mutable int sampleMatchStart;
+		mutable bool sampleIsBuilt;
+		void buildSample() const;
+
 	public:
 		explicit SearchModelItem(const NoteFragment& f);
 		/*virtual*/ QVariant data(int role) const;
 		/*virtual*/ Qt::ItemFlags flags () const;
 		NoteFragment Fragment() const;
+		void SetExpired(); // Note text was changed, fragment position is not valid anymore
 
 		static const int HighlightStartRole = 50;
 		static const int HightlightLengthRole = 51;
-
-	private slots:
-		void sl_Note_TextChanged();
 	};
 }
 
@@ -0,0 +1,366 @@
+/*
+This file is part of qNotesManager.
+
+qNotesManager is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+qNotesManager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "searchquery.h"
+
+#include "document.h"
+#include "folder.h"
+#include "note.h"
+#include "tag.h"
+#include "global.h"
+
+#include <QRegExp>
+#include <QSet>
+
+using namespace qNotesManager;
+
+bool SearchQuery::DateRange::Contains(const QDate& date) const {
+	if (!date.isValid()) {return false;}
+	if (From.isValid() && date < From) {return false;}
+	if (To.isValid() && date >= To) {return false;}
+	return true;
+}
+
+SearchQuery::SearchQuery() {
+}
+
+// Splits query into words, "quoted phrases" and key:value filters
+SearchQuery SearchQuery::Parse(const QString& query) {
+	SearchQuery q;
+	const int length = query.length();
+	int i = 0;
+
+	while (i < length) {
+		while (i < length && query.at(i).isSpace()) {i++;}
+		if (i >= length) {break;}
+
+		QString key;
+		QString token;
+		bool quoted = false;
+
+		while (i < length && !query.at(i).isSpace()) {
+			const QChar c = query.at(i);
+			if (c == '"') {
+				int closingQuote = query.indexOf('"', i + 1);
+				if (closingQuote == -1) {closingQuote = length;}
+				token.append(query.mid(i + 1, closingQuote - i - 1));
+				quoted = true;
+				i = closingQuote + 1;
+			} else if (c == ':' && key.isNull() && !quoted && !token.isEmpty()) {
+				key = token;
+				token = QString();
+				i++;
+			} else {
+				token.append(c);
+				i++;
+			}
+		}
+
+		if (!key.isNull()) {
+			if (q.parseFilter(key.toLower(), token)) {
+				if (!q.IsValid()) {return q;}
+				continue;
+			}
+			// Not a filter, search for the text as is
+			token.prepend(key + ":");
+		}
+
+		if (!token.isEmpty()) {
+			q.textTerms << token;
+		}
+	}
+
+	return q;
+}
+
+// Returns false if key is not a filter name
+bool SearchQuery::parseFilter(const QString& key, const QString& value) {
+	DateRange range;
+
+	if (key == "tag") {
+		if (!value.isEmpty()) {tags << value;}
+	} else if (key == "in" || key == "folder") {
+		if (!value.isEmpty()) {folders << value;}
+	} else if (key == "created") {
+		range.Field = CreationDate;
+	} else if (key == "modified") {
+		range.Field = ModificationDate;
+	} else if (key == "textdate") {
+		range.Field = TextDate;
+	} else {
+		return false;
+	}
+
+	if (value.isEmpty()) {
+		errorString = QString("Filter '%1' has no value").arg(key);
+		return true;
+	}
+
+	if (key == "created" || key == "modified" || key == "textdate") {
+		if (!parseDateRange(value, range)) {
+			errorString = QString("Wrong date in filter '%1:%2'").arg(key).arg(value);
+			return true;
+		}
+		dateRanges << range;
+	}
+
+	return true;
+}
+
+// Parses 'value', '>value', '>=value', '<value', '<=value', '=value' and 'from..to'
+bool SearchQuery::parseDateRange(const QString& value, DateRange& range) const {
+	QDate start;
+	QDate end;
+
+	const int rangeSeparator = value.indexOf("..");
+	if (rangeSeparator != -1) {
+		const QString from = value.left(rangeSeparator);
+		const QString to = value.mid(rangeSeparator + 2);
+		if (from.isEmpty() && to.isEmpty()) {return false;}
+
+		if (!from.isEmpty()) {
+			if (!parseDate(from, start, end)) {return false;}
+			range.From = start;
+		}
+		if (!to.isEmpty()) {
+			if (!parseDate(to, start, end)) {return false;}
+			range.To = end;
+		}
+		return true;
+	}
+
+	QString op;
+	if (value.startsWith(">=") || value.startsWith("<=")) {
+		op = value.left(2);
+	} else if (value.startsWith(">") || value.startsWith("<") || value.startsWith("=")) {
+		op = value.left(1);
+	}
+
+	if (!parseDate(value.mid(op.length()), start, end)) {return false;}
+
+	if (op.isEmpty() || op == "=") {
+		range.From = start;
+		range.To = end;
+	} else if (op == ">") {
+		range.From = end;
+	} else if (op == ">=") {
+		range.From = start;
+	} else if (op == "<") {
+		range.To = start;
+	} else if (op == "<=") {
+		range.To = end;
+	}
+
+	return true;
+}
+
+// Parses 'yyyy', 'yyyy-MM' or 'yyyy-MM-dd' into [start, end) period
+bool SearchQuery::parseDate(const QString& value, QDate& start, QDate& end) const {
+	QRegExp dateRegexp("^(\\d{4})(?:-(\\d{1,2})(?:-(\\d{1,2}))?)?$");
+	if (dateRegexp.indexIn(value) == -1) {return false;}
+
+	const int year = dateRegexp.cap(1).toInt();
+	const int month = dateRegexp.cap(2).isEmpty() ? 0 : dateRegexp.cap(2).toInt();
+	const int day = dateRegexp.cap(3).isEmpty() ? 0 : dateRegexp.cap(3).toInt();
+
+	start = QDate(year, month == 0 ? 1 : month, day == 0 ? 1 : day);
+	if (!start.isValid()) {return false;}
+
+	if (month == 0) {
+		end = start.addYears(1);
+	} else if (day == 0) {
+		end = start.addMonths(1);
+	} else {
+		end = start.addDays(1);
+	}
+
+	return true;
+}
+
+bool SearchQuery::IsValid() const {
+	return errorString.isEmpty();
+}
+
+QString SearchQuery::GetErrorString() const {
+	return errorString;
+}
+
+bool SearchQuery::IsEmpty() const {
+	return textTerms.isEmpty() && !HasFilters();
+}
+
+bool SearchQuery::HasFilters() const {
+	return !tags.isEmpty() || !folders.isEmpty() || !dateRanges.isEmpty();
+}
+
+QStringList SearchQuery::GetTextTerms() const {
+	return textTerms;
+}
+
+// Returns regexp pattern, that matches any of text terms
+QString SearchQuery::TextPattern(bool searchWholeWord) const {
+	QStringList patterns;
+	foreach (const QString& term, textTerms) {
+		QString pattern = QRegExp::escape(term);
+		if (searchWholeWord) {
+			pattern.prepend("\\b").append("\\b");
+		}
+		patterns << pattern;
+	}
+
+	return patterns.join("|");
+}
+
+bool SearchQuery::MatchesDates(const Note* note) const {
+	foreach (const DateRange& range, dateRanges) {
+		QDate date;
+		switch (range.Field) {
+		case CreationDate:
+			date = note->GetCreationDate().date();
+			break;
+		case ModificationDate:
+			date = note->GetModificationDate().date();
+			break;
+		case TextDate:
+			date = note->GetTextCreationDate().date();
+			break;
+		default:
+			return false;
+		}
+
+		if (!range.Contains(date)) {return false;}
+	}
+
+	return true;
+}
+
+// Returns notes that pass all metadata filters. The narrowest set (owners of the least used tag or
+// notes of requested folders) is taken as a base, other filters are checked for its items only.
+QList<Note*> SearchQuery::SelectCandidates(const Document* document) const {
+	QList<Note*> candidates;
+	if (!document) {
+		WARNING("Null pointer recieved");
+		return candidates;
+	}
+
+	QList<const Tag*> tagsList;
+	foreach (const QString& name, tags) {
+		const Tag* tag = document->FindTagByName(name);
+		if (!tag) {
+			foreach (const Tag* t, document->GetTagsList()) {
+				if (t->GetName().compare(name, Qt::CaseInsensitive) == 0) {
+					tag = t;
+					break;
+				}
+			}
+		}
+		if (!tag) {return candidates;} // There are no notes with unknown tag
+		tagsList << tag;
+	}
+
+	QList<Folder*> foldersList;
+	foreach (const QString& name, folders) {
+		QList<Folder*> found;
+		findFolders(document->GetRoot(), name, found);
+		findFolders(document->GetTempFolder(), name, found);
+		findFolders(document->GetTrashFolder(), name, found);
+		if (found.isEmpty()) {return candidates;}
+		foldersList << found;
+	}
+
+	const Tag* baseTag = 0;
+	foreach (const Tag* tag, tagsList) {
+		if (baseTag == 0 || tag->Owners.Count() < baseTag->Owners.Count()) {
+			baseTag = tag;
+		}
+	}
+
+	QList<Note*> baseList;
+	bool checkFolders = !foldersList.isEmpty();
+	if (baseTag) {
+		for (int i = 0; i < baseTag->Owners.Count(); ++i) {
+			baseList << baseTag->Owners.ItemAt(i);
+		}
+	} else if (!foldersList.isEmpty()) {
+		foreach (const Folder* folder, foldersList) {
+			collectNotes(folder, baseList);
+		}
+		checkFolders = false;
+	} else {
+		baseList = document->GetNotesList();
+	}
+
+	QSet<const Note*> addedNotes;
+	foreach (Note* note, baseList) {
+		if (addedNotes.contains(note)) {continue;} // Folders may be nested
+
+		bool matches = true;
+		foreach (const Tag* tag, tagsList) {
+			if (tag != baseTag && !tag->Owners.Contains(note)) {
+				matches = false;
+				break;
+			}
+		}
+		if (!matches) {continue;}
+
+		if (checkFolders) {
+			matches = false;
+			foreach (const Folder* folder, foldersList) {
+				if (note->IsOffspringOf(folder)) {
+					matches = true;
+					break;
+				}
+			}
+			if (!matches) {continue;}
+		}
+
+		if (!MatchesDates(note)) {continue;}
+
+		addedNotes.insert(note);
+		candidates << note;
+	}
+
+	return candidates;
+}
+
+// Finds folders whose path or name equals 'name'
+void SearchQuery::findFolders(Folder* parent, const QString& name, QList<Folder*>& found) const {
+	if (!parent) {return;}
+
+	if (parent->GetPath().compare(name, Qt::CaseInsensitive) == 0 ||
+		parent->GetName().compare(name, Qt::CaseInsensitive) == 0) {
+		found << parent;
+	}
+
+	for (int i = 0; i < parent->Items.Count(); ++i) {
+		AbstractFolderItem* item = parent->Items.ItemAt(i);
+		if (item->GetItemType() == AbstractFolderItem::Type_Folder) {
+			findFolders(dynamic_cast<Folder*>(item), name, found);
+		}
+	}
+}
+
+void SearchQuery::collectNotes(const Folder* folder, QList<Note*>& notes) const {
+	for (int i = 0; i < folder->Items.Count(); ++i) {
+		AbstractFolderItem* item = folder->Items.ItemAt(i);
+		if (item->GetItemType() == AbstractFolderItem::Type_Folder) {
+			collectNotes(dynamic_cast<Folder*>(item), notes);
+		} else {
+			notes << dynamic_cast<Note*>(item);
+		}
+	}
+}
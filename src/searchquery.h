@@ -0,0 +1,93 @@
+/*
+This file is part of qNotesManager.
+
+qNotesManager is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+qNotesManager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SEARCHQUERY_H
+#define SEARCHQUERY_H
+
+#include <QString>
+#include <QStringList>
+#include <QDate>
+#include <QList>
+
+/*
+  SearchQuery is a parsed global search query. Besides text terms and "exact phrases" query may
+  contain field filters:
+	tag:work				note has tag 'work'
+	in:"Projects/Current"	note is inside folder with such path or name
+	created:2014			note was created in 2014
+	modified:>2014-01		note was modified after January 2014
+	textdate:<=2014-02-15	text creation date is 15.02.2014 or earlier
+	created:2013..2014-06	note was created between 2013 and June 2014
+  All filters and terms must match. Metadata filters are evaluated before any text is searched.
+*/
+
+namespace qNotesManager {
+	class Note;
+	class Folder;
+	class Document;
+
+	class SearchQuery {
+	public:
+		enum DateField {
+			CreationDate,
+			ModificationDate,
+			TextDate
+		};
+
+		class DateRange {
+		public:
+			DateRange() : Field(CreationDate) {}
+			DateField Field;
+			QDate From;	// inclusive, null if range is not limited from below
+			QDate To;	// exclusive, null if range is not limited from above
+
+			bool Contains(const QDate& date) const;
+		};
+
+	private:
+		QStringList textTerms;
+		QStringList tags;
+		QStringList folders;
+		QList<DateRange> dateRanges;
+		QString errorString;
+
+		bool parseFilter(const QString& key, const QString& value);
+		bool parseDateRange(const QString& value, DateRange& range) const;
+		bool parseDate(const QString& value, QDate& start, QDate& end) const;
+		void findFolders(Folder* parent, const QString& name, QList<Folder*>& found) const;
+		void collectNotes(const Folder* folder, QList<Note*>& notes) const;
+
+	public:
+		SearchQuery();
+
+		static SearchQuery Parse(const QString& query);
+
+		bool IsValid() const;
+		QString GetErrorString() const;
+
+		bool IsEmpty() const;
+		bool HasFilters() const;
+		QStringList GetTextTerms() const;
+
+		QString TextPattern(bool searchWholeWord) const;
+		bool MatchesDates(const Note*) const;
+
+		QList<Note*> SelectCandidates(const Document*) const;
+	};
+}
+
+#endif // SEARCHQUERY_H
@@ -42,33 +42,12 @@ void SearchResultItemDelegate::paint (QPainter* painter, const QStyleOptionViewI
 		return;
 	}
 
-	bool drawIcon = false;
-	QPixmap icon;
-	if (index.model()->data(index, Qt::DecorationRole).canConvert<QPixmap>()) {
-		icon = index.model()->data(index, Qt::DecorationRole).value<QPixmap>();
-		drawIcon = true;
-	}
+	const FragmentLayout* layout = fragmentLayout(item, index, painter->font());
+	if (!layout) {return;}
 
 	const int iconTextInterval = 6;
 	const int iconOffset = 1;
 
-	const QString text = index.model()->data(index, Qt::DisplayRole).toString();
-	QVariant tempVariant = index.model()->data(index, SearchModelItem::HighlightStartRole);
-	if (tempVariant.isNull()) {
-		WARNING("Could not retrieve data from item");
-		return;
-	}
-	const int matchStart = tempVariant.toInt();
-
-	tempVariant = index.model()->data(index, SearchModelItem::HightlightLengthRole);
-	if (tempVariant.isNull()) {
-		WARNING("Could not retrieve data from item");
-		return;
-	}
-	const int matchLength = tempVariant.toInt();
-
-	QStyleOptionViewItem opt(option);
-	initStyleOption(&opt, index);
 	painter->save();
 
 	QStyle *style = QApplication::style();
@@ -89,11 +68,12 @@ void SearchResultItemDelegate::paint (QPainter* painter, const QStyleOptionViewI
 	const QBrush highlightBrush(QColor(255, 255, 0), Qt::SolidPattern);
 	const QBrush selectedHighlightBrush(QColor(130, 130, 0), Qt::SolidPattern);
 
-	const QStringList strings = splitStrings(text, matchStart, matchLength);
-	const QPoint textOffset = drawIcon ? QPoint(option.rect.topLeft().x() + iconOffset + icon.width()
+	const QStringList& strings = layout->strings;
+	const QPixmap& icon = layout->icon;
+	const QPoint textOffset = layout->drawIcon ? QPoint(option.rect.topLeft().x() + iconOffset + icon.width()
 										  + iconTextInterval, option.rect.topLeft().y())
 										: option.rect.topLeft();
-	const QList<QRect> rects = calculateRects(strings, textOffset,
+	const QList<QRect> rects = calculateRects(layout->widths, textOffset,
 											  option.rect.height(), painter->fontMetrics());
 
 	painter->setPen(normalPen);
@@ -102,7 +82,7 @@ void SearchResultItemDelegate::paint (QPainter* painter, const QStyleOptionViewI
 						 option.rect.topLeft().y() + iconOffset,
 						 icon.width(),
 						 icon.height());
-	if (drawIcon) {
+	if (layout->drawIcon) {
 		painter->drawPixmap(iconRect, icon);
 	}
 
@@ -130,23 +110,98 @@ QStringList SearchResultItemDelegate::splitStrings(const QString& text, const in
 	return list;
 }
 
-QList<QRect> SearchResultItemDelegate::calculateRects(const QStringList& list,
+QList<QRect> SearchResultItemDelegate::calculateRects(const QList<int>& widths,
 													  const QPoint& offset,
 													  int height,
 													  const QFontMetrics& metrics) const {
 	int actualHeight = qMax(height, metrics.height());
-	const QRect firstStringRect = QRect(0, 0, metrics.width(list.value(0)), actualHeight);
-	const QRect secondStringRect = QRect(0, 0, metrics.width(list.value(1)), actualHeight);
-	const QRect thirdStringRect = QRect(0, 0, metrics.width(list.value(2)), actualHeight);
 
-	const QRect firstStringFinalRect(offset, firstStringRect.size());
+	const QRect firstStringFinalRect(offset.x(), offset.y(), widths.value(0), actualHeight);
 
-	const QRect secondStringFinalRect(offset.x() + firstStringRect.width(), offset.y(),
-								 secondStringRect.width(), secondStringRect.height());
+	const QRect secondStringFinalRect(offset.x() + widths.value(0), offset.y(),
+								 widths.value(1), actualHeight);
 
-	const QRect thirdStringFinalRect(offset.x() + firstStringRect.width() + secondStringRect.width(),
-								offset.y(), thirdStringRect.width(), thirdStringRect.height());
+	const QRect thirdStringFinalRect(offset.x() + widths.value(0) + widths.value(1),
+								offset.y(), widths.value(2), actualHeight);
 	QList<QRect> rects;
 	rects << firstStringFinalRect << secondStringFinalRect << thirdStringFinalRect;
 	return rects;
 }
+
+// Returns split text and widths of fragment. Model is queried if item was not painted yet or was
+// changed since
+const SearchResultItemDelegate::FragmentLayout* SearchResultItemDelegate::fragmentLayout(
+		const BaseModelItem* item, const QModelIndex& index, const QFont& font) const {
+	watchModel(index.model());
+
+	QHash<const BaseModelItem*, FragmentLayout>::const_iterator it = layoutCache.constFind(item);
+	if (it != layoutCache.constEnd() && it.value().font == font) {
+		return &it.value();
+	}
+
+	FragmentLayout layout;
+	layout.font = font;
+	layout.drawIcon = false;
+	if (index.model()->data(index, Qt::DecorationRole).canConvert<QPixmap>()) {
+		layout.icon = index.model()->data(index, Qt::DecorationRole).value<QPixmap>();
+		layout.drawIcon = true;
+	}
+
+	const QString text = index.model()->data(index, Qt::DisplayRole).toString();
+	QVariant tempVariant = index.model()->data(index, SearchModelItem::HighlightStartRole);
+	if (tempVariant.isNull()) {
+		WARNING("Could not retrieve data from item");
+		return 0;
+	}
+	const int matchStart = tempVariant.toInt();
+
+	tempVariant = index.model()->data(index, SearchModelItem::HightlightLengthRole);
+	if (tempVariant.isNull()) {
+		WARNING("Could not retrieve data from item");
+		return 0;
+	}
+	const int matchLength = tempVariant.toInt();
+
+	layout.strings = splitStrings(text, matchStart, matchLength);
+	const QFontMetrics metrics(font);
+	foreach (const QString& string, layout.strings) {
+		layout.widths << metrics.width(string);
+	}
+
+	return &layoutCache.insert(item, layout).value();
+}
+
+void SearchResultItemDelegate::watchModel(const QAbstractItemModel* model) const {
+	if (!model || watchedModels.contains(model)) {return;}
+	watchedModels.insert(model);
+
+	QObject::connect(model, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+					 this, SLOT(sl_Model_DataChanged(QModelIndex,QModelIndex)));
+	// Removed items may be deleted and their addresses reused by new ones
+	QObject::connect(model, SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)),
+					 this, SLOT(sl_Model_ItemsRemoved()));
+	QObject::connect(model, SIGNAL(modelAboutToBeReset()),
+					 this, SLOT(sl_Model_ItemsRemoved()));
+	QObject::connect(model, SIGNAL(destroyed(QObject*)),
+					 this, SLOT(sl_Model_Destroyed(QObject*)));
+}
+
+void SearchResultItemDelegate::sl_Model_DataChanged(const QModelIndex& topLeft,
+													const QModelIndex& bottomRight) {
+	const QAbstractItemModel* model = topLeft.model();
+	if (!model) {return;}
+
+	const QModelIndex parent = topLeft.parent();
+	for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+		layoutCache.remove(static_cast<const BaseModelItem*>(model->index(row, 0, parent).internalPointer()));
+	}
+}
+
+void SearchResultItemDelegate::sl_Model_ItemsRemoved() {
+	layoutCache.clear();
+}
+
+void SearchResultItemDelegate::sl_Model_Destroyed(QObject* model) {
+	watchedModels.remove(model);
+	layoutCache.clear();
+}
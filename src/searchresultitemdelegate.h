@@ -20,8 +20,19 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 
 #include <QStyledItemDelegate>
 #include <QStringList>
+#include <QPixmap>
+#include <QHash>
+#include <QSet>
+
+/*
+  SearchResultItemDelegate draws search result fragments with the matched part highlighted. Split
+  fragment text, widths of its parts and icon are cached per item until the model reports the item
+  changed.
+*/
 
 namespace qNotesManager {
+	class BaseModelItem;
+
 	class SearchResultItemDelegate : public QStyledItemDelegate {
 	Q_OBJECT
 	public:
@@ -30,9 +41,29 @@ namespace qNotesManager {
 		/*virtual*/ void paint (QPainter* painter, const QStyleOptionViewItem& option,
 							const QModelIndex& index) const;
 	private:
+		class FragmentLayout {
+		public:
+			QFont font;
+			QPixmap icon;
+			bool drawIcon;
+			QStringList strings;	// text before match, match and text after match
+			QList<int> widths;		// widths of 'strings'
+		};
+
+		mutable QHash<const BaseModelItem*, FragmentLayout> layoutCache;
+		mutable QSet<const QObject*> watchedModels;
+
+		const FragmentLayout* fragmentLayout(const BaseModelItem*, const QModelIndex&,
+											 const QFont&) const;
+		void watchModel(const QAbstractItemModel*) const;
 		QStringList splitStrings(const QString& text, const int start, const int length) const;
-		QList<QRect> calculateRects(const QStringList& list, const QPoint& offset, int height,
+		QList<QRect> calculateRects(const QList<int>& widths, const QPoint& offset, int height,
 									const QFontMetrics& metrics) const;
+
+	private slots:
+		void sl_Model_DataChanged(const QModelIndex&, const QModelIndex&);
+		void sl_Model_ItemsRemoved();
+		void sl_Model_Destroyed(QObject*);
 	};
 }
 
@@ -26,9 +26,11 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 
 using namespace qNotesManager;
 
-SearchResultsModel::SearchResultsModel(QObject *parent) : BaseModel(parent) {
+SearchResultsModel::SearchResultsModel(QObject *parent) : BaseModel(parent),
+		moreResultsAvailable(false) {
+	// Notes are kept in order they were found, search engine sends best notes first
 	BaseModelItem* root = new BaseModelItem();
-	root->SetSorted(true);
+	root->SetSorted(false);
 	SetRootItem(root);
 }
 
@@ -46,9 +48,6 @@ void SearchResultsModel::AddResult(const NoteFragment& fragment) {
 		noteItem = new NoteModelItem(note);
 		notesHash.insert(fragment.NotePrt, noteItem);
 
-		QObject::connect(noteItem, SIGNAL(sg_DataChanged(BaseModelItem*)),
-						 this, SLOT(sl_Item_DataChanged(BaseModelItem*)));
-
 		int newPosition = GetRootItem()->FindInsertIndex(noteItem);
 
 		beginInsertRows(QModelIndex(), newPosition, newPosition);
@@ -58,8 +57,6 @@ void SearchResultsModel::AddResult(const NoteFragment& fragment) {
 
 	// Add search result to noteItem
 	SearchModelItem* searchResultItem = new SearchModelItem(fragment);
-	QObject::connect(searchResultItem, SIGNAL(sg_DataChanged(BaseModelItem*)),
-					 this, SLOT(sl_Item_DataChanged(BaseModelItem*)));
 	resultsHash.insert(fragment.NotePrt, searchResultItem);
 
 	QModelIndex noteItemIndex = createIndex(GetRootItem()->IndexOfChild(noteItem), 0, noteItem);
@@ -87,6 +84,7 @@ void SearchResultsModel::RemoveResultsForNote(const Note* n) {
 }
 
 void SearchResultsModel::ClearResults() {
+	moreResultsAvailable = false;
 	if (GetRootItem()->ChildrenCount() == 0) {return;}
 	beginRemoveRows(QModelIndex(), 0, GetRootItem()->ChildrenCount() - 1);
 		foreach (const Note* n, notesHash.keys()) {
@@ -108,7 +106,55 @@ bool SearchResultsModel::ContainsResultForNote(const Note* note) {
 	return notesHash.contains(note);
 }
 
-void SearchResultsModel::sl_Item_DataChanged(BaseModelItem* item) {
-	QModelIndex noteItemIndex = createIndex(item->parent()->IndexOfChild(item), 0, item);
-	emit dataChanged(noteItemIndex, noteItemIndex);
+// Updates note items, whose notes were changed, and expires fragments of notes with changed text
+void SearchResultsModel::sl_ChangeBus_ItemsChanged(const ItemChanges& changes) {
+	QList<BaseModelItem*> changedItems;
+	for (ItemChanges::const_iterator it = changes.constBegin(); it != changes.constEnd(); ++it) {
+		if (it.key()->GetItemType() != AbstractFolderItem::Type_Note) {continue;}
+		const Note* note = static_cast<const Note*>(it.key());
+
+		NoteModelItem* noteItem = notesHash.value(note);
+		if (noteItem == 0) {continue;}
+
+		if (it.value() & ItemChangeBus::VisualChanges) {
+			changedItems << noteItem;
+		}
+		if (it.value() & ItemChangeBus::TextChanged) {
+			foreach (SearchModelItem* resultItem, resultsHash.values(note)) {
+				resultItem->SetExpired();
+				changedItems << resultItem;
+			}
+		} else if (it.value() & (ItemChangeBus::NameChanged | ItemChangeBus::PropertiesChanged)) {
+			// Only fragments of changed fields are expired
+			foreach (SearchModelItem* resultItem, resultsHash.values(note)) {
+				const bool captionFragment =
+						resultItem->Fragment().Type == NoteFragment::CaptionFragment;
+				const bool fieldChanged = captionFragment ?
+						(it.value() & ItemChangeBus::NameChanged) != 0 :
+						(it.value() & ItemChangeBus::PropertiesChanged) != 0 &&
+						resultItem->Fragment().Type != NoteFragment::TextFragment;
+				if (!fieldChanged) {continue;}
+				resultItem->SetExpired();
+				changedItems << resultItem;
+			}
+		}
+	}
+
+	EmitItemsDataChanged(changedItems);
+}
+
+void SearchResultsModel::SetMoreResultsAvailable(bool available) {
+	moreResultsAvailable = available;
+}
+
+bool SearchResultsModel::canFetchMore(const QModelIndex& parent) const {
+	return !parent.isValid() && moreResultsAvailable;
+}
+
+// Called by view when it is scrolled to the end of results
+void SearchResultsModel::fetchMore(const QModelIndex& parent) {
+	if (parent.isValid() || !moreResultsAvailable) {return;}
+
+	moreResultsAvailable = false;
+	emit sg_MoreResultsRequested();
 }
@@ -20,6 +20,7 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 
 #include "basemodel.h"
 #include "notefragment.h"
+#include "itemchangebus.h"
 
 #include <QMultiHash>
 
@@ -32,6 +33,7 @@ namespace qNotesManager {
 	private:
 		QHash<const Note*, NoteModelItem*> notesHash;
 		QMultiHash<const Note*, SearchModelItem*> resultsHash;
+		bool moreResultsAvailable;
 
 	public:
 		explicit SearchResultsModel(QObject *parent = 0);
@@ -42,8 +44,15 @@ namespace qNotesManager {
 		void ClearResults();
 		void UpdateEntry(const Note*);
 
-	private slots:
-		void sl_Item_DataChanged(BaseModelItem*);
+		/*virtual*/ bool canFetchMore(const QModelIndex& parent) const;
+		/*virtual*/ void fetchMore(const QModelIndex& parent);
+
+	public slots:
+		void SetMoreResultsAvailable(bool);
+		void sl_ChangeBus_ItemsChanged(const ItemChanges&);
+
+	signals:
+		void sg_MoreResultsRequested();
 	};
 }
 
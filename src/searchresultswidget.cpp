@@ -21,6 +21,7 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include "application.h"
 #include "document.h"
 #include "documentsearchengine.h"
+#include "itemchangebus.h"
 #include "searchmodelitem.h"
 #include "global.h"
 #include "notemodelitem.h"
@@ -36,6 +37,7 @@ SearchResultsWidget::SearchResultsWidget(DocumentSearchEngine* eng, QWidget *par
 	searchResultsModel = new SearchResultsModel(this);
 
 	treeView = new QTreeView();
+	treeView->setUniformRowHeights(true);
 	treeView->setModel(searchResultsModel);
 	treeView->setItemDelegate(new SearchResultItemDelegate());
 	treeView->setHeaderHidden(true);
@@ -80,9 +82,15 @@ SearchResultsWidget::SearchResultsWidget(DocumentSearchEngine* eng, QWidget *par
 					 this, SLOT(sl_SearchProgress(int)));
 	QObject::connect(engine, SIGNAL(sg_SearchResult(const NoteFragment&)),
 					 this, SLOT(sl_SearchResult(const NoteFragment&)));
+	QObject::connect(engine, SIGNAL(sg_MoreResultsAvailable(bool)),
+					 searchResultsModel, SLOT(SetMoreResultsAvailable(bool)));
+	QObject::connect(searchResultsModel, SIGNAL(sg_MoreResultsRequested()),
+					 this, SLOT(sl_Model_MoreResultsRequested()));
 
 	QObject::connect(Application::I()->CurrentDocument(), SIGNAL(sg_ItemUnregistered(Note*)),
 					 this, SLOT(sl_Document_NoteDeleted(Note*)));
+	QObject::connect(Application::I()->CurrentDocument()->GetChangeBus(), SIGNAL(sg_ItemsChanged(const ItemChanges&)),
+					 searchResultsModel, SLOT(sl_ChangeBus_ItemsChanged(const ItemChanges&)));
 
 	QHBoxLayout* hl = new QHBoxLayout();
 #if QT_VERSION < 0x040300
@@ -215,6 +223,10 @@ void SearchResultsWidget::sl_SearchEnded() {
 	progressBar->setVisible(false);
 }
 
+void SearchResultsWidget::sl_Model_MoreResultsRequested() {
+	engine->FetchMoreResults();
+}
+
 void SearchResultsWidget::sl_SearchProgress(int value) {
 	progressBar->setValue(value);
 }
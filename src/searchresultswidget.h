@@ -66,6 +66,7 @@ namespace qNotesManager {
 		void sl_SearchEnded();
 		void sl_SearchProgress(int);
 		void sl_SearchResult(const NoteFragment&);
+		void sl_Model_MoreResultsRequested();
 
 		void sl_Document_NoteDeleted(Note*);
 		void sl_ListView_DoubleClicked(const QModelIndex&);
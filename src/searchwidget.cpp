@@ -29,14 +29,37 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 
 using namespace qNotesManager;
 
-SearchWidget::SearchWidget(DocumentSearchEngine* eng, QWidget *parent) : QWidget(parent, Qt::Dialog) {
+SearchWidget::SearchWidget(DocumentSearchEngine* eng, QWidget *parent) :
+		QWidget(parent, Qt::Dialog),
+		typingTimer(this) {
 	searchLabel = new QLabel("Search text:", this);
 
 	searchEdit = new QLineEdit(this);
+	searchEdit->setToolTip("Words and \"exact phrases\" to search for. Filters:\n"
+						   "tag:name - notes with tag\n"
+						   "in:\"Folder/Subfolder\" - notes inside of folder\n"
+						   "created:2014, modified:>2014-01, textdate:<=2014-02-15,\n"
+						   "created:2013..2014-06 - notes by date");
 
 	useRegexp = new QCheckBox("Use regexp", this);
 	matchCase = new QCheckBox("Match case", this);
 	matchWholeWord = new QCheckBox("Match whole word", this);
+	searchAsYouType = new QCheckBox("Search as you type", this);
+
+	typingTimer.setInterval(150);
+	typingTimer.setSingleShot(true);
+	QObject::connect(&typingTimer, SIGNAL(timeout()), this, SLOT(sl_TypingTimer_Timeout()));
+
+	QObject::connect(searchEdit, SIGNAL(textChanged(QString)),
+					 this, SLOT(sl_SearchQuery_Changed()));
+	QObject::connect(useRegexp, SIGNAL(toggled(bool)),
+					 this, SLOT(sl_SearchQuery_Changed()));
+	QObject::connect(matchCase, SIGNAL(toggled(bool)),
+					 this, SLOT(sl_SearchQuery_Changed()));
+	QObject::connect(matchWholeWord, SIGNAL(toggled(bool)),
+					 this, SLOT(sl_SearchQuery_Changed()));
+	QObject::connect(searchAsYouType, SIGNAL(toggled(bool)),
+					 this, SLOT(sl_SearchQuery_Changed()));
 
 	searchButton = new QPushButton("Start", this);
 	QObject::connect(searchButton, SIGNAL(clicked()),
@@ -65,6 +88,7 @@ SearchWidget::SearchWidget(DocumentSearchEngine* eng, QWidget *parent) : QWidget
 	mainLayout->addWidget(useRegexp);
 	mainLayout->addWidget(matchCase);
 	mainLayout->addWidget(matchWholeWord);
+	mainLayout->addWidget(searchAsYouType);
 	mainLayout->addWidget(progressBar);
 	mainLayout->addLayout(buttonsLayout);
 	setLayout(mainLayout);
@@ -128,6 +152,26 @@ void SearchWidget::sl_SearchError(QString error) {
 	searchEdit->selectAll();
 }
 
+void SearchWidget::sl_SearchQuery_Changed() {
+	if (!searchAsYouType->isChecked()) {return;}
+
+	if (searchEdit->text().isEmpty() ||
+		!engine->IsQueryValid(searchEdit->text(), useRegexp->isChecked())) {
+		typingTimer.stop();
+		engine->CancelSearch();
+		return;
+	}
+
+	typingTimer.start();
+}
+
+void SearchWidget::sl_TypingTimer_Timeout() {
+	if (searchEdit->text().isEmpty()) {return;}
+
+	engine->StartIncrementalSearch(searchEdit->text(), matchCase->isChecked(),
+								   matchWholeWord->isChecked(), useRegexp->isChecked());
+}
+
 void SearchWidget::sl_CancelButton_Clicked() {
 	close();
 }
@@ -24,6 +24,7 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include <QLineEdit>
 #include <QCheckBox>
 #include <QProgressBar>
+#include <QTimer>
 
 namespace qNotesManager {
 	class DocumentSearchEngine;
@@ -38,9 +39,12 @@ namespace qNotesManager {
 		QCheckBox*				useRegexp;
 		QCheckBox*				matchCase;
 		QCheckBox*				matchWholeWord;
+		QCheckBox*				searchAsYouType;
 		QProgressBar*			progressBar;
 		DocumentSearchEngine*	engine;
 
+		QTimer					typingTimer; // delays search until user stops typing
+
 	public:
 		explicit SearchWidget(DocumentSearchEngine*, QWidget *parent = 0);
 	protected:
@@ -54,6 +58,9 @@ namespace qNotesManager {
 		void sl_SearchEnded();
 		void sl_SearchProgress(int);
 		void sl_SearchError(QString);
+
+		void sl_SearchQuery_Changed();
+		void sl_TypingTimer_Timeout();
 	};
 }
 
@@ -22,7 +22,6 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 
 namespace qNotesManager {
 	class SeparatorModelItem : public BaseModelItem {
-	Q_OBJECT
 	public:
 		explicit SeparatorModelItem();
 		/*virtual*/ Qt::ItemFlags flags () const;
@@ -24,13 +24,16 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include "note.h"
 #include "tag.h"
 #include "folder.h"
+#include "application.h"
 #include "cachedimagefile.h"
+#include "imagestore.h"
 #include "textdocument.h"
 
 #include <QFile>
 #include <QFileInfo>
 #include <QApplication>
 #include <QStack>
+#include <QSet>
 
 using namespace qNotesManager;
 
@@ -79,6 +82,7 @@ void Serializer::sl_start() {
 
 void Serializer::loadDocument() {
 	doc->inInitMode = true;
+	doc->beginBulkLoading();
 
 	emit sg_LoadingStarted();
 
@@ -167,13 +171,17 @@ void Serializer::loadDocument() {
 			loadDocument_v1(buffer);
 			break;
 		case 0x0002:
+		case sharedImagesSpecificationVersion:
+		case imageHashSpecificationVersion:
 			loadDocument_v2(buffer);
 			break;
 		default:
 			WARNING("Wrong case branch");
 			emit sg_LoadingFailed("Unknown file version");
 	}
+	releaseSharedImages();
 
+	doc->endBulkLoading();
 	doc->inInitMode = false;
 }
 
@@ -201,6 +209,8 @@ void Serializer::saveDocument() {
 			saveDocument_v1();
 			break;
 		case 0x0002:
+		case sharedImagesSpecificationVersion:
+		case imageHashSpecificationVersion:
 			saveDocument_v2();
 			break;
 		default:
@@ -405,8 +415,9 @@ void Serializer::loadDocument_v1(BOIBuffer& buffer) {
 			readResult = dataBuffer.read(folderItemID);
 			Note* note = loadNote_v1(dataBuffer);
 
-			if (iconNames.contains(note->iconID)) {
-				note->iconID = iconNames[note->iconID];
+			const QString noteIconID = Application::I()->GetIconID(note->iconIndex);
+			if (iconNames.contains(noteIconID)) {
+				note->iconIndex = Application::I()->GetIconIndex(iconNames[noteIconID]);
 			}
 
 			folderItems.insert(folderItemID, note);
@@ -432,8 +443,9 @@ void Serializer::loadDocument_v1(BOIBuffer& buffer) {
 			readResult = dataBuffer.read(folderID);
 			Folder* folder = loadFolder_v1(dataBuffer);
 
-			if (iconNames.contains(folder->iconID)) {
-				folder->iconID = iconNames[folder->iconID];
+			const QString folderIconID = Application::I()->GetIconID(folder->iconIndex);
+			if (iconNames.contains(folderIconID)) {
+				folder->iconIndex = Application::I()->GetIconIndex(iconNames[folderIconID]);
 			}
 
 			folderItems.insert(folderID, folder);
@@ -525,6 +537,7 @@ void Serializer::loadDocument_v1(BOIBuffer& buffer) {
 
 	dataBuffer.close();
 
+	doc->endBulkLoading();
 	emit sg_LoadingFinished();
 }
 
@@ -645,7 +658,7 @@ void Serializer::saveDocument_v1() {
 		const qint64 blockStartPosition = dataBuffer.pos();
 		quint32 tagID = 1;
 		for (int i = 0; i < doc->allTags.size(); ++i) {
-			const Tag* tag = doc->allTags.value(i);
+			const Tag* tag = doc->allTags.at(i);
 			dataBuffer.write(tagID);
 			tagsIDs.insert(tag, tagID);
 			tagID++;
@@ -667,7 +680,7 @@ void Serializer::saveDocument_v1() {
 		dataBuffer.write(blockSize);
 		const qint64 blockStartPosition = dataBuffer.pos();
 		for (int i = 0; i < doc->allNotes.size(); ++i) {
-			const Note* note = doc->allNotes.value(i);
+			const Note* note = doc->allNotes.at(i);
 			dataBuffer.write(folderOrNoteID);
 			folderItemsIDs.insert(note, folderOrNoteID);
 			folderOrNoteID++;
@@ -694,7 +707,7 @@ void Serializer::saveDocument_v1() {
 
 		// Write user folders
 		for (int i = 0; i < doc->allFolders.size(); ++i) {
-			const Folder* f = doc->allFolders.value(i);
+			const Folder* f = doc->allFolders.at(i);
 			dataBuffer.write(folderOrNoteID);
 			folderItemsIDs.insert(f, folderOrNoteID);
 			folderOrNoteID++;
@@ -751,7 +764,7 @@ void Serializer::saveDocument_v1() {
 		dataBuffer.write(blockSize);
 		const qint64 blockStartPosition = dataBuffer.pos();
 		{
-			foreach (const Tag* tag, doc->allTags) {
+			foreach (const Tag* tag, doc->allTags.toList()) {
 				const quint32 tagID = tagsIDs.value(tag);
 				const quint32 ownersCount = tag->Owners.Count();
 				dataBuffer.write(tagID);
@@ -948,7 +961,7 @@ Note* Serializer::loadNote_v1(BOIBuffer& buffer) {
 	note->author = r_authorArray;
 	note->source = r_sourceArray;
 	note->comment = r_commentArray;
-	note->iconID = r_iconID;
+	note->iconIndex = Application::I()->GetIconIndex(r_iconID);
 	note->nameBackColor.setRgba(r_backColor);
 	note->nameForeColor.setRgba(r_foreColor);
 	note->locked = (bool)r_locked;
@@ -970,7 +983,7 @@ void Serializer::saveNote_v1(const Note* note, BOIBuffer& buffer) {
 	const quint32 w_creationDate = note->creationDate.toTime_t();
 	const quint32 w_modificationDate = note->modificationDate.toTime_t();
 	const quint32 w_textDate = note->textDate.isValid() ? note->textDate.toTime_t() : 0;
-	const QByteArray w_iconID = note->iconID.toLatin1();
+	const QByteArray w_iconID = Application::I()->GetIconID(note->iconIndex).toLatin1();
 	const quint32 w_iconIDSize = w_iconID.size();
 	const QByteArray w_authorArray = note->author.toUtf8();
 	const quint32 w_authorSize = w_authorArray.size();
@@ -1105,7 +1118,7 @@ Folder* Serializer::loadFolder_v1(BOIBuffer& buffer) {
 	folder->nameForeColor.setRgba(r_foreColor);
 	folder->nameBackColor.setRgba(r_backColor);
 	folder->locked = (bool)r_locked;
-	folder->iconID = r_iconID;
+	folder->iconIndex = Application::I()->GetIconIndex(r_iconID);
 	folder->creationDate = QDateTime::fromTime_t(r_creationDate);
 	folder->modificationDate = QDateTime::fromTime_t(r_modificationDate);
 
@@ -1117,7 +1130,7 @@ void Serializer::saveFolder_v1(const Folder* folder, BOIBuffer& buffer) {
 	const quint32 s_captionSize = s_caption.size();
 	const quint32 s_creationDate = folder->creationDate.toTime_t();
 	const quint32 s_modificationDate = folder->modificationDate.toTime_t();
-	const QByteArray s_iconID = folder->iconID.toLatin1();
+	const QByteArray s_iconID = Application::I()->GetIconID(folder->iconIndex).toLatin1();
 	const quint32 s_iconIDSize = s_iconID.size();
 	const quint32 s_backColor = folder->nameBackColor.rgba();
 	const quint32 s_foreColor = folder->nameForeColor.rgba();
@@ -1330,6 +1343,10 @@ void Serializer::loadDocument_v2(BOIBuffer& buffer) {
 		}
 	}
 
+	if (doc->fileVersion >= sharedImagesSpecificationVersion) {
+		loadSharedImages(dataBuffer);
+	}
+
 	QHash<quint32, Tag*> tagsIDs;
 	// Reading tags
 	{
@@ -1493,6 +1510,7 @@ void Serializer::loadDocument_v2(BOIBuffer& buffer) {
 
 	dataBuffer.close();
 
+	doc->endBulkLoading();
 	emit sg_LoadingFinished();
 }
 
@@ -1509,7 +1527,7 @@ void Serializer::saveDocument_v2() {
 
 	writeResult = fileDataBuffer.write(fileSignature, 9);
 
-	writeResult = fileDataBuffer.write(doc->fileVersion);
+	writeResult = fileDataBuffer.write(saveVersion);
 	writeResult = fileDataBuffer.write(doc->compressionLevel);
 	writeResult = fileDataBuffer.write(doc->cipherID);
 
@@ -1603,6 +1621,10 @@ void Serializer::saveDocument_v2() {
 		dataBuffer.seek(lastPos);
 	}
 
+	if (saveVersion >= sharedImagesSpecificationVersion) {
+		saveSharedImages(dataBuffer);
+	}
+
 	// Write tags
 	QHash<const Tag*, quint32> tagsIDs;
 	{
@@ -1613,7 +1635,7 @@ void Serializer::saveDocument_v2() {
 		const qint64 blockStartPosition = dataBuffer.pos();
 		quint32 tagID = 1;
 		for (int i = 0; i < doc->allTags.size(); ++i) {
-			const Tag* tag = doc->allTags.value(i);
+			const Tag* tag = doc->allTags.at(i);
 			dataBuffer.write(tagID);
 			tagsIDs.insert(tag, tagID);
 			tagID++;
@@ -1635,11 +1657,15 @@ void Serializer::saveDocument_v2() {
 		dataBuffer.write(blockSize);
 		const qint64 blockStartPosition = dataBuffer.pos();
 		for (int i = 0; i < doc->allNotes.size(); ++i) {
-			const Note* note = doc->allNotes.value(i);
+			const Note* note = doc->allNotes.at(i);
 			dataBuffer.write(folderOrNoteID);
 			folderItemsIDs.insert(note, folderOrNoteID);
 			folderOrNoteID++;
-			saveNote_v2(note, dataBuffer);
+			if (!saveNote_v2(note, dataBuffer)) {
+				emit sg_SavingFailed(QString("Could not read attached files of note '%1'")
+									 .arg(note->GetName()));
+				return;
+			}
 		}
 		const qint64 blockEndPosition = dataBuffer.pos();
 		blockSize = blockEndPosition - blockStartPosition;
@@ -1662,7 +1688,7 @@ void Serializer::saveDocument_v2() {
 
 		// Write user folders
 		for (int i = 0; i < doc->allFolders.size(); ++i) {
-			const Folder* f = doc->allFolders.value(i);
+			const Folder* f = doc->allFolders.at(i);
 			dataBuffer.write(folderOrNoteID);
 			folderItemsIDs.insert(f, folderOrNoteID);
 			folderOrNoteID++;
@@ -1719,7 +1745,7 @@ void Serializer::saveDocument_v2() {
 		dataBuffer.write(blockSize);
 		const qint64 blockStartPosition = dataBuffer.pos();
 		{
-			foreach (const Tag* tag, doc->allTags) {
+			foreach (const Tag* tag, doc->allTags.toList()) {
 				const quint32 tagID = tagsIDs.value(tag);
 				const quint32 ownersCount = tag->Owners.Count();
 				dataBuffer.write(tagID);
@@ -1742,7 +1768,7 @@ void Serializer::saveDocument_v2() {
 	{
 		quint32 bookmarksCount = doc->bookmarks.count();
 		dataBuffer.write(bookmarksCount);
-		foreach(Note* note, doc->bookmarks) {
+		foreach(Note* note, doc->bookmarks.toList()) {
 			quint32 bookmarkID = folderItemsIDs[note];
 			dataBuffer.write(bookmarkID);
 		}
@@ -1857,6 +1883,23 @@ Note* Serializer::loadNote_v2(BOIBuffer& buffer) {
 		quint32 imagesSize = 0;
 
 		while(imagesSize < r_imagesListSize) {
+			if (doc->fileVersion >= sharedImagesSpecificationVersion) {
+				quint32 r_imageMD5Size = 0;
+				bytesRead = buffer.read(r_imageMD5Size);
+				QByteArray r_imageMD5(r_imageMD5Size, 0x0);
+				bytesRead = buffer.read(r_imageMD5.data(), r_imageMD5Size);
+
+				CachedImageFile* image = sharedImages.value(r_imageMD5);
+				if (image) {
+					images.push_back(image);
+				} else {
+					WARNING("Image not found");
+				}
+
+				imagesSize += sizeof(r_imageMD5Size) + r_imageMD5Size;
+				continue;
+			}
+
 			quint32 r_imageNameSize = 0;
 			bytesRead = buffer.read(r_imageNameSize);
 			QByteArray r_imageName(r_imageNameSize, 0x0);
@@ -1901,10 +1944,9 @@ Note* Serializer::loadNote_v2(BOIBuffer& buffer) {
 			quint32 r_fileArraySize = 0;
 			bytesRead = buffer.read(r_fileArraySize);
 
-			QByteArray r_fileArray(r_fileArraySize, 0x0);
-			bytesRead = buffer.read(r_fileArray.data(), r_fileArraySize);
-
-			CachedFile* file = new CachedFile(r_fileArray, r_fileName);
+			// Attachment goes to a storage file and doesn't stay in memory, unless document is encrypted
+			CachedFile* file = CachedFile::FromBuffer(buffer, r_fileArraySize, r_fileName,
+													  doc->cipherID == 0);
 			attachedFiles.push_back(file);
 
 			loadedDataSize +=	sizeof(r_fileNameSize) +
@@ -1929,7 +1971,7 @@ Note* Serializer::loadNote_v2(BOIBuffer& buffer) {
 	note->author = r_authorArray;
 	note->source = r_sourceArray;
 	note->comment = r_commentArray;
-	note->iconID = r_iconID;
+	note->iconIndex = Application::I()->GetIconIndex(r_iconID);
 	note->nameBackColor.setRgba(r_backColor);
 	note->nameForeColor.setRgba(r_foreColor);
 	note->locked = (bool)r_locked;
@@ -1945,7 +1987,8 @@ Note* Serializer::loadNote_v2(BOIBuffer& buffer) {
 	return note;
 }
 
-void Serializer::saveNote_v2(const Note* note, BOIBuffer& buffer) {
+// Returns false if an attached file could not be read, the note must not be saved then
+bool Serializer::saveNote_v2(const Note* note, BOIBuffer& buffer) {
 	const QByteArray w_captionArray = note->name.toUtf8();
 	const quint32 w_captionSize = w_captionArray.size();
 	const QByteArray w_textArray = note->cachedHtml.isNull() ?
@@ -1954,7 +1997,7 @@ void Serializer::saveNote_v2(const Note* note, BOIBuffer& buffer) {
 	const quint32 w_creationDate = note->creationDate.toTime_t();
 	const quint32 w_modificationDate = note->modificationDate.toTime_t();
 	const quint32 w_textDate = note->textDate.isValid() ? note->textDate.toTime_t() : 0;
-	const QByteArray w_iconID = note->iconID.toLatin1();
+	const QByteArray w_iconID = Application::I()->GetIconID(note->iconIndex).toLatin1();
 	const quint32 w_iconIDSize = w_iconID.size();
 	const QByteArray w_authorArray = note->author.toUtf8();
 	const quint32 w_authorSize = w_authorArray.size();
@@ -1967,12 +2010,8 @@ void Serializer::saveNote_v2(const Note* note, BOIBuffer& buffer) {
 	const quint8 w_locked = (quint8)note->locked;
 
 	// Write images to temporary buffer
-	QStringList imagesNamesList;
-	if (note->textDocumentInitialized) {
-		imagesNamesList = note->document->GetImagesList();
-	} else {
-		imagesNamesList = note->document->GetResourceImagesList();
-	}
+	const QStringList imagesNamesList = notesImages.contains(note) ?
+										notesImages.take(note) : noteImagesList(note);
 
 	QByteArray imagesArray;
 	BOIBuffer imagesArrayBuffer(&imagesArray);
@@ -1985,6 +2024,15 @@ void Serializer::saveNote_v2(const Note* note, BOIBuffer& buffer) {
 			continue;
 		}
 
+		if (saveVersion >= sharedImagesSpecificationVersion) {
+			// Image itself was written to shared images block
+			const QByteArray md5Array = imageName.toLatin1();
+			const quint32 md5ArraySize = md5Array.size();
+			imagesArrayBuffer.write(md5ArraySize);
+			imagesArrayBuffer.write(md5Array.constData(), md5ArraySize);
+			continue;
+		}
+
 		QByteArray imageNameArray = image->GetFileName().toUtf8();
 		const quint32 imageNameSize = imageNameArray.size();
 
@@ -2018,7 +2066,10 @@ void Serializer::saveNote_v2(const Note* note, BOIBuffer& buffer) {
 
 		const quint32 fileArraySize = file->Size();
 		attachedFilesArrayBuffer.write(fileArraySize);
-		attachedFilesArrayBuffer.write(file->GetData(), fileArraySize);
+		if (!file->WriteTo(attachedFilesArrayBuffer)) {
+			WARNING("Could not read attached file");
+			return false;
+		}
 	}
 	attachedFilesArrayBuffer.close();
 
@@ -2071,6 +2122,124 @@ void Serializer::saveNote_v2(const Note* note, BOIBuffer& buffer) {
 	result = buffer.write(imagesArray);
 	result = buffer.write(w_fileaArraySize);
 	result = buffer.write(attachedFilesArray);
+	return true;
+}
+
+QStringList Serializer::noteImagesList(const Note* note) const {
+	if (note->textDocumentInitialized) {
+		return note->document->GetImagesList();
+	} else {
+		return note->document->GetResourceImagesList();
+	}
+}
+
+// Reads images of all notes. They are kept in ImageStore until notes are loaded
+void Serializer::loadSharedImages(BOIBuffer& buffer) {
+	quint32 blockSize = 0;
+	buffer.read(blockSize);
+	const qint64 blockEnd = buffer.pos() + blockSize;
+
+	while (buffer.pos() < blockEnd) {
+		quint32 r_md5Size = 0;
+		buffer.read(r_md5Size);
+		QByteArray r_md5(r_md5Size, 0x0);
+		buffer.read(r_md5.data(), r_md5Size);
+
+		quint64 r_hash = 0;
+		if (doc->fileVersion >= imageHashSpecificationVersion) {
+			buffer.read(r_hash);
+		}
+
+		quint32 r_nameSize = 0;
+		buffer.read(r_nameSize);
+		QByteArray r_name(r_nameSize, 0x0);
+		buffer.read(r_name.data(), r_nameSize);
+
+		quint32 r_formatSize = 0;
+		buffer.read(r_formatSize);
+		QByteArray r_format(r_formatSize, 0x0);
+		buffer.read(r_format.data(), r_formatSize);
+
+		quint32 r_dataSize = 0;
+		buffer.read(r_dataSize);
+		QByteArray r_data(r_dataSize, 0x0);
+		buffer.read(r_data.data(), r_dataSize);
+
+		CachedImageFile* image = new CachedImageFile(r_data, r_name, r_format);
+		image->SetMD5(QString::fromLatin1(r_md5));
+		if (doc->fileVersion >= imageHashSpecificationVersion) {
+			image->SetHash(r_hash);
+		}
+		image = ImageStore::I()->Acquire(image);
+		if (sharedImages.contains(r_md5)) {
+			ImageStore::I()->Release(image);
+		} else {
+			sharedImages.insert(r_md5, image);
+		}
+
+		sendProgressSignal(&buffer);
+	}
+}
+
+// Writes every image used by notes once
+void Serializer::saveSharedImages(BOIBuffer& buffer) {
+	quint32 blockSize = 0;
+	const qint64 blockSizePosition = buffer.pos();
+	buffer.write(blockSize);
+	const qint64 blockStartPosition = buffer.pos();
+
+	notesImages.clear();
+	QSet<QString> writtenImages;
+	for (int i = 0; i < doc->allNotes.size(); ++i) {
+		const Note* note = doc->allNotes.at(i);
+		const QStringList imagesNamesList = noteImagesList(note);
+		notesImages.insert(note, imagesNamesList);
+
+		foreach (const QString& imageName, imagesNamesList) {
+			if (writtenImages.contains(imageName)) {continue;}
+
+			const CachedImageFile* image = note->document->GetResourceImage(imageName);
+			if (!image) {continue;}
+			writtenImages.insert(imageName);
+
+			const QByteArray md5Array = imageName.toLatin1();
+			const quint32 md5ArraySize = md5Array.size();
+			buffer.write(md5ArraySize);
+			buffer.write(md5Array.constData(), md5ArraySize);
+
+			if (saveVersion >= imageHashSpecificationVersion) {
+				buffer.write(image->GetHash());
+			}
+
+			const QByteArray nameArray = image->GetFileName().toUtf8();
+			const quint32 nameArraySize = nameArray.size();
+			buffer.write(nameArraySize);
+			buffer.write(nameArray.constData(), nameArraySize);
+
+			const QByteArray formatArray = image->GetFormat().toLatin1();
+			const quint32 formatArraySize = formatArray.size();
+			buffer.write(formatArraySize);
+			buffer.write(formatArray.constData(), formatArraySize);
+
+			const quint32 dataSize = image->Size();
+			buffer.write(dataSize);
+			buffer.write(image->GetData(), dataSize);
+		}
+	}
+
+	const qint64 blockEndPosition = buffer.pos();
+	blockSize = blockEndPosition - blockStartPosition;
+	buffer.seek(blockSizePosition);
+	buffer.write(blockSize);
+	buffer.seek(blockEndPosition);
+}
+
+// Drops references taken by loadSharedImages, images used by notes stay in ImageStore
+void Serializer::releaseSharedImages() {
+	foreach (CachedImageFile* image, sharedImages) {
+		ImageStore::I()->Release(image);
+	}
+	sharedImages.clear();
 }
 
 Folder* Serializer::loadFolder_v2(BOIBuffer& buffer) {
@@ -25,6 +25,8 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include "boibuffer.h"
 
 namespace qNotesManager {
+	class CachedImageFile;
+
 	class Serializer : public QObject {
 	Q_OBJECT
 		enum Operation {Unknown, Loading, Saving};
@@ -56,16 +58,34 @@ namespace qNotesManager {
 		Folder*	loadFolder_v2(BOIBuffer&);
 		Tag*	loadTag_v2(BOIBuffer&);
 
-		void	saveNote_v2(const Note*, BOIBuffer&);
+		bool	saveNote_v2(const Note*, BOIBuffer&);
 		void	saveFolder_v2(const Folder*, BOIBuffer&);
 		void	saveTag_v2(const Tag*, BOIBuffer&);
 
+		// Ver 1.0 is ver 2, where note images are written once in a separate block and notes refer
+		// to them by MD5. Layout of notes is changed, so major byte is raised
+		static const quint16 sharedImagesSpecificationVersion = 0x0100;
+		QHash<QString, CachedImageFile*> sharedImages;	// loaded images by MD5
+
+		// Ver 2.0 is ver 1.0, where hash of every shared image is written after its MD5, so images
+		// are not hashed again on loading. Images block layout is changed, so major byte is raised
+		static const quint16 imageHashSpecificationVersion = 0x0200;
+		QHash<const Note*, QStringList> notesImages;		// names of images to save for each note
+
+		void	loadSharedImages(BOIBuffer&);
+		void	saveSharedImages(BOIBuffer&);
+		void	releaseSharedImages();
+		QStringList noteImagesList(const Note*) const;
+
 		void sendProgressSignal(BOIBuffer*);
 
 	public:
 		explicit Serializer();
 
-		static const quint16 lastSupportedSpecificationVersion = 0x0002;
+		// Version is 0xMMmm. Major byte is raised when file layout changes, programs that support
+		// lower major version refuse to load such files. Minor byte is raised when data is only
+		// appended, so programs that support lower minor version can load files, skipping new data
+		static const quint16 lastSupportedSpecificationVersion = imageHashSpecificationVersion;
 		static const quint16 actualSpecificationVersion = lastSupportedSpecificationVersion;
 
 		void Load(Document* d, const QString& fileNameToLoad);
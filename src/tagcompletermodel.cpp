@@ -0,0 +1,95 @@
+/*
+This file is part of qNotesManager.
+
+qNotesManager is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+qNotesManager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tagcompletermodel.h"
+
+#include "tagslistmodel.h"
+#include "global.h"
+
+using namespace qNotesManager;
+
+TagCompleterModel::TagCompleterModel(QObject* parent) : QAbstractListModel(parent),
+		sourceModel(0),
+		tagIcon(":/gui/tag") {
+}
+
+void TagCompleterModel::SetSourceModel(TagsListModel* model) {
+	if (sourceModel == model) {return;}
+
+	if (sourceModel) {
+		QObject::disconnect(sourceModel, 0, this, 0);
+	}
+	sourceModel = model;
+	if (sourceModel) {
+		QObject::connect(sourceModel, SIGNAL(rowsInserted(QModelIndex,int,int)),
+						 this, SLOT(sl_SourceModel_Changed()));
+		QObject::connect(sourceModel, SIGNAL(rowsRemoved(QModelIndex,int,int)),
+						 this, SLOT(sl_SourceModel_Changed()));
+		QObject::connect(sourceModel, SIGNAL(modelReset()),
+						 this, SLOT(sl_SourceModel_Changed()));
+		QObject::connect(sourceModel, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+						 this, SLOT(sl_SourceModel_Changed()));
+		QObject::connect(sourceModel, SIGNAL(destroyed()),
+						 this, SLOT(sl_SourceModel_Destroyed()));
+	}
+
+	sl_SourceModel_Changed();
+}
+
+void TagCompleterModel::SetFilter(const QString& f) {
+	filter = f;
+
+	beginResetModel();
+	matches = sourceModel ? sourceModel->FindTags(filter, MaxMatches) : QStringList();
+	endResetModel();
+}
+
+int TagCompleterModel::rowCount(const QModelIndex& parent) const {
+	if (parent.isValid()) {return 0;}
+
+	return matches.size();
+}
+
+QVariant TagCompleterModel::data(const QModelIndex& index, int role) const {
+	if (!index.isValid() || index.row() >= matches.size()) {return QVariant();}
+
+	switch (role) {
+	case Qt::DisplayRole:
+	case Qt::EditRole:
+		return matches.at(index.row());
+	case Qt::DecorationRole:
+		return tagIcon;
+	default:
+		return QVariant();
+	}
+}
+
+// Matches may contain removed names
+void TagCompleterModel::sl_SourceModel_Changed() {
+	filter.clear();
+
+	if (!matches.isEmpty()) {
+		beginResetModel();
+		matches.clear();
+		endResetModel();
+	}
+}
+
+void TagCompleterModel::sl_SourceModel_Destroyed() {
+	sourceModel = 0;
+	sl_SourceModel_Changed();
+}
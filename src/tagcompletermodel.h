@@ -0,0 +1,59 @@
+/*
+This file is part of qNotesManager.
+
+qNotesManager is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+qNotesManager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TAGCOMPLETERMODEL_H
+#define TAGCOMPLETERMODEL_H
+
+#include <QAbstractListModel>
+#include <QStringList>
+#include <QIcon>
+
+/*
+  TagCompleterModel shows tags of document's tags list that contain a filter string, ignoring case.
+  Tags that start with the filter go first. Matches are looked up in suffix index of the tags list,
+  which is shared by completers of all notes.
+*/
+
+namespace qNotesManager {
+	class TagsListModel;
+
+	class TagCompleterModel : public QAbstractListModel {
+	Q_OBJECT
+	private:
+		TagsListModel* sourceModel;
+		QIcon tagIcon;
+		QString filter;
+		QStringList matches;
+
+		static const int MaxMatches = 500;
+
+	public:
+		explicit TagCompleterModel(QObject* parent = 0);
+
+		void SetSourceModel(TagsListModel*);
+		void SetFilter(const QString&);
+
+		/*virtual*/ int rowCount(const QModelIndex& parent = QModelIndex()) const;
+		/*virtual*/ QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
+
+	private slots:
+		void sl_SourceModel_Changed();
+		void sl_SourceModel_Destroyed();
+	};
+}
+
+#endif // TAGCOMPLETERMODEL_H
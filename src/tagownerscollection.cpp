@@ -50,7 +50,7 @@ void TagOwnersCollection::Remove(Note* note) {
 	}
 
 	emit sg_ItemAboutToBeRemoved(note);
-	owners.removeAll(note);
+	owners.removeOne(note);
 	emit sg_ItemRemoved(note);
 }
 
@@ -22,6 +22,8 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include <QList>
 #include <QReadWriteLock>
 
+#include "indexedlist.h"
+
 namespace qNotesManager {
 	class Tag;
 	class Note;
@@ -32,7 +34,7 @@ namespace qNotesManager {
 	friend class NoteTagsCollection;
 
 	private:
-		QList<Note*> owners;
+		IndexedList<Note> owners;
 
 		void Add(Note* note);
 		void Remove(Note* note);
@@ -17,6 +17,8 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 
 #include "tagslineedit.h"
 
+#include "tagcompletermodel.h"
+
 #include <QCompleter>
 #include <QListView>
 #include <QRect>
@@ -26,6 +28,7 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 using namespace qNotesManager;
 
 TagsLineEdit::TagsLineEdit (QWidget *parent) : QLineEdit(parent) {
+	completerModel = new TagCompleterModel(this);
 	completer = new QCompleter(this);
 	QObject::connect(completer, SIGNAL(activated(QString)),
 					 this, SLOT(sl_Completer_Activated(QString)));
@@ -33,14 +36,16 @@ TagsLineEdit::TagsLineEdit (QWidget *parent) : QLineEdit(parent) {
 	completer->setPopup(listView);
 	completer->setWidget(this);
 	completer->setCaseSensitivity(Qt::CaseInsensitive);
-	completer->setModelSorting(QCompleter::CaseSensitivelySortedModel);
+	// Model filters tags itself, completer shows everything it has
+	completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+	completer->setModel(completerModel);
 
 	connect(this, SIGNAL(textEdited(QString)),
 			this, SLOT(sl_textEdited(QString)));
 }
 
-void TagsLineEdit::SetTagsModel(QAbstractItemModel* model) {
-	completer->setModel(model);
+void TagsLineEdit::SetTagsModel(TagsListModel* model) {
+	completerModel->SetSourceModel(model);
 }
 
 void TagsLineEdit::editingFinished() {
@@ -125,6 +130,7 @@ void TagsLineEdit::sl_textEdited (const QString&) {
 
 	QString prefix = text.mid(start, end - start).trimmed();
 	if (!prefix.isEmpty()) {
+		completerModel->SetFilter(prefix);
 		completer->setCompletionPrefix(prefix);
 		qDebug() << "Prefix set: " << prefix;
 		completer->complete();
@@ -23,16 +23,20 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include <QAbstractItemModel>
 
 namespace qNotesManager {
+	class TagCompleterModel;
+	class TagsListModel;
+
 	class TagsLineEdit : public QLineEdit {
 	Q_OBJECT
 
 	private:
 		QCompleter* completer;
+		TagCompleterModel* completerModel;
 		void editingFinished();
 
 	public:
 		explicit TagsLineEdit(QWidget *parent = 0);
-		void SetTagsModel(QAbstractItemModel*);
+		void SetTagsModel(TagsListModel*);
 
 	protected:
 		virtual void focusOutEvent (QFocusEvent* event);
@@ -0,0 +1,108 @@
+/*
+This file is part of qNotesManager.
+
+qNotesManager is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+qNotesManager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tagslistmodel.h"
+
+#include "global.h"
+
+#include <algorithm>
+
+using namespace qNotesManager;
+
+TagsListModel::TagsListModel(QObject* parent) : QAbstractListModel(parent),
+		tagIcon(":/gui/tag"),
+		bulkUpdate(false) {
+}
+
+// Returns position of first name that is not less than 'name'
+int TagsListModel::lowerBound(const QString& name) const {
+	return std::lower_bound(names.begin(), names.end(), name) - names.begin();
+}
+
+void TagsListModel::AddTag(const QString& name) {
+	if (bulkUpdate) {
+		names.append(name);
+		return;
+	}
+
+	const int position = lowerBound(name);
+	if (position < names.size() && names.at(position) == name) {
+		WARNING("Tag is already in the list");
+		return;
+	}
+
+	index.AddName(name);
+	beginInsertRows(QModelIndex(), position, position);
+	names.insert(position, name);
+	endInsertRows();
+}
+
+void TagsListModel::RemoveTag(const QString& name) {
+	if (bulkUpdate) {
+		names.removeOne(name);
+		return;
+	}
+
+	const int position = lowerBound(name);
+	if (position == names.size() || names.at(position) != name) {
+		WARNING("Tag is not in the list");
+		return;
+	}
+
+	index.RemoveName(name);
+	beginRemoveRows(QModelIndex(), position, position);
+	names.removeAt(position);
+	endRemoveRows();
+}
+
+void TagsListModel::BeginBulkUpdate() {
+	bulkUpdate = true;
+}
+
+void TagsListModel::EndBulkUpdate() {
+	if (!bulkUpdate) {return;}
+	bulkUpdate = false;
+
+	beginResetModel();
+	std::sort(names.begin(), names.end());
+	index.Rebuild(names);
+	endResetModel();
+}
+
+QStringList TagsListModel::FindTags(const QString& filter, int maxMatches) const {
+	return index.Find(filter, maxMatches);
+}
+
+int TagsListModel::rowCount(const QModelIndex& parent) const {
+	if (parent.isValid()) {return 0;}
+
+	return names.size();
+}
+
+QVariant TagsListModel::data(const QModelIndex& index, int role) const {
+	if (!index.isValid() || index.row() >= names.size()) {return QVariant();}
+
+	switch (role) {
+	case Qt::DisplayRole:
+	case Qt::EditRole:
+		return names.at(index.row());
+	case Qt::DecorationRole:
+		return tagIcon;
+	default:
+		return QVariant();
+	}
+}
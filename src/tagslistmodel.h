@@ -0,0 +1,61 @@
+/*
+This file is part of qNotesManager.
+
+qNotesManager is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+qNotesManager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TAGSLISTMODEL_H
+#define TAGSLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QStringList>
+#include <QIcon>
+
+#include "tagssuffixindex.h"
+
+/*
+  TagsListModel is a flat list of document's tag names sorted case sensitively, used by completers
+  in TagsLineEdit. Names are inserted and removed by binary search. During bulk update names are
+  collected unsorted and sorted once in EndBulkUpdate. Suffix index of the names is shared by all
+  completers of the document.
+*/
+
+namespace qNotesManager {
+	class TagsListModel : public QAbstractListModel {
+	Q_OBJECT
+	private:
+		QStringList names;
+		QIcon tagIcon;
+		bool bulkUpdate;
+		TagsSuffixIndex index;
+
+		int lowerBound(const QString& name) const;
+
+	public:
+		explicit TagsListModel(QObject* parent = 0);
+
+		void AddTag(const QString& name);
+		void RemoveTag(const QString& name);
+
+		void BeginBulkUpdate();
+		void EndBulkUpdate();
+
+		QStringList FindTags(const QString& filter, int maxMatches) const;
+
+		/*virtual*/ int rowCount(const QModelIndex& parent = QModelIndex()) const;
+		/*virtual*/ QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
+	};
+}
+
+#endif // TAGSLISTMODEL_H
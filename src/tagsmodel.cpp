@@ -25,10 +25,14 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include "global.h"
 
 #include <QList>
+#include <QVector>
+#include <QPair>
+
+#include <algorithm>
 
 using namespace qNotesManager;
 
-TagsModel::TagsModel(Document *doc) : BaseModel(doc) {
+TagsModel::TagsModel(Document *doc) : BaseModel(doc), document(doc), bulkUpdate(false) {
 	BaseModelItem* root = new BaseModelItem();
 	root->SetSorted(true);
 	SetRootItem(root);
@@ -42,14 +46,164 @@ TagsModel::TagsModel(Document *doc) : BaseModel(doc) {
 					 this, SLOT(sl_Document_TagRegistered(Tag*)));
 	QObject::connect(doc, SIGNAL(sg_ItemUnregistered(Tag*)),
 					 this, SLOT(sl_Document_TagUnregistered(Tag*)));
+	QObject::connect(doc->GetChangeBus(), SIGNAL(sg_ItemsChanged(const ItemChanges&)),
+					 this, SLOT(sl_ChangeBus_ItemsChanged(const ItemChanges&)));
 
 	const QList<Tag*> tags = doc->GetTagsList();
+	if (tags.isEmpty()) {return;}
+
+	BeginBulkUpdate();
 	foreach (Tag* tag, tags) {
 		sl_Document_TagRegistered(tag);
 	}
+	EndBulkUpdate();
+}
+
+// While bulk update is active, registered tags are only subscribed to and owners changes are
+// ignored. The tree is built in one pass when update ends
+void TagsModel::BeginBulkUpdate() {
+	bulkUpdate = true;
+}
+
+void TagsModel::EndBulkUpdate() {
+	if (!bulkUpdate) {return;}
+	bulkUpdate = false;
+	rebuild();
+}
+
+// Builds tag items from document tags and publishes them with a single model reset. Owners of a tag
+// are created in fetchMore(), when tag item is expanded
+void TagsModel::rebuild() {
+	const QList<Tag*> tags = document->GetTagsList();
+
+	QVector<QPair<QString, Tag*> > sortedTags;
+	sortedTags.reserve(tags.size());
+	foreach (Tag* tag, tags) {
+		sortedTags.append(qMakePair(tag->GetName().toUpper(), tag));
+	}
+	std::sort(sortedTags.begin(), sortedTags.end());
+
+	notesBridge.clear();
+	tagsBridge.clear();
+	populatedItems.clear();
+
+	BaseModelItem* root = new BaseModelItem();
+	root->SetSorted(true);
+
+	for (int i = 0; i < sortedTags.size(); ++i) {
+		root->AddChild(createTagItem(sortedTags.at(i).second));
+	}
+
+	ResetRootItem(root);
+}
+
+TagModelItem* TagsModel::createTagItem(Tag* tag) {
+	TagModelItem* item = new TagModelItem(tag);
+	item->SetSorted(true);
+	tagsBridge.insert(tag, item);
+	return item;
+}
+
+NoteModelItem* TagsModel::createNoteItem(Note* note) {
+	NoteModelItem* noteItem = new NoteModelItem(note);
+	notesBridge.insert(note, noteItem);
+	return noteItem;
+}
+
+// Removes and deletes all note items of tag item
+void TagsModel::removeNoteItems(BaseModelItem* tagItem) {
+	if (tagItem->ChildrenCount() == 0) {return;}
+
+	QModelIndex tagIndex = createIndex(GetRootItem()->IndexOfChild(tagItem), 0, tagItem);
+
+	beginRemoveRows(tagIndex, 0, tagItem->ChildrenCount() - 1);
+		for (int i = 0; i < tagItem->ChildrenCount(); ++i) {
+			BaseModelItem* childItem = tagItem->ChildAt(i);
+			if (childItem->DataType() != BaseModelItem::note) {
+				WARNING("Item has wrong type");
+				continue;
+			}
+			NoteModelItem* noteItem = dynamic_cast<NoteModelItem*>(childItem);
+			Note* note = noteItem->GetStoredData();
+			notesBridge.remove(note, noteItem);
+			delete noteItem;
+		}
+		tagItem->ClearChildrenList();
+	endRemoveRows();
+}
+
+// Views ask hasChildren() of an item again only when its rows change. When tag gets its first owner,
+// the owner is created right away. When tag loses the last one, its row is removed and inserted back.
+// Otherwise only the item is repainted
+void TagsModel::updateUnpopulatedTag(const Tag* tag, const QModelIndex& tagIndex, bool ownerAdded) {
+	const int previousCount = tag->Owners.Count() + (ownerAdded ? -1 : 1);
+	if ((previousCount > 0) == (tag->Owners.Count() > 0)) {
+		emit dataChanged(tagIndex, tagIndex);
+		return;
+	}
+
+	if (ownerAdded) {
+		fetchMore(tagIndex);
+		return;
+	}
+
+	BaseModelItem* root = GetRootItem();
+	BaseModelItem* tagItem = static_cast<BaseModelItem*>(tagIndex.internalPointer());
+	const int row = tagIndex.row();
+
+	beginRemoveRows(QModelIndex(), row, row);
+		root->RemoveChild(tagItem);
+	endRemoveRows();
+
+	beginInsertRows(QModelIndex(), row, row);
+		root->AddChildTo(tagItem, row);
+	endInsertRows();
+}
+
+/*virtual*/
+bool TagsModel::hasChildren(const QModelIndex& parent) const {
+	if (canFetchMore(parent)) {
+		const TagModelItem* tagItem = static_cast<TagModelItem*>(parent.internalPointer());
+		return tagItem->GetTag()->Owners.Count() > 0;
+	}
+	return BaseModel::hasChildren(parent);
+}
+
+/*virtual*/
+bool TagsModel::canFetchMore(const QModelIndex& parent) const {
+	if (!parent.isValid()) {return false;}
+	const BaseModelItem* item = static_cast<BaseModelItem*>(parent.internalPointer());
+	return item->DataType() == BaseModelItem::tag && !populatedItems.contains(item);
+}
+
+/*virtual*/
+void TagsModel::fetchMore(const QModelIndex& parent) {
+	if (!canFetchMore(parent)) {return;}
+
+	TagModelItem* tagItem = static_cast<TagModelItem*>(parent.internalPointer());
+	populatedItems.insert(tagItem);
+
+	const Tag* tag = tagItem->GetTag();
+	if (tag->Owners.Count() == 0) {return;}
+
+	QVector<QPair<QString, Note*> > sortedOwners;
+	sortedOwners.reserve(tag->Owners.Count());
+	for (int i = 0; i < tag->Owners.Count(); ++i) {
+		Note* note = tag->Owners.ItemAt(i);
+		sortedOwners.append(qMakePair(note->GetName().toUpper(), note));
+	}
+	std::sort(sortedOwners.begin(), sortedOwners.end());
+
+	beginInsertRows(parent, 0, sortedOwners.size() - 1);
+		for (int i = 0; i < sortedOwners.size(); ++i) {
+			tagItem->AddChild(createNoteItem(sortedOwners.at(i).second));
+		}
+	endInsertRows();
 }
 
 void TagsModel::sl_Tag_OwnerAdded(Note* note) {
+	if (bulkUpdate) {return;}
+
 	Tag* tag = qobject_cast<Tag*>(QObject::sender());
 
 	if (!tag) {
@@ -62,22 +216,25 @@ void TagsModel::sl_Tag_OwnerAdded(Note* note) {
 	}
 
 	BaseModelItem* tagItem = tagsBridge.value(tag);
+	QModelIndex tagIndex = createIndex(GetRootItem()->IndexOfChild(tagItem), 0, tagItem);
 
-	NoteModelItem* noteItem = new NoteModelItem(note);
-	QObject::connect(noteItem, SIGNAL(sg_DataChanged(BaseModelItem*)),
-					 this, SLOT(sl_Item_DataChanged(BaseModelItem*)));
+	// Owners of collapsed tag will be created when it is expanded
+	if (!populatedItems.contains(tagItem)) {
+		updateUnpopulatedTag(tag, tagIndex, true);
+		return;
+	}
 
-	QModelIndex tagIndex = createIndex(GetRootItem()->IndexOfChild(tagItem), 0, tagItem);
+	NoteModelItem* noteItem = createNoteItem(note);
 
 	int newPosition = tagItem->FindInsertIndex(noteItem);
 	beginInsertRows(tagIndex, newPosition, newPosition);
-		tagItem->AddChild(noteItem);
+		tagItem->AddChildTo(noteItem, newPosition);
 	endInsertRows();
-
-	notesBridge.insert(note, noteItem);
 }
 
 void TagsModel::sl_Tag_OwnerRemoved(Note* note) {
+	if (bulkUpdate) {return;}
+
 	Tag* tag = qobject_cast<Tag*>(QObject::sender());
 
 	if (!tag) {
@@ -91,6 +248,14 @@ void TagsModel::sl_Tag_OwnerRemoved(Note* note) {
 
 	BaseModelItem* tagItem = tagsBridge.value(tag);
 
+	BaseModelItem* root = GetRootItem();
+	QModelIndex tagIndex = createIndex(root->IndexOfChild(tagItem), 0, tagItem);
+
+	if (!populatedItems.contains(tagItem)) {
+		updateUnpopulatedTag(tag, tagIndex, false);
+		return;
+	}
+
 	// Searching for note item, that is a child of tagItem
 	BaseModelItem* noteItem = 0;
 	QList<BaseModelItem*> noteItems = notesBridge.values(note);
@@ -106,10 +271,6 @@ void TagsModel::sl_Tag_OwnerRemoved(Note* note) {
 		return;
 	}
 
-	BaseModelItem* root = GetRootItem();
-
-	QModelIndex tagIndex = createIndex(root->IndexOfChild(tagItem), 0, tagItem);
-
 	beginRemoveRows(tagIndex, tagItem->IndexOfChild(noteItem), tagItem->IndexOfChild(noteItem));
 		tagItem->RemoveChild(noteItem);
 	endRemoveRows();
@@ -120,6 +281,8 @@ void TagsModel::sl_Tag_OwnerRemoved(Note* note) {
 }
 
 void TagsModel::sl_Tag_OwnersRemoved() {
+	if (bulkUpdate) {return;}
+
 	Tag* tag = qobject_cast<Tag*>(QObject::sender());
 
 	if (!tag) {
@@ -131,26 +294,7 @@ void TagsModel::sl_Tag_OwnersRemoved() {
 		return;
 	}
 
-	BaseModelItem* tagItem = tagsBridge.value(tag);
-
-
-	BaseModelItem* root = GetRootItem();
-	QModelIndex tagIndex = createIndex(root->IndexOfChild(tagItem), 0, tagItem);
-
-	beginRemoveRows(tagIndex, 0, tagItem->ChildrenCount());
-		for (int i = 0; i < tagItem->ChildrenCount(); ++i) {
-			BaseModelItem* childItem = tagItem->ChildAt(i);
-			if (childItem->DataType() != BaseModelItem::note) {
-				WARNING("Item has wrong type");
-				continue;
-			}
-			NoteModelItem* noteItem = dynamic_cast<NoteModelItem*>(childItem);
-			Note* note = noteItem->GetStoredData();
-			notesBridge.remove(note, noteItem);
-			delete noteItem;
-		}
-		tagItem->ClearChildrenList();
-	endRemoveRows();
+	removeNoteItems(tagsBridge.value(tag));
 }
 
 void TagsModel::sl_Document_TagRegistered(Tag* tag) {
@@ -169,24 +313,13 @@ void TagsModel::sl_Document_TagRegistered(Tag* tag) {
 					 this, SLOT(sl_Tag_OwnerRemoved(Note*)));
 	QObject::connect(tag, SIGNAL(sg_OwnersRemoved()),
 					 this, SLOT(sl_Tag_OwnersRemoved()));
-	TagModelItem* item = new TagModelItem(tag);
-	item->SetSorted(true);
-	tagsBridge.insert(tag, item);
-
-	int newPosition = 0;
+	if (bulkUpdate) {return;} // item will be created when bulk update ends
 
-	for (int i = 0; i < tag->Owners.Count(); ++i) {
-		NoteModelItem* noteItem = new NoteModelItem(tag->Owners.ItemAt(i));
-		QObject::connect(noteItem, SIGNAL(sg_DataChanged(BaseModelItem*)),
-						 this, SLOT(sl_Item_DataChanged(BaseModelItem*)));
-		newPosition = item->FindInsertIndex(noteItem);
-		item->AddChildTo(noteItem, newPosition);
-		notesBridge.insert(tag->Owners.ItemAt(i), noteItem);
-	}
+	TagModelItem* item = createTagItem(tag);
 
 	BaseModelItem* root = GetRootItem();
 
-	newPosition = root->FindInsertIndex(item);//FindPositionForElement(root, item);
+	int newPosition = root->FindInsertIndex(item);
 
 	beginInsertRows(QModelIndex(), newPosition, newPosition);
 		root->AddChildTo(item, newPosition);
@@ -198,6 +331,10 @@ void TagsModel::sl_Document_TagUnregistered(Tag* tag) {
 		WARNING("Null pointer recieved");
 		return;
 	}
+	if (bulkUpdate) {
+		QObject::disconnect(tag, 0, this, 0);
+		return;
+	}
 	if (!tagsBridge.contains(tag)) {
 		WARNING("Item is not registered");
 		return;
@@ -211,6 +348,9 @@ void TagsModel::sl_Document_TagUnregistered(Tag* tag) {
 	TagModelItem* item = tagsBridge.value(tag);
 	tagsBridge.remove(tag);
 
+	removeNoteItems(item);
+	populatedItems.remove(item);
+
 	BaseModelItem* root = GetRootItem();
 
 	beginRemoveRows(QModelIndex(), root->IndexOfChild(item), root->IndexOfChild(item));
@@ -220,12 +360,17 @@ void TagsModel::sl_Document_TagUnregistered(Tag* tag) {
 	delete item;
 }
 
-void TagsModel::sl_Item_DataChanged(BaseModelItem* item) {
-	const BaseModelItem* parentItem = item->parent();
-	if (!parentItem) {
-		WARNING("Could not find item parent");
-		return;
+void TagsModel::sl_ChangeBus_ItemsChanged(const ItemChanges& changes) {
+	if (bulkUpdate) {return;}
+
+	QList<BaseModelItem*> changedItems;
+	for (ItemChanges::const_iterator it = changes.constBegin(); it != changes.constEnd(); ++it) {
+		if ((it.value() & ItemChangeBus::VisualChanges) == 0) {continue;}
+		if (it.key()->GetItemType() != AbstractFolderItem::Type_Note) {continue;}
+
+		// Note has an item under each of its tags
+		changedItems << notesBridge.values(static_cast<const Note*>(it.key()));
 	}
-	QModelIndex itemIndex = createIndex(parentItem->IndexOfChild(item), 0, item);
-	emit dataChanged(itemIndex, itemIndex);
+
+	EmitItemsDataChanged(changedItems);
 }
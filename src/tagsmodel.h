@@ -19,8 +19,10 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #define TAGSMODEL_H
 
 #include "basemodel.h"
+#include "itemchangebus.h"
 #include <QHash>
 #include <QMultiHash>
+#include <QSet>
 
 namespace qNotesManager {
 	class Tag;
@@ -34,10 +36,26 @@ namespace qNotesManager {
 	private:
 		QHash<const Tag*, TagModelItem*> tagsBridge;
 		QMultiHash<const Note*, BaseModelItem*> notesBridge;
+		Document* document;
+		bool bulkUpdate;
+		QSet<const BaseModelItem*> populatedItems; // tag items whose owners were created
+
+		TagModelItem* createTagItem(Tag*);
+		NoteModelItem* createNoteItem(Note*);
+		void removeNoteItems(BaseModelItem* tagItem);
+		void updateUnpopulatedTag(const Tag* tag, const QModelIndex& tagIndex, bool ownerAdded);
+		void rebuild();
 
 	public:
 		explicit TagsModel(Document*);
 
+		void BeginBulkUpdate();
+		void EndBulkUpdate();
+
+		/*virtual*/ bool hasChildren(const QModelIndex& parent = QModelIndex()) const;
+		/*virtual*/ bool canFetchMore(const QModelIndex& parent) const;
+		/*virtual*/ void fetchMore(const QModelIndex& parent);
+
 	private slots:
 		void sl_Tag_OwnerAdded(Note*);
 		void sl_Tag_OwnerRemoved(Note*);
@@ -46,7 +64,7 @@ namespace qNotesManager {
 		void sl_Document_TagRegistered(Tag*);
 		void sl_Document_TagUnregistered(Tag*);
 
-		void sl_Item_DataChanged(BaseModelItem*);
+		void sl_ChangeBus_ItemsChanged(const ItemChanges&);
 	};
 }
 
@@ -34,6 +34,7 @@ TagsNavigationWidget::TagsNavigationWidget(QWidget *parent) : QWidget(parent) {
 	model = 0;
 
 	treeView = new QTreeView();
+	treeView->setUniformRowHeights(true);
 	treeView->setHeaderHidden(true);
 	treeView->setEditTriggers(QAbstractItemView::SelectedClicked | QAbstractItemView::EditKeyPressed);
 
@@ -0,0 +1,240 @@
+/*
+This file is part of qNotesManager.
+
+qNotesManager is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+qNotesManager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tagssuffixindex.h"
+
+#include "global.h"
+
+#include <algorithm>
+
+using namespace qNotesManager;
+
+class TagsSuffixIndex::SuffixLessThan {
+private:
+	const QVector<QString>& lowerNames;
+public:
+	explicit SuffixLessThan(const QVector<QString>& n) : lowerNames(n) {}
+
+	bool operator()(const Suffix& left, const Suffix& right) const {
+		const QString& l = lowerNames.at(left.NameID);
+		const QString& r = lowerNames.at(right.NameID);
+		const int lLength = l.length() - left.Offset;
+		const int rLength = r.length() - right.Offset;
+		const QChar* lData = l.constData() + left.Offset;
+		const QChar* rData = r.constData() + right.Offset;
+
+		const int length = qMin(lLength, rLength);
+		for (int i = 0; i < length; ++i) {
+			if (lData[i] != rData[i]) {return lData[i] < rData[i];}
+		}
+		if (lLength != rLength) {return lLength < rLength;} // end of name is less than any character
+
+		// Equal suffixes of different names are ordered too, so every suffix has its own place
+		if (left.NameID != right.NameID) {return left.NameID < right.NameID;}
+		return left.Offset < right.Offset;
+	}
+};
+
+class TagsSuffixIndex::NameLessThan {
+private:
+	const QStringList& names;
+	const QVector<QString>& lowerNames;
+public:
+	NameLessThan(const QStringList& n, const QVector<QString>& l) : names(n), lowerNames(l) {}
+
+	bool operator()(int left, int right) const {
+		const int result = lowerNames.at(left).compare(lowerNames.at(right));
+		if (result != 0) {return result < 0;}
+		return names.at(left) < names.at(right); // names are unique
+	}
+};
+
+TagsSuffixIndex::TagsSuffixIndex() : queryStamp(0) {
+}
+
+// Registers name and returns its id, name is not put in sorted lists
+int TagsSuffixIndex::addName(const QString& name) {
+	int id = 0;
+	if (freeIDs.isEmpty()) {
+		id = names.size();
+		names.append(name);
+		lowerNames.append(name.toLower());
+		matchStamps.append(0);
+	} else {
+		id = freeIDs.takeLast();
+		names[id] = name;
+		lowerNames[id] = name.toLower();
+		matchStamps[id] = 0;
+	}
+	ids.insert(name, id);
+	return id;
+}
+
+void TagsSuffixIndex::AddName(const QString& name) {
+	if (ids.contains(name)) {
+		WARNING("Name is already in the index");
+		return;
+	}
+
+	const int id = addName(name);
+	const NameLessThan nameLessThan(names, lowerNames);
+	sortedIDs.insert(std::lower_bound(sortedIDs.begin(), sortedIDs.end(), id, nameLessThan), id);
+
+	const int length = lowerNames.at(id).length();
+	if (length < 2) {return;}
+
+	const SuffixLessThan lessThan(lowerNames);
+	QVector<Suffix> added;
+	added.reserve(length - 1);
+	for (int offset = 1; offset < length; ++offset) {
+		added.append(Suffix(id, offset));
+	}
+	std::sort(added.begin(), added.end(), lessThan);
+
+	QVector<Suffix> merged(suffixes.size() + added.size());
+	std::merge(suffixes.constBegin(), suffixes.constEnd(), added.constBegin(), added.constEnd(),
+			   merged.begin(), lessThan);
+	suffixes.swap(merged);
+}
+
+namespace {
+	class HasNameID {
+	private:
+		const int id;
+	public:
+		explicit HasNameID(int i) : id(i) {}
+		template <class T> bool operator()(const T& suffix) const {return suffix.NameID == id;}
+	};
+}
+
+void TagsSuffixIndex::RemoveName(const QString& name) {
+	if (!ids.contains(name)) {
+		WARNING("Name is not in the index");
+		return;
+	}
+
+	const int id = ids.take(name);
+	const NameLessThan nameLessThan(names, lowerNames);
+	QVector<int>::iterator it = std::lower_bound(sortedIDs.begin(), sortedIDs.end(), id, nameLessThan);
+	if (it != sortedIDs.end() && *it == id) {
+		sortedIDs.erase(it);
+	} else {
+		WARNING("Name is not in sorted list");
+	}
+
+	if (lowerNames.at(id).length() > 1) {
+		suffixes.erase(std::remove_if(suffixes.begin(), suffixes.end(), HasNameID(id)), suffixes.end());
+	}
+
+	names[id] = QString();
+	lowerNames[id] = QString();
+	freeIDs.append(id);
+}
+
+// Replaces all names and sorts all suffixes at once
+void TagsSuffixIndex::Rebuild(const QStringList& allNames) {
+	names.clear();
+	lowerNames.clear();
+	ids.clear();
+	freeIDs.clear();
+	sortedIDs.clear();
+	suffixes.clear();
+	matchStamps.clear();
+	queryStamp = 0;
+
+	foreach (const QString& name, allNames) {
+		if (ids.contains(name)) {continue;}
+		const int id = addName(name);
+		sortedIDs.append(id);
+		for (int offset = 1; offset < lowerNames.at(id).length(); ++offset) {
+			suffixes.append(Suffix(id, offset));
+		}
+	}
+	std::sort(sortedIDs.begin(), sortedIDs.end(), NameLessThan(names, lowerNames));
+	std::sort(suffixes.begin(), suffixes.end(), SuffixLessThan(lowerNames));
+}
+
+// Compares text of name starting at 'offset' with filter. Returns 0 if it starts with filter
+int TagsSuffixIndex::compareText(const QString& lowerName, int offset,
+								 const QString& lowerFilter) const {
+	for (int i = 0; i < lowerFilter.length(); ++i) {
+		if (offset + i == lowerName.length()) {return -1;} // end of name is less than any character
+		const QChar c = lowerName.at(offset + i);
+		if (c != lowerFilter.at(i)) {
+			return c < lowerFilter.at(i) ? -1 : 1;
+		}
+	}
+	return 0;
+}
+
+QStringList TagsSuffixIndex::Find(const QString& filter, int maxMatches) const {
+	QStringList result;
+	if (filter.isEmpty() || maxMatches <= 0) {return result;}
+
+	const QString lowerFilter = filter.toLower();
+	queryStamp++;
+
+	// Names that start with filter are a range of sorted names, already in order
+	int first = 0;
+	int last = sortedIDs.size();
+	while (first < last) {
+		const int middle = (first + last) / 2;
+		if (compareText(lowerNames.at(sortedIDs.at(middle)), 0, lowerFilter) < 0) {
+			first = middle + 1;
+		} else {
+			last = middle;
+		}
+	}
+	for (int i = first; i < sortedIDs.size(); ++i) {
+		const int id = sortedIDs.at(i);
+		if (compareText(lowerNames.at(id), 0, lowerFilter) != 0) {break;}
+		matchStamps[id] = queryStamp;
+		if (result.size() < maxMatches) {result.append(names.at(id));}
+	}
+	if (result.size() == maxMatches) {return result;}
+
+	// Names that contain filter further
+	first = 0;
+	last = suffixes.size();
+	while (first < last) {
+		const int middle = (first + last) / 2;
+		const Suffix& suffix = suffixes.at(middle);
+		if (compareText(lowerNames.at(suffix.NameID), suffix.Offset, lowerFilter) < 0) {
+			first = middle + 1;
+		} else {
+			last = middle;
+		}
+	}
+	QVector<int> otherMatches;
+	for (int i = first; i < suffixes.size(); ++i) {
+		const Suffix& suffix = suffixes.at(i);
+		if (compareText(lowerNames.at(suffix.NameID), suffix.Offset, lowerFilter) != 0) {break;}
+		if (matchStamps.at(suffix.NameID) == queryStamp) {continue;} // prefix match or found already
+		matchStamps[suffix.NameID] = queryStamp;
+		otherMatches.append(suffix.NameID);
+	}
+
+	// All matches are found before the best ones are taken, so the result does not depend on order
+	// of suffixes
+	const int count = qMin(otherMatches.size(), maxMatches - result.size());
+	std::partial_sort(otherMatches.begin(), otherMatches.begin() + count, otherMatches.end(),
+					  NameLessThan(names, lowerNames));
+	for (int i = 0; i < count; ++i) {
+		result.append(names.at(otherMatches.at(i)));
+	}
+	return result;
+}
@@ -0,0 +1,71 @@
+/*
+This file is part of qNotesManager.
+
+qNotesManager is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+qNotesManager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TAGSSUFFIXINDEX_H
+#define TAGSSUFFIXINDEX_H
+
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+
+/*
+  TagsSuffixIndex finds tag names that contain a string, ignoring case. Lower cased names are kept
+  sorted for prefix lookups, and a suffix array over the rest of their suffixes is used for matches
+  in the middle of names, so a query costs a binary search plus the number of matches. Suffixes of
+  an added name are sorted and merged into the array in one pass, removal is one pass too.
+*/
+
+namespace qNotesManager {
+	class TagsSuffixIndex {
+	private:
+		class Suffix {
+		public:
+			Suffix() : NameID(0), Offset(0) {}
+			Suffix(int id, int offset) : NameID(id), Offset(offset) {}
+			int NameID;
+			int Offset;
+		};
+		class SuffixLessThan;
+		class NameLessThan;
+
+		QStringList names;				// by id, freed ids hold null strings
+		QVector<QString> lowerNames;	// by id
+		QHash<QString, int> ids;
+		QVector<int> freeIDs;
+		QVector<int> sortedIDs;			// sorted by lower cased name, then by name
+		QVector<Suffix> suffixes;		// suffixes after the first character of every name, sorted
+										// by text of suffix, then by id and offset
+
+		mutable QVector<int> matchStamps;	// last query that matched each name
+		mutable int queryStamp;
+
+		int addName(const QString& name);
+		int compareText(const QString& lowerName, int offset, const QString& lowerFilter) const;
+
+	public:
+		TagsSuffixIndex();
+
+		void AddName(const QString& name);
+		void RemoveName(const QString& name);
+		void Rebuild(const QStringList& allNames);
+
+		// Names that start with filter go first, each group is sorted by lower cased name
+		QStringList Find(const QString& filter, int maxMatches) const;
+	};
+}
+
+#endif // TAGSSUFFIXINDEX_H
@@ -21,6 +21,9 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include "crc32.h"
 #include "global.h"
 #include "cachedimagefile.h"
+#include "imagestore.h"
+#include "imagedecoder.h"
+#include "imagecache.h"
 #include "idummyimagesprovider.h"
 
 #include <QFileInfo>
@@ -34,9 +37,12 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include <QPainter>
 #include <QBuffer>
 
+#include <algorithm>
+
 using namespace qNotesManager;
 
-TextDocument::TextDocument(QObject *parent) : QTextDocument(parent) {
+TextDocument::TextDocument(QObject *parent) : QTextDocument(parent), shown(false) {
+	indexedLength = characterCount();
 	loader = new ImageLoader(this);
 
 	QObject::connect(loader, SIGNAL(sg_DownloadError(QUrl,QString)),
@@ -51,6 +57,9 @@ TextDocument::TextDocument(QObject *parent) : QTextDocument(parent) {
 	QObject::connect(&restartDownloadsTimer, SIGNAL(timeout()),
 					 this, SLOT(sl_RestartDownloadsTimer_Timeout()));
 
+	QObject::connect(this, SIGNAL(contentsChange(int,int,int)),
+					 this, SLOT(sl_ContentsChange(int,int,int)));
+
 	QFont f;
 	f.setFamily("Arial");
 	f.setPointSize(9);
@@ -58,8 +67,10 @@ TextDocument::TextDocument(QObject *parent) : QTextDocument(parent) {
 }
 
 TextDocument::~TextDocument() {
-	foreach (const QString name, originalImages.keys()) {
-		delete originalImages[name];
+	ImageDecoder::I()->Cancel(this);
+	foreach (CachedImageFile* image, originalImages) {
+		if (shown) {ImageCache::I()->Unpin(image);}
+		ImageStore::I()->Release(image);
 	}
 	originalImages.clear();
 }
@@ -83,10 +94,11 @@ void TextDocument::sl_Downloader_DownloadFinished (QUrl url, CachedImageFile* im
 	}
 
 	QString name = image->GetMD5();
-	QUrl newUrl(name);
 	if (!originalImages.contains(name)) {
-		addResource(QTextDocument::ImageResource, newUrl, image->GetPixmap());
+		image = ImageStore::I()->Acquire(image);
 		originalImages.insert(name, image);
+		if (shown) {ImageCache::I()->Pin(image);}
+		requestDecode(name);
 	} else {
 		delete image;
 	}
@@ -104,7 +116,8 @@ void TextDocument::sl_Downloader_DownloadFinished (QUrl url, CachedImageFile* im
 void TextDocument::sl_Downloader_DownloadError (QUrl url, QString errorDescription) {
 	if (!errorDownloads.contains(url)) {
 		errorDownloads.append(url);
-		if (!restartDownloadsTimer.isActive()) {
+		// Otherwise loader retries it with increasing delay itself
+		if (!loader->RetriesFailedDownloads(url) && !restartDownloadsTimer.isActive()) {
 			restartDownloadsTimer.start();
 		}
 	}
@@ -131,8 +144,17 @@ QVariant TextDocument::loadResource (int type, const QUrl& url) {
 		QString stringUrl = url.toEncoded();
 		if (originalImages.contains(stringUrl)) {
 			CachedImageFile* image = originalImages[stringUrl];
-			addResource(QTextDocument::ImageResource, url, image->GetPixmap());
-			return image->GetPixmap();
+			if (image->IsDecoded()) {
+				addResource(QTextDocument::ImageResource, url, image->GetPixmap());
+				return image->GetPixmap();
+			}
+			// Show placeholder of the same size until the image is decoded in background
+			requestDecode(stringUrl);
+			QSize imageSize = findImageSize(stringUrl);
+			if (imageSize.width() <= 0 || imageSize.height() <= 0) {
+				imageSize = image->ImageSize();
+			}
+			return DummyImagesProvider->GetLoadingImage(imageSize);
 		}
 		QSize imageSize = findImageSize(url.toEncoded());
 		if (errorDownloads.contains(url)) {
@@ -151,30 +173,23 @@ QVariant TextDocument::loadResource (int type, const QUrl& url) {
 }
 
 void TextDocument::replaceImageUrl(const QUrl &oldName, const QString &newName) {
-	QList <QPair<int, int> > fragments;
-
-	QTextBlock block = begin();
-
-	while(block.isValid()) {
-		QTextBlock::iterator iterator;
-		for(iterator = block.begin(); !(iterator.atEnd()); ++iterator) {
-			QTextFragment fragment = iterator.fragment();
-			if(fragment.isValid() && fragment.charFormat().isImageFormat()) {
-				QTextImageFormat format = fragment.charFormat().toImageFormat();
-				if (QUrl::fromEncoded(format.name().toUtf8()) != oldName) {continue;}
-				fragments.append(QPair<int, int>(fragment.position(), fragment.length()));
-			}
+	QList<int> positions;
+
+	// Names are compared as urls, so only distinct names are checked, not every image character
+	QHash<QString, QList<int> >::const_iterator it = imagePositions.constBegin();
+	for (; it != imagePositions.constEnd(); ++it) {
+		if (QUrl::fromEncoded(it.key().toUtf8()) != oldName) {continue;}
+		foreach (int key, it.value()) {
+			positions.append(imagePosition(key));
 		}
-		block = block.next();
 	}
 
-
+	// Index is updated while formats are changed, so positions are collected first
 	QTextCursor cursor(this);
 	cursor.beginEditBlock();
-	QPair<int, int> pair;
-	foreach (pair, fragments) {
-		cursor.setPosition(pair.first);
-		cursor.movePosition(QTextCursor::Right, QTextCursor::KeepAnchor, pair.second);
+	foreach (int position, positions) {
+		cursor.setPosition(position);
+		cursor.movePosition(QTextCursor::Right, QTextCursor::KeepAnchor);
 		QTextImageFormat format = cursor.charFormat().toImageFormat();
 		format.setName(newName);
 		cursor.mergeCharFormat(format);
@@ -183,51 +198,120 @@ void TextDocument::replaceImageUrl(const QUrl &oldName, const QString &newName)
 }
 
 QSize TextDocument::findImageSize(const QString& resourceID) {
-	QTextBlock block = begin();
+	const QList<int> keys = imagePositions.value(resourceID);
+	if (keys.isEmpty()) {return QSize();}
+
+	const QTextImageFormat format = imageFragments.value(keys.first());
+	return QSize(format.width(), format.height());
+}
+
+QStringList TextDocument::GetImagesList() const {
+	QStringList returnList;
+
+	// Images are listed in order of their first appearance in the text. Keys of characters before
+	// the index split are not negative and sort after keys counted from document end
+	QMap<int, QString> firstPositions;
+	QHash<QString, QList<int> >::const_iterator it = imagePositions.constBegin();
+	for (; it != imagePositions.constEnd(); ++it) {
+		const QList<int>& keys = it.value();
+		QList<int>::const_iterator first = std::lower_bound(keys.constBegin(), keys.constEnd(), 0);
+		if (first == keys.constEnd()) {first = keys.constBegin();}
+		firstPositions.insert(imagePosition(*first), it.key());
+	}
+
+	foreach (const QString& imageName, firstPositions) {
+		if (!originalImages.contains(imageName)) {
+			qDebug() << "Image " << imageName << " not loaded. Skipping.";
+			continue;
+		}
+
+		returnList.append(imageName);
+	}
+
+	return returnList;
+}
+
+int TextDocument::imagePosition(int key) const {
+	return key >= 0 ? key : key + indexedLength;
+}
+
+// Makes characters before 'position' keyed by position and the rest keyed from document end
+void TextDocument::moveIndexSplit(int position) {
+	QList<QPair<int, QTextImageFormat> > moved;
+
+	QMap<int, QTextImageFormat>::iterator it = imageFragments.lowerBound(position);
+	while (it != imageFragments.end()) {
+		moved.append(qMakePair(it.key() - indexedLength, it.value()));
+		removeImageKey(it.key(), it.value());
+		it = imageFragments.erase(it);
+	}
+
+	const QMap<int, QTextImageFormat>::iterator end = imageFragments.lowerBound(position - indexedLength);
+	it = imageFragments.begin();
+	while (it != end) {
+		moved.append(qMakePair(it.key() + indexedLength, it.value()));
+		removeImageKey(it.key(), it.value());
+		it = imageFragments.erase(it);
+	}
+
+	for (int i = 0; i < moved.size(); ++i) {
+		imageFragments.insert(moved.at(i).first, moved.at(i).second);
+		addImageKey(moved.at(i).first, moved.at(i).second);
+	}
+}
+
+// Keeps index of image characters in sync with the text. Entries in changed range are rebuilt,
+// keys of entries after it stay valid as they are counted from document end
+void TextDocument::sl_ContentsChange(int position, int charsRemoved, int charsAdded) {
+	moveIndexSplit(position);
+
+	// Removed range may be reported longer than the document when whole content is replaced
+	QMap<int, QTextImageFormat>::iterator it = imageFragments.lowerBound(position - indexedLength);
+	const int removedEnd = qMin(position + charsRemoved - indexedLength, 0);
+	while (it != imageFragments.end() && it.key() < removedEnd) {
+		removeImageKey(it.key(), it.value());
+		it = imageFragments.erase(it);
+	}
+
+	indexedLength = characterCount();
+	indexImages(position, position + charsAdded);
+}
+
+// Adds image characters of changed range, they are after the index split
+void TextDocument::indexImages(int from, int to) {
+	QTextBlock block = findBlock(from);
 
-	while(block.isValid()) {
+	while(block.isValid() && block.position() < to) {
 		QTextBlock::iterator iterator;
 		for(iterator = block.begin(); !(iterator.atEnd()); ++iterator) {
 			QTextFragment fragment = iterator.fragment();
-			if(fragment.isValid() && fragment.charFormat().isImageFormat()) {
-				QTextImageFormat format = fragment.charFormat().toImageFormat();
-				if (format.name() == resourceID) {
-					return QSize(format.width(), format.height());
-				}
+			if(!fragment.isValid() || !fragment.charFormat().isImageFormat()) {continue;}
+
+			const QTextImageFormat format = fragment.charFormat().toImageFormat();
+			const int end = qMin(fragment.position() + fragment.length(), to);
+			for (int p = qMax(fragment.position(), from); p < end; ++p) {
+				imageFragments.insert(p - indexedLength, format);
+				addImageKey(p - indexedLength, format);
 			}
 		}
 		block = block.next();
 	}
-	return QSize();
 }
 
-QStringList TextDocument::GetImagesList() const {
-	QStringList returnSet;
-
-	QTextBlock block = begin();
-	while(block.isValid()) {
-		QTextBlock::iterator it;
-		for(it = block.begin(); !(it.atEnd()); ++it) {
-			const QTextFragment currentFragment = it.fragment();
-			if(!currentFragment.isValid()) {continue;}
-			if(!currentFragment.charFormat().isImageFormat()) {continue;}
-
-			QTextImageFormat format = currentFragment.charFormat().toImageFormat();
-			const QString imageName = QString(format.name().toUtf8());
-			if (returnSet.contains(imageName)) {continue;}
-
-			if (!originalImages.contains(imageName)) {
-				qDebug() << "Image " << imageName << " not loaded. Skipping.";
-				continue;
-			}
-
-			returnSet.append(imageName);
+void TextDocument::addImageKey(int key, const QTextImageFormat& format) {
+	QList<int>& keys = imagePositions[format.name()];
+	QList<int>::iterator it = std::lower_bound(keys.begin(), keys.end(), key);
+	if (it == keys.end() || *it != key) {keys.insert(it, key);}
+}
 
-		}
-		block = block.next();
-	}
+void TextDocument::removeImageKey(int key, const QTextImageFormat& format) {
+	QHash<QString, QList<int> >::iterator entry = imagePositions.find(format.name());
+	if (entry == imagePositions.end()) {return;}
 
-	return returnSet;
+	QList<int>& keys = entry.value();
+	QList<int>::iterator it = std::lower_bound(keys.begin(), keys.end(), key);
+	if (it != keys.end() && *it == key) {keys.erase(it);}
+	if (keys.isEmpty()) {imagePositions.erase(entry);}
 }
 
 QStringList TextDocument:: GetResourceImagesList() const {
@@ -246,11 +330,104 @@ void TextDocument::sl_RestartDownloadsTimer_Timeout() {
 	}
 }
 
+void TextDocument::requestDecode(const QString& name) {
+	if (pendingDecodes.contains(name)) {return;}
+
+	CachedImageFile* image = originalImages.value(name);
+	if (!image || image->IsDecoded()) {return;}
+
+	pendingDecodes.insert(name);
+	ImageDecoder::I()->Decode(image, this);
+}
+
+// Starts decoding of the first few images after 'position', so images just below the viewport are
+// ready when the text is scrolled
+void TextDocument::DecodeImagesAfter(int position) {
+	int found = 0;
+
+	// Characters keyed by position go first in the text, characters keyed from the end follow them
+	for (int pass = 0; pass < 2 && found < DecodeAheadCount; ++pass) {
+		QMap<int, QTextImageFormat>::const_iterator it = (pass == 0) ?
+				imageFragments.lowerBound(position) : imageFragments.lowerBound(position - indexedLength);
+		const QMap<int, QTextImageFormat>::const_iterator end = (pass == 0) ?
+				imageFragments.constEnd() : imageFragments.lowerBound(0);
+		for (; it != end && found < DecodeAheadCount; ++it) {
+			const QString imageName = it.value().name();
+			if (!originalImages.contains(imageName)) {continue;}
+
+			requestDecode(imageName);
+			found++;
+		}
+	}
+}
+
+// Images between 'from' and 'to' positions are shown in viewport, they are downloaded first
+void TextDocument::PrioritizeDownloads(int from, int to) {
+	if (activeDownloads.isEmpty()) {return;}
+
+	for (int pass = 0; pass < 2; ++pass) {
+		QMap<int, QTextImageFormat>::const_iterator it = (pass == 0) ?
+				imageFragments.lowerBound(from) : imageFragments.lowerBound(from - indexedLength);
+		const QMap<int, QTextImageFormat>::const_iterator end = (pass == 0) ?
+				imageFragments.constEnd() : imageFragments.lowerBound(0);
+		for (; it != end && imagePosition(it.key()) <= to; ++it) {
+			const QUrl url = QUrl::fromEncoded(it.value().name().toUtf8());
+			if (activeDownloads.contains(url)) {
+				loader->Prioritize(url);
+			}
+		}
+	}
+}
+
+void TextDocument::sl_ImageDecoder_ImageDecoded(const QString& name, const QImage& decodedImage) {
+	if (!pendingDecodes.remove(name)) {return;}
+
+	CachedImageFile* image = originalImages.value(name);
+	if (!image) {return;}
+
+	image->SetDecodedImage(decodedImage); // image may be shared with another note and be set already
+	const QPixmap pixmap = image->GetPixmap();
+	if (pixmap.isNull()) {
+		addResource(QTextDocument::ImageResource, QUrl(name),
+					DummyImagesProvider->GetErrorImage(findImageSize(name)));
+	} else {
+		addResource(QTextDocument::ImageResource, QUrl(name), pixmap);
+	}
+
+	emit sg_NeedRelayout();
+}
+
 CachedImageFile* TextDocument::GetResourceImage(QString name) const {
 	return originalImages.contains(name) ? originalImages.value(name) : 0;
 }
 
+// Takes ownership of image. Image may be deleted, if the same one is already known
 void TextDocument::AddResourceImage(CachedImageFile* image) {
 	QString md5 = image->GetMD5();
+	if (originalImages.contains(md5)) {
+		if (originalImages.value(md5) != image) {
+			delete image;
+		}
+		return;
+	}
+	image = ImageStore::I()->Acquire(image);
 	originalImages.insert(md5, image);
+	if (shown) {ImageCache::I()->Pin(image);}
+}
+
+// While document is shown in editor its decoded images are pinned in ImageCache. When it is hidden,
+// document forgets pixmaps it holds as resources, so the cache may drop them to free memory
+void TextDocument::SetShown(bool s) {
+	if (shown == s) {return;}
+	shown = s;
+
+	QHash<QString, CachedImageFile*>::const_iterator it = originalImages.constBegin();
+	for (; it != originalImages.constEnd(); ++it) {
+		if (shown) {
+			ImageCache::I()->Pin(it.value());
+		} else {
+			addResource(QTextDocument::ImageResource, QUrl(it.key()), QVariant());
+			ImageCache::I()->Unpin(it.value());
+		}
+	}
 }
@@ -23,9 +23,12 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include <QImage>
 #include <QVariant>
 #include <QMap>
+#include <QTextImageFormat>
 #include <QQueue>
 #include <QPixmap>
 #include <QTimer>
+#include <QSet>
+#include <QHash>
 
 namespace qNotesManager {
 	class ImageLoader;
@@ -43,10 +46,28 @@ namespace qNotesManager {
 		void replaceImageUrl(const QUrl& oldName, const QString& newName);
 		QSize findImageSize(const QString& resourceID);
 
+		// Index of image characters. Characters before the last edited position are keyed by their
+		// position, characters after it by (position - document length), which does not change when
+		// text before them is edited. Only keys between old and new edited positions are changed
+		QMap<int, QTextImageFormat> imageFragments; // key of every image character -> its format
+		QHash<QString, QList<int> > imagePositions; // image name -> sorted keys of its characters
+		int indexedLength; // document length the keys are computed for
+		int imagePosition(int key) const;
+		void moveIndexSplit(int position);
+		void indexImages(int from, int to);
+		void addImageKey(int key, const QTextImageFormat& format);
+		void removeImageKey(int key, const QTextImageFormat& format);
+
 		QTimer restartDownloadsTimer;
 
 		QHash<QString, CachedImageFile*> originalImages;
 
+		QSet<QString> pendingDecodes;
+		void requestDecode(const QString& name);
+		static const int DecodeAheadCount = 3;
+
+		bool shown;
+
 	public:
 		explicit TextDocument(QObject *parent = 0);
 		~TextDocument();
@@ -57,6 +78,10 @@ namespace qNotesManager {
 		void AddResourceImage(CachedImageFile*);
 		QStringList GetResourceImagesList() const;
 
+		void DecodeImagesAfter(int position);
+		void PrioritizeDownloads(int from, int to);
+		void SetShown(bool);
+
 		IDummyImagesProvider* DummyImagesProvider;
 
 	protected:
@@ -73,6 +98,9 @@ namespace qNotesManager {
 
 		void sl_RestartDownloadsTimer_Timeout();
 
+		void sl_ContentsChange(int position, int charsRemoved, int charsAdded);
+		void sl_ImageDecoder_ImageDecoded(const QString& name, const QImage& decodedImage);
+
 	};
 }
 
@@ -43,6 +43,7 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include <QDesktopServices>
 #include "cachedimagefile.h"
 #include <QBuffer>
+#include <QScrollBar>
 
 
 using namespace qNotesManager;
@@ -124,6 +125,13 @@ TextEdit::TextEdit(QWidget *parent) :
 
 	imagePropertiesMenu->addAction(saveImageAction);
 	imagePropertiesMenu->addAction(resizeImageAction);
+
+	QObject::connect(verticalScrollBar(), SIGNAL(valueChanged(int)),
+					 this, SLOT(sl_VerticalScrollBar_ValueChanged()));
+}
+
+TextEdit::~TextEdit() {
+	if (shownDocument) {shownDocument->SetShown(false);}
 }
 
 void TextEdit::SetDocument(TextDocument* newDocument) {
@@ -139,7 +147,24 @@ void TextEdit::SetDocument(TextDocument* newDocument) {
 	QObject::connect(newDocument, SIGNAL(sg_NeedRelayout()),
 					 this, SLOT(sl_Document_NeedRelayout()));
 
+	if (shownDocument) {shownDocument->SetShown(false);}
+	shownDocument = newDocument;
+	if (shownDocument) {shownDocument->SetShown(true);}
+
 	QTextEdit::setDocument(newDocument);
+	updateViewportImages();
+}
+
+// Images in viewport are downloaded first, images that are about to be scrolled into view are
+// decoded ahead
+void TextEdit::updateViewportImages() {
+	TextDocument* d = qobject_cast<TextDocument*>(document());
+	if (d == 0) {return;}
+
+	const int top = cursorForPosition(QPoint(0, 0)).position();
+	const int bottom = cursorForPosition(QPoint(viewport()->width() - 1, viewport()->height() - 1)).position();
+	d->PrioritizeDownloads(top, bottom);
+	d->DecodeImagesAfter(bottom);
 }
 
 //virtual
@@ -606,6 +631,10 @@ void TextEdit::sl_Document_NeedRelayout() {
 	setLineWrapColumnOrWidth (0);
 }
 
+void TextEdit::sl_VerticalScrollBar_ValueChanged() {
+	updateViewportImages();
+}
+
 void TextEdit::sl_FollowLinkAction_Triggereed() {
 	QAction* act = qobject_cast<QAction*>(QObject::sender());
 	QPoint pos = act->data().toPoint();
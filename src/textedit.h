@@ -24,6 +24,7 @@ along with qNotesManager. If not, see <http://www.gnu.org/licenses/>.
 #include <QUrl>
 #include <QTextFragment>
 #include <QTimer>
+#include <QPointer>
 
 /*
   This is class inherited from QTextEdit, it handles text appearing and all the stuff about it
@@ -37,6 +38,7 @@ namespace qNotesManager {
 	Q_OBJECT
 	public:
 		explicit TextEdit(QWidget *parent = 0);
+		~TextEdit();
 
 		void SetDocument(TextDocument*);
 
@@ -106,9 +108,12 @@ namespace qNotesManager {
 
 		QTextFormat formatToCopy;
 
+		QPointer<TextDocument> shownDocument;
+
 		QTextFragment findFragmentAtPos(QPoint pos);
 		void applyCharFormatting(const QTextCharFormat& format, const CharFormatApplyMode = Merge);
 		void insertImageFromFile(QString fileName);
+		void updateViewportImages();
 
 		void setDocument(QTextDocument*) {} // hide inherited function
 
@@ -121,6 +126,7 @@ namespace qNotesManager {
 		void sl_currentCharFormatChanged (const QTextCharFormat& f);
 		void sl_Document_contentsChange (int position, int charsRemoved, int charsAdded);
 		void sl_Document_NeedRelayout();
+		void sl_VerticalScrollBar_ValueChanged();
 
 		void sl_FollowLinkAction_Triggereed();
 		void sl_RemoveLinkAction_Triggered();